@@ -0,0 +1,26 @@
+#include <stdlib.h>
+namespace {
+struct BenchContext {};
+void* Allocate(const tote::SizeType size, const uint32_t alignment, BenchContext*) {
+#ifdef _MSC_VER
+  return _aligned_malloc(size, alignment);
+#else
+  return aligned_alloc(alignment, size);
+#endif
+}
+void Deallocate(void* ptr, BenchContext*) {
+#ifdef _MSC_VER
+  _aligned_free(ptr);
+#else
+  free(ptr);
+#endif
+}
+tote::AllocatorCallbacks<BenchContext> GetAllocatorCallbacks() {
+  static BenchContext context{};
+  return {
+    .allocate = Allocate,
+    .deallocate = Deallocate,
+    .user_context = &context,
+  };
+}
+} // namespace
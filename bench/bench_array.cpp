@@ -0,0 +1,53 @@
+#include <stdint.h>
+#include <vector>
+#include "tote/array.h"
+#include "bench_alloc.inl"
+#include <benchmark/benchmark.h>
+namespace {
+constexpr int64_t kMinSize = 10;
+constexpr int64_t kMaxSize = 10'000'000;
+class ToteArray {
+ public:
+  explicit ToteArray(const uint32_t capacity) : array_(GetAllocatorCallbacks(), 0, capacity) {}
+  void push_back(const uint64_t value) { array_.push_back(value); }
+  uint64_t* data() { return array_.begin(); }
+ private:
+  tote::ResizableArray<uint64_t, BenchContext> array_;
+};
+class StdVector {
+ public:
+  explicit StdVector(const uint32_t capacity) { vector_.reserve(capacity); }
+  void push_back(const uint64_t value) { vector_.push_back(value); }
+  uint64_t* data() { return vector_.data(); }
+ private:
+  std::vector<uint64_t> vector_;
+};
+template <typename Array>
+void BM_ArrayPushBack(benchmark::State& state) {
+  const auto n = static_cast<uint32_t>(state.range(0));
+  for (auto _ : state) {
+    Array array(n);
+    for (uint32_t i = 0; i < n; i++) {
+      array.push_back(i);
+    }
+    benchmark::DoNotOptimize(array.data());
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+}
+template <typename Array>
+void BM_ArrayGrowth(benchmark::State& state) {
+  const auto n = static_cast<uint32_t>(state.range(0));
+  for (auto _ : state) {
+    Array array(0);
+    for (uint32_t i = 0; i < n; i++) {
+      array.push_back(i);
+    }
+    benchmark::DoNotOptimize(array.data());
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+}
+} // namespace
+BENCHMARK_TEMPLATE(BM_ArrayPushBack, StdVector)->RangeMultiplier(10)->Range(kMinSize, kMaxSize);
+BENCHMARK_TEMPLATE(BM_ArrayPushBack, ToteArray)->RangeMultiplier(10)->Range(kMinSize, kMaxSize);
+BENCHMARK_TEMPLATE(BM_ArrayGrowth, StdVector)->RangeMultiplier(10)->Range(kMinSize, kMaxSize);
+BENCHMARK_TEMPLATE(BM_ArrayGrowth, ToteArray)->RangeMultiplier(10)->Range(kMinSize, kMaxSize);
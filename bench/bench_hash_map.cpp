@@ -0,0 +1,225 @@
+#include <stdint.h>
+#include <unordered_map>
+#include <vector>
+#include "tote/hash_map.h"
+#include "tote/robin_hood_hash_map.h"
+#include "tote/swiss_hash_map.h"
+#include "bench_alloc.inl"
+#include <benchmark/benchmark.h>
+namespace {
+constexpr int64_t kMinSize = 10;
+constexpr int64_t kMaxSize = 10'000'000;
+/**
+ * key distributions, each maps an index to a unique key.
+ **/
+struct SequentialKeys {
+  static uint64_t Get(const uint64_t i) { return i; }
+};
+struct UniformKeys {
+  static uint64_t Get(const uint64_t i) { return tote::MixHash(i); } // bijective, so keys never collide.
+};
+struct StridedKeys {
+  static uint64_t Get(const uint64_t i) { return i << 12; } // low bits are all zero.
+};
+template <typename Keys>
+std::vector<uint64_t> MakeKeys(const uint64_t begin, const uint32_t count) {
+  std::vector<uint64_t> keys(count);
+  for (uint32_t i = 0; i < count; i++) {
+    keys[i] = Keys::Get(begin + i);
+  }
+  return keys;
+}
+/**
+ * adapters giving every map the same interface.
+ **/
+template <typename M>
+class ToteMap {
+ public:
+  void reserve(const uint32_t n) { map_.reserve(n); }
+  void insert(const uint64_t key, const uint64_t value) { map_.insert(key, value); }
+  const uint64_t* find(const uint64_t key) const { return map_.find(key); }
+  void erase(const uint64_t key) { map_.erase(key); }
+  uint64_t sum() const {
+    uint64_t sum = 0;
+    map_.for_each([&](const uint64_t&, const uint64_t& value) { sum += value; });
+    return sum;
+  }
+ private:
+  M map_{GetAllocatorCallbacks()};
+};
+using PrimeHashMap = ToteMap<tote::HashMap<uint64_t, uint64_t, BenchContext>>;
+using PowerOfTwoHashMap = ToteMap<tote::HashMap<uint64_t, uint64_t, BenchContext, tote::PowerOfTwoCapacity>>;
+using SwissHashMap = ToteMap<tote::SwissHashMap<uint64_t, uint64_t, BenchContext>>;
+using RobinHoodHashMap = ToteMap<tote::RobinHoodHashMap<uint64_t, uint64_t, BenchContext>>;
+class StdUnorderedMap {
+ public:
+  void reserve(const uint32_t n) { map_.reserve(n); }
+  void insert(const uint64_t key, const uint64_t value) { map_.insert_or_assign(key, value); }
+  const uint64_t* find(const uint64_t key) const {
+    const auto it = map_.find(key);
+    return it != map_.end() ? &it->second : nullptr;
+  }
+  void erase(const uint64_t key) { map_.erase(key); }
+  uint64_t sum() const {
+    uint64_t sum = 0;
+    for (const auto& [key, value] : map_) {
+      sum += value;
+    }
+    return sum;
+  }
+ private:
+  std::unordered_map<uint64_t, uint64_t> map_;
+};
+template <typename Map>
+void Fill(Map* map, const std::vector<uint64_t>& keys) {
+  for (const auto key : keys) {
+    map->insert(key, key);
+  }
+}
+template <typename Map, typename Keys>
+void BM_HashMapInsert(benchmark::State& state) {
+  const auto n = static_cast<uint32_t>(state.range(0));
+  const auto keys = MakeKeys<Keys>(0, n);
+  for (auto _ : state) {
+    Map map;
+    map.reserve(n);
+    Fill(&map, keys);
+    benchmark::DoNotOptimize(map);
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+}
+template <typename Map, typename Keys>
+void BM_HashMapGrowth(benchmark::State& state) {
+  const auto n = static_cast<uint32_t>(state.range(0));
+  const auto keys = MakeKeys<Keys>(0, n);
+  for (auto _ : state) {
+    Map map;
+    Fill(&map, keys);
+    benchmark::DoNotOptimize(map);
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+}
+template <typename Map, typename Keys>
+void BM_HashMapFindHit(benchmark::State& state) {
+  const auto n = static_cast<uint32_t>(state.range(0));
+  const auto keys = MakeKeys<Keys>(0, n);
+  Map map;
+  Fill(&map, keys);
+  for (auto _ : state) {
+    for (const auto key : keys) {
+      benchmark::DoNotOptimize(map.find(key));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+}
+template <typename Map, typename Keys>
+void BM_HashMapFindMiss(benchmark::State& state) {
+  const auto n = static_cast<uint32_t>(state.range(0));
+  const auto missing_keys = MakeKeys<Keys>(n, n);
+  Map map;
+  Fill(&map, MakeKeys<Keys>(0, n));
+  for (auto _ : state) {
+    for (const auto key : missing_keys) {
+      benchmark::DoNotOptimize(map.find(key));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+}
+template <typename Map, typename Keys>
+void BM_HashMapChurn(benchmark::State& state) {
+  // slides a window of n live keys, erasing the oldest key per insertion.
+  const auto n = static_cast<uint32_t>(state.range(0));
+  Map map;
+  Fill(&map, MakeKeys<Keys>(0, n));
+  uint64_t oldest = 0;
+  for (auto _ : state) {
+    for (uint32_t i = 0; i < n; i++) {
+      map.erase(Keys::Get(oldest));
+      map.insert(Keys::Get(oldest + n), oldest);
+      oldest++;
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * n * 2);
+}
+template <typename Map, typename Keys>
+void BM_HashMapIterate(benchmark::State& state) {
+  const auto n = static_cast<uint32_t>(state.range(0));
+  Map map;
+  Fill(&map, MakeKeys<Keys>(0, n));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(map.sum());
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+}
+/**
+ * insert_bulk into an empty map with the given number of threads, zero for the serial version.
+ **/
+template <typename Keys>
+void BM_HashMapBulkBuild(benchmark::State& state) {
+  const auto n = static_cast<uint32_t>(state.range(0));
+  const auto thread_num = static_cast<uint32_t>(state.range(1));
+  const auto keys = MakeKeys<Keys>(0, n);
+  tote::ThreadTaskDispatcher dispatcher(thread_num > 0 ? thread_num : 1);
+  for (auto _ : state) {
+    tote::HashMap<uint64_t, uint64_t, BenchContext> map(GetAllocatorCallbacks());
+    if (thread_num > 0) {
+      map.insert_bulk(keys.data(), keys.data(), n, dispatcher.callbacks());
+    } else {
+      map.insert_bulk(keys.data(), keys.data(), n);
+    }
+    benchmark::DoNotOptimize(map);
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+}
+/**
+ * resolves a frame of random hit keys one find at a time (prefetch distance -1)
+ * or with find_batch at the given prefetch distance.
+ * tables from 1M entries exceed typical last level caches.
+ **/
+void BM_HashMapFindBatch(benchmark::State& state) {
+  constexpr uint32_t kFrameSize = 4096;
+  const auto n = static_cast<uint32_t>(state.range(0));
+  const auto prefetch_distance = state.range(1);
+  const auto keys = MakeKeys<UniformKeys>(0, n);
+  tote::HashMap<uint64_t, uint64_t, BenchContext> map(GetAllocatorCallbacks());
+  map.insert_bulk(keys.data(), keys.data(), n);
+  std::vector<uint64_t> frame_keys(kFrameSize);
+  std::vector<const uint64_t*> values(kFrameSize);
+  uint64_t seed = 0;
+  for (auto _ : state) {
+    state.PauseTiming();
+    for (auto& key : frame_keys) {
+      key = keys[tote::MixHash(seed++) % n];
+    }
+    state.ResumeTiming();
+    if (prefetch_distance < 0) {
+      for (uint32_t i = 0; i < kFrameSize; i++) {
+        values[i] = map.find(frame_keys[i]);
+      }
+    } else {
+      static_cast<const decltype(map)&>(map).find_batch(frame_keys.data(), kFrameSize, values.data(), static_cast<uint32_t>(prefetch_distance));
+    }
+    benchmark::DoNotOptimize(values.data());
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * kFrameSize);
+}
+} // namespace
+#define TOTE_BENCH_KEYS(func, map)                                                              \
+  BENCHMARK_TEMPLATE(func, map, SequentialKeys)->RangeMultiplier(10)->Range(kMinSize, kMaxSize); \
+  BENCHMARK_TEMPLATE(func, map, UniformKeys)->RangeMultiplier(10)->Range(kMinSize, kMaxSize);    \
+  BENCHMARK_TEMPLATE(func, map, StridedKeys)->RangeMultiplier(10)->Range(kMinSize, kMaxSize)
+#define TOTE_BENCH_MAPS(func)              \
+  TOTE_BENCH_KEYS(func, StdUnorderedMap);   \
+  TOTE_BENCH_KEYS(func, PrimeHashMap);      \
+  TOTE_BENCH_KEYS(func, PowerOfTwoHashMap); \
+  TOTE_BENCH_KEYS(func, SwissHashMap);      \
+  TOTE_BENCH_KEYS(func, RobinHoodHashMap)
+TOTE_BENCH_MAPS(BM_HashMapInsert);
+TOTE_BENCH_MAPS(BM_HashMapGrowth);
+TOTE_BENCH_MAPS(BM_HashMapFindHit);
+TOTE_BENCH_MAPS(BM_HashMapFindMiss);
+TOTE_BENCH_MAPS(BM_HashMapChurn);
+TOTE_BENCH_MAPS(BM_HashMapIterate);
+BENCHMARK_TEMPLATE(BM_HashMapBulkBuild, UniformKeys)->ArgsProduct({{100'000, kMaxSize}, {0, 1, 2, 4, 8}})->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_HashMapFindBatch)->ArgsProduct({{10'000, 1'000'000, kMaxSize}, {-1, 0, 8, 16, 32}});
@@ -1,11 +1,38 @@
 #pragma once
+#include <stdint.h>
+#include <stdlib.h>
 namespace tote{
+/**
+ * type of allocation sizes and of sizes and capacities of arrays.
+ * 32-bit by default, TOTE_ENABLE_64BIT_SIZE widens it for buffers of 4 GB or more.
+ * must be defined the same in all translation units.
+ **/
+#ifdef TOTE_ENABLE_64BIT_SIZE
+using SizeType = uint64_t;
+#else
+using SizeType = uint32_t;
+#endif
+constexpr SizeType kMaxSize = ~SizeType{};
+/**
+ * byte size of count elements of element_size.
+ * aborts when it does not fit in SizeType rather than allocating a wrapped size.
+ **/
+constexpr SizeType GetAllocationSize(const uint64_t count, const uint64_t element_size) {
+  if (element_size != 0 && count > kMaxSize / element_size) { abort(); }
+  return static_cast<SizeType>(count * element_size);
+}
 template <typename T>
 struct AllocatorCallbacks {
-  using AllocateFunction = void*(const uint32_t size, const uint32_t alignment, T* user_context);
+  using AllocateFunction = void*(const SizeType size, const uint32_t alignment, T* user_context);
   using DeallocateFunction = void(void*, T* user_context);
+  /**
+   * optional, grow or shrink ptr to new_size keeping its first old_size bytes.
+   * may return ptr itself when resized in place, or nullptr leaving ptr intact on failure.
+   **/
+  using ReallocateFunction = void*(void* ptr, const SizeType old_size, const SizeType new_size, const uint32_t alignment, T* user_context);
   AllocateFunction*   allocate;
   DeallocateFunction* deallocate;
   T* user_context;
+  ReallocateFunction* reallocate{nullptr};
 };
 }
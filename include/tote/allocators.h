@@ -0,0 +1,123 @@
+#pragma once
+#include <stdint.h>
+#include "allocator_callbacks.h"
+namespace tote {
+struct AllocatorStatistics {
+  uint64_t live_bytes;
+  uint64_t peak_bytes;
+  uint32_t allocation_count;
+  uint32_t deallocation_count;
+};
+/**
+ * bump allocator over a caller provided buffer.
+ * deallocate does not reclaim memory, reset() releases everything in O(1).
+ * suits per-frame containers.
+ **/
+class LinearAllocator final {
+ public:
+  LinearAllocator(void* buffer, const uint32_t size);
+  void* allocate(const uint32_t size, const uint32_t alignment);
+  void deallocate(void*);
+  /**
+   * grows the last allocation in place, fails otherwise.
+   **/
+  void* reallocate(void* ptr, const uint32_t old_size, const uint32_t new_size);
+  void reset();
+  constexpr uint32_t used() const { return used_; }
+  constexpr uint32_t capacity() const { return size_; }
+  constexpr const AllocatorStatistics& statistics() const { return statistics_; }
+  AllocatorCallbacks<LinearAllocator> callbacks();
+ private:
+  uint8_t* buffer_;
+  uint32_t size_;
+  uint32_t used_{};
+  uint32_t last_offset_{};
+  AllocatorStatistics statistics_{};
+  LinearAllocator() = delete;
+  LinearAllocator(const LinearAllocator&) = delete;
+  void operator=(const LinearAllocator&) = delete;
+};
+/**
+ * fixed size block allocator over a caller provided buffer.
+ * allocation larger than block size or alignment fails with nullptr.
+ **/
+class PoolAllocator final {
+ public:
+  PoolAllocator(void* buffer, const uint32_t size, const uint32_t block_size, const uint32_t block_alignment = 16);
+  void* allocate(const uint32_t size, const uint32_t alignment);
+  void deallocate(void*);
+  void* reallocate(void* ptr, const uint32_t old_size, const uint32_t new_size);
+  constexpr uint32_t block_size() const { return block_size_; }
+  constexpr uint32_t block_num() const { return block_num_; }
+  constexpr uint32_t free_block_num() const { return free_block_num_; }
+  constexpr const AllocatorStatistics& statistics() const { return statistics_; }
+  AllocatorCallbacks<PoolAllocator> callbacks();
+ private:
+  struct FreeBlock {
+    FreeBlock* next;
+  };
+  FreeBlock* free_list_{};
+  uint32_t block_size_;
+  uint32_t block_alignment_;
+  uint32_t block_num_{};
+  uint32_t free_block_num_{};
+  AllocatorStatistics statistics_{};
+  PoolAllocator() = delete;
+  PoolAllocator(const PoolAllocator&) = delete;
+  void operator=(const PoolAllocator&) = delete;
+};
+/**
+ * general purpose allocator over a caller provided buffer
+ * with O(1) allocate and deallocate using two-level segregated fit (TLSF).
+ * adjacent free blocks are merged on deallocation.
+ **/
+class TlsfAllocator final {
+ public:
+  TlsfAllocator(void* buffer, const uint32_t size);
+  void* allocate(const uint32_t size, const uint32_t alignment);
+  void deallocate(void*);
+  /**
+   * grows in place by absorbing the following free block, fails otherwise.
+   **/
+  void* reallocate(void* ptr, const uint32_t old_size, const uint32_t new_size);
+  constexpr const AllocatorStatistics& statistics() const { return statistics_; }
+  AllocatorCallbacks<TlsfAllocator> callbacks();
+  static constexpr uint32_t kAlignment = 16;
+ private:
+  static constexpr uint32_t kSlIndexCountLog2 = 4;
+  static constexpr uint32_t kSlIndexCount = 1 << kSlIndexCountLog2;
+  static constexpr uint32_t kFlIndexShift = kSlIndexCountLog2 + 4; // log2(kAlignment)
+  static constexpr uint32_t kFlIndexCount = 32 - kFlIndexShift + 1;
+  static constexpr uint32_t kSmallBlockSize = 1 << kFlIndexShift;
+  struct Block {
+    Block* prev_physical; // valid only when previous block is free.
+    uint32_t size; // size of data following the header.
+    uint32_t flags;
+    Block* next_free; // in data area, valid only when free.
+    Block* prev_free;
+  };
+  static constexpr uint32_t kHeaderSize = 16;
+  static constexpr uint32_t kMinBlockSize = 16; // holds next_free and prev_free.
+  static_assert(sizeof(Block) <= kHeaderSize + kMinBlockSize);
+  static uint8_t* get_data(Block*);
+  static Block* get_block(void* data);
+  static Block* get_next_physical(Block*);
+  static void mark_free(Block*);
+  static void mark_used(Block*);
+  static void get_list_index(const uint32_t size, uint32_t* fl, uint32_t* sl);
+  void insert_free_block(Block*);
+  void remove_free_block(Block*);
+  Block* find_free_block(const uint32_t size);
+  Block* split(Block*, const uint32_t size);
+  Block* merge_prev(Block*);
+  void merge_next(Block*);
+  void add_live_bytes(const uint32_t);
+  uint32_t fl_bitmap_{};
+  uint32_t sl_bitmap_[kFlIndexCount]{};
+  Block* free_lists_[kFlIndexCount][kSlIndexCount]{};
+  AllocatorStatistics statistics_{};
+  TlsfAllocator() = delete;
+  TlsfAllocator(const TlsfAllocator&) = delete;
+  void operator=(const TlsfAllocator&) = delete;
+};
+} // namespace tote
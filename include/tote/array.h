@@ -1,30 +1,125 @@
 #pragma once
 #include <stdint.h>
 #include <string.h>
+#include <new>
+#include <type_traits>
 #include <utility>
 #include "allocator_callbacks.h"
+#include "array_kernels.h"
 namespace tote {
-template <typename T, typename U>
+/**
+ * types which can be relocated with memcpy without calling move constructor and destructor.
+ * specialize to opt in types which are not trivially copyable.
+ **/
+template <typename T>
+struct IsTriviallyRelocatable : std::bool_constant<std::is_trivially_copyable_v<T>> {};
+/**
+ * capacity grown from size by numerator/denominator.
+ * 3/2 trades more reallocations for less slack than the default doubling.
+ **/
+template <uint32_t numerator = 2, uint32_t denominator = 1>
+struct GeometricGrowth {
+  static_assert(numerator > denominator);
+  template <typename T>
+  static constexpr SizeType GetNextCapacity(const SizeType size, const SizeType required, const SizeType max_capacity) {
+    // size + 1 so that small arrays grow with ratios below 2.
+    const auto grown = size < (max_capacity - numerator) / numerator ? (size + 1) * numerator / denominator : max_capacity;
+    return required > grown ? required : grown;
+  }
+};
+/**
+ * capacity grown from size by size itself up to max_step_size bytes at a time,
+ * rounded up to a multiple of the elements fitting in page_size bytes.
+ * suits huge arrays as slack is bounded by max_step_size instead of growing with size,
+ * and reallocate callbacks backed by virtual memory may extend the buffer in place.
+ **/
+template <SizeType page_size = 4096, SizeType max_step_size = 64 * 1024 * 1024>
+struct PageGranularGrowth {
+  static_assert(page_size > 0 && max_step_size >= page_size);
+  template <typename T>
+  static constexpr SizeType GetNextCapacity(const SizeType size, const SizeType required, const SizeType max_capacity) {
+    constexpr SizeType kPageCapacity = page_size > sizeof(T) ? page_size / sizeof(T) : 1;
+    constexpr SizeType kMaxStep = max_step_size > sizeof(T) ? max_step_size / sizeof(T) : 1;
+    const auto step = size < kPageCapacity ? kPageCapacity : size < kMaxStep ? size : kMaxStep;
+    auto grown = size < max_capacity - step ? size + step : max_capacity;
+    if (grown < required) { grown = required; }
+    const auto padding = (kPageCapacity - grown % kPageCapacity) % kPageCapacity;
+    return grown < max_capacity - padding ? grown + padding : max_capacity;
+  }
+};
+/**
+ * capacity to hold count more elements of T after size, grown by GrowthPolicy to amortize growth.
+ * clamped to the largest capacity whose byte size fits in SizeType,
+ * aborts when size + count elements do not fit.
+ **/
+template <typename T, typename GrowthPolicy = GeometricGrowth<>>
+constexpr SizeType GetGrownArrayCapacity(const SizeType size, const SizeType count) {
+  constexpr auto kMaxCapacity = kMaxSize / sizeof(T);
+  if (size > kMaxCapacity || count > kMaxCapacity - size) { abort(); }
+  return GrowthPolicy::template GetNextCapacity<T>(size, size + count, kMaxCapacity);
+}
+/**
+ * GrowthPolicy gives the capacity when push_back, append or resize runs out of capacity,
+ * while reserve and shrink_to_fit set the capacity exactly.
+ * initial_size must be 0 when T is not default constructible, otherwise construction aborts.
+ **/
+template <typename T, typename U, typename GrowthPolicy = GeometricGrowth<>>
 class ResizableArray final {
  public:
-  ResizableArray(AllocatorCallbacks<U> allocator_callbacks, const uint32_t initial_size = 0, const uint32_t initial_capacity = 0);
+  ResizableArray(AllocatorCallbacks<U> allocator_callbacks, const SizeType initial_size = 0, const SizeType initial_capacity = 0);
   ResizableArray(ResizableArray&&);
   ResizableArray& operator=(ResizableArray&&);
   ~ResizableArray();
-  constexpr uint32_t size() const { return size_; }
-  constexpr uint32_t capacity() const { return capacity_; }
+  constexpr SizeType size() const { return size_; }
+  constexpr SizeType capacity() const { return capacity_; }
   constexpr bool empty() const { return size() == 0; }
   /**
    * reset size to zero.
-   * destructor for T is not called.
+   * destructor for T is called unless trivially destructible.
    **/
-  void clear() { size_ = 0; }
+  void clear();
   /**
    * release allocated buffer which reduces size and capacity to zero.
-   * destructor for T is not called.
+   * destructor for T is called unless trivially destructible.
    **/
   void release_allocated_buffer();
-  void push_back(T);
+  /**
+   * grow capacity to exactly n unless it already holds n elements.
+   **/
+  void reserve(const SizeType n);
+  /**
+   * reduce capacity to size, releasing the buffer when empty.
+   * relocates elements unless the reallocate callback shrinks in place.
+   **/
+  void shrink_to_fit();
+  void push_back(const T& val) { emplace_back(val); }
+  void push_back(T&& val) { emplace_back(std::move(val)); }
+  template <typename... Args> T& emplace_back(Args&&...);
+  /**
+   * copies count elements at the end, growing capacity at most once.
+   * values may point into this array.
+   **/
+  void append(const T* values, const SizeType count);
+  /**
+   * destructs elements beyond n or appends copies of value up to n.
+   **/
+  void resize(const SizeType n, const T& value = T{});
+  /**
+   * first element equal to value or nullptr.
+   * integral, enum and pointer elements are compared with SIMD when available.
+   **/
+  T* find(const T& value);
+  const T* find(const T& value) const;
+  /**
+   * moves the last element to index and pops it, which does not keep the order.
+   **/
+  void erase_unordered(const SizeType index);
+  /**
+   * removes elements equal to value (or satisfying pred) keeping the order of the rest.
+   * returns the number of removed elements.
+   **/
+  SizeType remove(const T& value);
+  template <typename F> SizeType remove_if(F&& pred);
   T* begin() { return head_; }
   const T* begin() const { return head_; }
   T* end() { return head_ + size_; }
@@ -33,33 +128,43 @@ class ResizableArray final {
   const T& front() const { return *head_; }
   T& back() { return *(head_ + size_ - 1); }
   const T& back() const { return *(head_ + size_ - 1); }
-  T& operator[](const uint32_t index) { return *(head_ + index); }
-  const T& operator[](const uint32_t index) const { return *(head_ + index); }
+  T& operator[](const SizeType index) { return *(head_ + index); }
+  const T& operator[](const SizeType index) const { return *(head_ + index); }
  private:
-  void change_capacity(const uint32_t new_capacity);
+  void change_capacity(const SizeType new_capacity);
+  void destruct_elements();
+  void destruct_elements_from(const SizeType index);
   AllocatorCallbacks<U> allocator_callbacks_;
-  uint32_t size_;
-  uint32_t capacity_;
+  SizeType size_;
+  SizeType capacity_;
   T* head_;
   ResizableArray() = delete;
   ResizableArray(const ResizableArray&) = delete;
   void operator=(const ResizableArray&) = delete;
 };
-template <typename T, typename U>
-ResizableArray<T, U>::ResizableArray(AllocatorCallbacks<U> allocator_callbacks, const uint32_t initial_size, const uint32_t initial_capacity)
+template <typename T, typename U, typename G>
+ResizableArray<T, U, G>::ResizableArray(AllocatorCallbacks<U> allocator_callbacks, const SizeType initial_size, const SizeType initial_capacity)
     : allocator_callbacks_(allocator_callbacks)
     , size_(initial_size)
     , capacity_(0)
     , head_(nullptr)
 {
   change_capacity(initial_size > initial_capacity ? initial_size: initial_capacity);
+  if constexpr (!std::is_default_constructible_v<T>) {
+    // elements without a default constructor cannot be made up.
+    if (initial_size > 0) { abort(); }
+  } else if constexpr (!std::is_trivially_default_constructible_v<T>) {
+    for (SizeType i = 0; i < size_; i++) {
+      new (head_ + i) T();
+    }
+  }
 }
-template <typename T, typename U>
-ResizableArray<T, U>::~ResizableArray() {
+template <typename T, typename U, typename G>
+ResizableArray<T, U, G>::~ResizableArray() {
   release_allocated_buffer();
 }
-template <typename T, typename U>
-ResizableArray<T, U>::ResizableArray(ResizableArray&& other)
+template <typename T, typename U, typename G>
+ResizableArray<T, U, G>::ResizableArray(ResizableArray&& other)
     : allocator_callbacks_(std::move(other.allocator_callbacks_))
     , size_(other.size_)
     , capacity_(other.capacity_)
@@ -70,12 +175,10 @@ ResizableArray<T, U>::ResizableArray(ResizableArray&& other)
   other.capacity_ = 0;
   other.head_ = nullptr;
 }
-template <typename T, typename U>
-ResizableArray<T, U> & ResizableArray<T, U>::operator=(ResizableArray&& other) {
+template <typename T, typename U, typename G>
+ResizableArray<T, U, G>& ResizableArray<T, U, G>::operator=(ResizableArray&& other) {
   if (this != &other) {
-    if (head_) {
-      allocator_callbacks_.deallocate(head_, allocator_callbacks_.user_context);
-    }
+    release_allocated_buffer();
     allocator_callbacks_ = std::move(other.allocator_callbacks_);
     size_ = other.size_;
     capacity_ = other.capacity_;
@@ -87,8 +190,22 @@ ResizableArray<T, U> & ResizableArray<T, U>::operator=(ResizableArray&& other) {
   }
   return *this;
 }
-template <typename T, typename U>
-void ResizableArray<T, U>::release_allocated_buffer() {
+template <typename T, typename U, typename G>
+void ResizableArray<T, U, G>::destruct_elements() {
+  if constexpr (!std::is_trivially_destructible_v<T>) {
+    for (SizeType i = 0; i < size_; i++) {
+      head_[i].~T();
+    }
+  }
+}
+template <typename T, typename U, typename G>
+void ResizableArray<T, U, G>::clear() {
+  destruct_elements();
+  size_ = 0;
+}
+template <typename T, typename U, typename G>
+void ResizableArray<T, U, G>::release_allocated_buffer() {
+  destruct_elements();
   if (head_ != nullptr) {
     allocator_callbacks_.deallocate(head_, allocator_callbacks_.user_context);
     head_ = nullptr;
@@ -97,30 +214,468 @@ void ResizableArray<T, U>::release_allocated_buffer() {
   capacity_ = 0;
   head_ = nullptr;
 }
-template <typename T, typename U>
-void ResizableArray<T, U>::push_back(T val) {
-  auto index = size_;
+template <typename T, typename U, typename G>
+void ResizableArray<T, U, G>::reserve(const SizeType n) {
+  if (n > capacity_) {
+    change_capacity(n);
+  }
+}
+template <typename T, typename U, typename G>
+void ResizableArray<T, U, G>::shrink_to_fit() {
+  if (size_ < capacity_) {
+    change_capacity(size_);
+  }
+}
+template <typename T, typename U, typename G>
+template <typename... Args>
+T& ResizableArray<T, U, G>::emplace_back(Args&&... args) {
+  if (size_ < capacity_) {
+    new (head_ + size_) T(std::forward<Args>(args)...);
+  } else {
+    // args may refer to an element of this array, construct before relocation.
+    T val(std::forward<Args>(args)...);
+    change_capacity(GetGrownArrayCapacity<T, G>(size_, 1));
+    new (head_ + size_) T(std::move(val));
+  }
   size_++;
-  if (index >= capacity_) {
-    change_capacity(size_ * 2);
+  return back();
+}
+template <typename T, typename U, typename G>
+void ResizableArray<T, U, G>::append(const T* values, const SizeType count) {
+  // compared without size_ + count, which may wrap and skip the growth.
+  if (count > capacity_ - size_) {
+    const auto new_capacity = GetGrownArrayCapacity<T, G>(size_, count);
+    const auto src = reinterpret_cast<uintptr_t>(values);
+    if (src >= reinterpret_cast<uintptr_t>(head_) && src < reinterpret_cast<uintptr_t>(head_ + size_)) {
+      const auto offset = static_cast<SizeType>(values - head_);
+      change_capacity(new_capacity);
+      values = head_ + offset;
+    } else {
+      change_capacity(new_capacity);
+    }
+  }
+  if constexpr (std::is_trivially_copyable_v<T>) {
+    memcpy(static_cast<void*>(head_ + size_), static_cast<const void*>(values), sizeof(T) * count);
+  } else {
+    for (SizeType i = 0; i < count; i++) {
+      new (head_ + size_ + i) T(values[i]);
+    }
   }
-  head_[index] = val;
+  size_ += count;
 }
-template <typename T, typename U>
-void ResizableArray<T, U>::change_capacity(const uint32_t new_capacity) {
-  if (new_capacity < capacity_) { return; }
-  const auto prev_head = head_;
-  if (size_ > new_capacity) {
-    size_ = new_capacity;
+template <typename T, typename U, typename G>
+void ResizableArray<T, U, G>::resize(const SizeType n, const T& value) {
+  if (n <= size_) {
+    destruct_elements_from(n);
+    size_ = n;
+    return;
   }
-  capacity_ = new_capacity;
-  if (capacity_ > 0) {
-    head_ = static_cast<T*>(allocator_callbacks_.allocate(sizeof(T) * new_capacity, alignof(T), allocator_callbacks_.user_context));
+  // value may refer to an element of this array, copy before relocation.
+  const T val(value);
+  if (n > capacity_) {
+    change_capacity(GetGrownArrayCapacity<T, G>(size_, n - size_));
+  }
+  if constexpr (std::is_trivially_copyable_v<T>) {
+    FillArrayValue(head_ + size_, n - size_, val);
   } else {
+    for (SizeType i = size_; i < n; i++) {
+      new (head_ + i) T(val);
+    }
+  }
+  size_ = n;
+}
+template <typename T, typename U, typename G>
+T* ResizableArray<T, U, G>::find(const T& value) {
+  return const_cast<T*>(static_cast<const ResizableArray*>(this)->find(value));
+}
+template <typename T, typename U, typename G>
+const T* ResizableArray<T, U, G>::find(const T& value) const {
+  const auto index = FindArrayValue(head_, size_, value);
+  return index < size_ ? head_ + index : nullptr;
+}
+template <typename T, typename U, typename G>
+void ResizableArray<T, U, G>::erase_unordered(const SizeType index) {
+  if (index + 1 < size_) {
+    head_[index] = std::move(back());
+  }
+  destruct_elements_from(size_ - 1);
+  size_--;
+}
+template <typename T, typename U, typename G>
+SizeType ResizableArray<T, U, G>::remove(const T& value) {
+  const auto kept = RemoveArrayValue(head_, size_, value);
+  const auto removed = size_ - kept;
+  destruct_elements_from(kept);
+  size_ = kept;
+  return removed;
+}
+template <typename T, typename U, typename G>
+template <typename F>
+SizeType ResizableArray<T, U, G>::remove_if(F&& pred) {
+  const auto kept = RemoveArrayIf(head_, size_, std::forward<F>(pred));
+  const auto removed = size_ - kept;
+  destruct_elements_from(kept);
+  size_ = kept;
+  return removed;
+}
+template <typename T, typename U, typename G>
+void ResizableArray<T, U, G>::destruct_elements_from(const SizeType index) {
+  if constexpr (!std::is_trivially_destructible_v<T>) {
+    for (SizeType i = index; i < size_; i++) {
+      head_[i].~T();
+    }
+  }
+}
+template <typename T, typename U, typename G>
+void ResizableArray<T, U, G>::change_capacity(const SizeType new_capacity) {
+  // new_capacity is never less than size.
+  if (new_capacity == capacity_) { return; }
+  const auto prev_head = head_;
+  const auto prev_capacity = capacity_;
+  capacity_ = new_capacity;
+  if (capacity_ == 0) {
+    // shrinking an empty array only releases its buffer.
+    allocator_callbacks_.deallocate(prev_head, allocator_callbacks_.user_context);
     head_ = nullptr;
+    return;
+  }
+  if constexpr (IsTriviallyRelocatable<T>::value) {
+    // bytes are relocated by the allocator, possibly without copy.
+    if (prev_head != nullptr && allocator_callbacks_.reallocate != nullptr) {
+      head_ = static_cast<T*>(allocator_callbacks_.reallocate(prev_head, GetAllocationSize(prev_capacity, sizeof(T)), GetAllocationSize(capacity_, sizeof(T)), alignof(T), allocator_callbacks_.user_context));
+      if (head_ != nullptr) { return; }
+    }
   }
+  head_ = static_cast<T*>(allocator_callbacks_.allocate(GetAllocationSize(new_capacity, sizeof(T)), alignof(T), allocator_callbacks_.user_context));
   if (prev_head != nullptr) {
-    memcpy(head_, prev_head, sizeof(T) * (size_));
+    if constexpr (IsTriviallyRelocatable<T>::value) {
+      memcpy(static_cast<void*>(head_), static_cast<const void*>(prev_head), sizeof(T) * size_);
+    } else {
+      for (SizeType i = 0; i < size_; i++) {
+        new (head_ + i) T(std::move(prev_head[i]));
+        prev_head[i].~T();
+      }
+    }
+    allocator_callbacks_.deallocate(prev_head, allocator_callbacks_.user_context);
+  }
+}
+/**
+ * ResizableArray only holds a pointer to its buffer.
+ **/
+template <typename T, typename U, typename G>
+struct IsTriviallyRelocatable<ResizableArray<T, U, G>> : std::true_type {};
+/**
+ * ResizableArray storing up to N elements inline,
+ * the allocator is used only when capacity grows beyond N.
+ * capacity never goes below N, shrink_to_fit moves elements back inline when they fit.
+ * elements are relocated on move unless spilled to allocated buffer,
+ * hence SmallArray itself is not trivially relocatable.
+ * initial_size must be 0 when T is not default constructible, as in ResizableArray.
+ **/
+template <typename T, uint32_t N, typename U, typename GrowthPolicy = GeometricGrowth<>>
+class SmallArray final {
+ public:
+  SmallArray(AllocatorCallbacks<U> allocator_callbacks, const SizeType initial_size = 0, const SizeType initial_capacity = 0);
+  SmallArray(SmallArray&&);
+  SmallArray& operator=(SmallArray&&);
+  ~SmallArray();
+  constexpr SizeType size() const { return size_; }
+  constexpr SizeType capacity() const { return capacity_; }
+  constexpr bool empty() const { return size() == 0; }
+  constexpr bool is_inline() const { return capacity_ == N; }
+  /**
+   * reset size to zero.
+   * destructor for T is called unless trivially destructible.
+   **/
+  void clear();
+  /**
+   * release allocated buffer which reduces size to zero and capacity to N.
+   * destructor for T is called unless trivially destructible.
+   **/
+  void release_allocated_buffer();
+  /**
+   * grow capacity to exactly n unless it already holds n elements.
+   **/
+  void reserve(const SizeType n);
+  /**
+   * reduce capacity to size, or to N moving elements back inline.
+   **/
+  void shrink_to_fit();
+  void push_back(const T& val) { emplace_back(val); }
+  void push_back(T&& val) { emplace_back(std::move(val)); }
+  template <typename... Args> T& emplace_back(Args&&...);
+  /**
+   * copies count elements at the end, growing capacity at most once.
+   * values may point into this array.
+   **/
+  void append(const T* values, const SizeType count);
+  /**
+   * destructs elements beyond n or appends copies of value up to n.
+   **/
+  void resize(const SizeType n, const T& value = T{});
+  /**
+   * first element equal to value or nullptr.
+   **/
+  T* find(const T& value);
+  const T* find(const T& value) const;
+  /**
+   * moves the last element to index and pops it, which does not keep the order.
+   **/
+  void erase_unordered(const SizeType index);
+  /**
+   * removes elements equal to value (or satisfying pred) keeping the order of the rest.
+   * returns the number of removed elements.
+   **/
+  SizeType remove(const T& value);
+  template <typename F> SizeType remove_if(F&& pred);
+  T* begin() { return head_; }
+  const T* begin() const { return head_; }
+  T* end() { return head_ + size_; }
+  const T* end() const { return head_ + size_; }
+  T& front() { return *head_; }
+  const T& front() const { return *head_; }
+  T& back() { return *(head_ + size_ - 1); }
+  const T& back() const { return *(head_ + size_ - 1); }
+  T& operator[](const SizeType index) { return *(head_ + index); }
+  const T& operator[](const SizeType index) const { return *(head_ + index); }
+ private:
+  static void relocate(T* dst, T* src, const SizeType count);
+  T* get_inline_head() { return std::launder(reinterpret_cast<T*>(inline_buffer_)); }
+  void take_elements(SmallArray&&);
+  void change_capacity(const SizeType new_capacity);
+  void destruct_elements();
+  void destruct_elements_from(const SizeType index);
+  AllocatorCallbacks<U> allocator_callbacks_;
+  SizeType size_;
+  SizeType capacity_;
+  T* head_;
+  alignas(T) unsigned char inline_buffer_[sizeof(T) * N];
+  static_assert(N > 0);
+  SmallArray() = delete;
+  SmallArray(const SmallArray&) = delete;
+  void operator=(const SmallArray&) = delete;
+};
+template <typename T, uint32_t N, typename U, typename G>
+SmallArray<T, N, U, G>::SmallArray(AllocatorCallbacks<U> allocator_callbacks, const SizeType initial_size, const SizeType initial_capacity)
+    : allocator_callbacks_(allocator_callbacks)
+    , size_(0)
+    , capacity_(N)
+    , head_(get_inline_head())
+{
+  change_capacity(initial_size > initial_capacity ? initial_size: initial_capacity);
+  size_ = initial_size;
+  if constexpr (!std::is_default_constructible_v<T>) {
+    // elements without a default constructor cannot be made up.
+    if (initial_size > 0) { abort(); }
+  } else if constexpr (!std::is_trivially_default_constructible_v<T>) {
+    for (SizeType i = 0; i < size_; i++) {
+      new (head_ + i) T();
+    }
+  }
+}
+template <typename T, uint32_t N, typename U, typename G>
+SmallArray<T, N, U, G>::~SmallArray() {
+  release_allocated_buffer();
+}
+template <typename T, uint32_t N, typename U, typename G>
+SmallArray<T, N, U, G>::SmallArray(SmallArray&& other)
+    : allocator_callbacks_(std::move(other.allocator_callbacks_))
+    , size_(0)
+    , capacity_(N)
+    , head_(get_inline_head())
+{
+  take_elements(std::move(other));
+}
+template <typename T, uint32_t N, typename U, typename G>
+SmallArray<T, N, U, G>& SmallArray<T, N, U, G>::operator=(SmallArray&& other) {
+  if (this != &other) {
+    release_allocated_buffer();
+    allocator_callbacks_ = std::move(other.allocator_callbacks_);
+    take_elements(std::move(other));
+  }
+  return *this;
+}
+template <typename T, uint32_t N, typename U, typename G>
+void SmallArray<T, N, U, G>::take_elements(SmallArray&& other) {
+  if (other.is_inline()) {
+    relocate(head_, other.head_, other.size_);
+  } else {
+    head_ = other.head_;
+    capacity_ = other.capacity_;
+    other.head_ = other.get_inline_head();
+    other.capacity_ = N;
+  }
+  size_ = other.size_;
+  other.allocator_callbacks_ = {};
+  other.size_ = 0;
+}
+template <typename T, uint32_t N, typename U, typename G>
+void SmallArray<T, N, U, G>::relocate(T* dst, T* src, const SizeType count) {
+  if constexpr (IsTriviallyRelocatable<T>::value) {
+    memcpy(static_cast<void*>(dst), static_cast<const void*>(src), sizeof(T) * count);
+  } else {
+    for (SizeType i = 0; i < count; i++) {
+      new (dst + i) T(std::move(src[i]));
+      src[i].~T();
+    }
+  }
+}
+template <typename T, uint32_t N, typename U, typename G>
+void SmallArray<T, N, U, G>::destruct_elements() {
+  destruct_elements_from(0);
+}
+template <typename T, uint32_t N, typename U, typename G>
+void SmallArray<T, N, U, G>::destruct_elements_from(const SizeType index) {
+  if constexpr (!std::is_trivially_destructible_v<T>) {
+    for (SizeType i = index; i < size_; i++) {
+      head_[i].~T();
+    }
+  }
+}
+template <typename T, uint32_t N, typename U, typename G>
+void SmallArray<T, N, U, G>::clear() {
+  destruct_elements();
+  size_ = 0;
+}
+template <typename T, uint32_t N, typename U, typename G>
+void SmallArray<T, N, U, G>::release_allocated_buffer() {
+  destruct_elements();
+  if (!is_inline()) {
+    allocator_callbacks_.deallocate(head_, allocator_callbacks_.user_context);
+  }
+  size_ = 0;
+  capacity_ = N;
+  head_ = get_inline_head();
+}
+template <typename T, uint32_t N, typename U, typename G>
+void SmallArray<T, N, U, G>::reserve(const SizeType n) {
+  if (n > capacity_) {
+    change_capacity(n);
+  }
+}
+template <typename T, uint32_t N, typename U, typename G>
+void SmallArray<T, N, U, G>::shrink_to_fit() {
+  if (size_ < capacity_) {
+    change_capacity(size_);
+  }
+}
+template <typename T, uint32_t N, typename U, typename G>
+template <typename... Args>
+T& SmallArray<T, N, U, G>::emplace_back(Args&&... args) {
+  if (size_ < capacity_) {
+    new (head_ + size_) T(std::forward<Args>(args)...);
+  } else {
+    // args may refer to an element of this array, construct before relocation.
+    T val(std::forward<Args>(args)...);
+    change_capacity(GetGrownArrayCapacity<T, G>(size_, 1));
+    new (head_ + size_) T(std::move(val));
+  }
+  size_++;
+  return back();
+}
+template <typename T, uint32_t N, typename U, typename G>
+void SmallArray<T, N, U, G>::append(const T* values, const SizeType count) {
+  // compared without size_ + count, which may wrap and skip the growth.
+  if (count > capacity_ - size_) {
+    const auto new_capacity = GetGrownArrayCapacity<T, G>(size_, count);
+    const auto src = reinterpret_cast<uintptr_t>(values);
+    if (src >= reinterpret_cast<uintptr_t>(head_) && src < reinterpret_cast<uintptr_t>(head_ + size_)) {
+      const auto offset = static_cast<SizeType>(values - head_);
+      change_capacity(new_capacity);
+      values = head_ + offset;
+    } else {
+      change_capacity(new_capacity);
+    }
+  }
+  if constexpr (std::is_trivially_copyable_v<T>) {
+    memcpy(static_cast<void*>(head_ + size_), static_cast<const void*>(values), sizeof(T) * count);
+  } else {
+    for (SizeType i = 0; i < count; i++) {
+      new (head_ + size_ + i) T(values[i]);
+    }
+  }
+  size_ += count;
+}
+template <typename T, uint32_t N, typename U, typename G>
+void SmallArray<T, N, U, G>::resize(const SizeType n, const T& value) {
+  if (n <= size_) {
+    destruct_elements_from(n);
+    size_ = n;
+    return;
+  }
+  // value may refer to an element of this array, copy before relocation.
+  const T val(value);
+  if (n > capacity_) {
+    change_capacity(GetGrownArrayCapacity<T, G>(size_, n - size_));
+  }
+  if constexpr (std::is_trivially_copyable_v<T>) {
+    FillArrayValue(head_ + size_, n - size_, val);
+  } else {
+    for (SizeType i = size_; i < n; i++) {
+      new (head_ + i) T(val);
+    }
+  }
+  size_ = n;
+}
+template <typename T, uint32_t N, typename U, typename G>
+T* SmallArray<T, N, U, G>::find(const T& value) {
+  return const_cast<T*>(static_cast<const SmallArray*>(this)->find(value));
+}
+template <typename T, uint32_t N, typename U, typename G>
+const T* SmallArray<T, N, U, G>::find(const T& value) const {
+  const auto index = FindArrayValue(head_, size_, value);
+  return index < size_ ? head_ + index : nullptr;
+}
+template <typename T, uint32_t N, typename U, typename G>
+void SmallArray<T, N, U, G>::erase_unordered(const SizeType index) {
+  if (index + 1 < size_) {
+    head_[index] = std::move(back());
+  }
+  destruct_elements_from(size_ - 1);
+  size_--;
+}
+template <typename T, uint32_t N, typename U, typename G>
+SizeType SmallArray<T, N, U, G>::remove(const T& value) {
+  const auto kept = RemoveArrayValue(head_, size_, value);
+  const auto removed = size_ - kept;
+  destruct_elements_from(kept);
+  size_ = kept;
+  return removed;
+}
+template <typename T, uint32_t N, typename U, typename G>
+template <typename F>
+SizeType SmallArray<T, N, U, G>::remove_if(F&& pred) {
+  const auto kept = RemoveArrayIf(head_, size_, std::forward<F>(pred));
+  const auto removed = size_ - kept;
+  destruct_elements_from(kept);
+  size_ = kept;
+  return removed;
+}
+template <typename T, uint32_t N, typename U, typename G>
+void SmallArray<T, N, U, G>::change_capacity(const SizeType new_capacity) {
+  // new_capacity is never less than size, and capacity never less than N.
+  const auto target_capacity = new_capacity > N ? new_capacity : N;
+  if (target_capacity == capacity_) { return; }
+  const auto prev_head = head_;
+  const auto prev_capacity = capacity_;
+  const auto was_inline = is_inline();
+  capacity_ = target_capacity;
+  if (is_inline()) {
+    // elements fit in the inline buffer again.
+    head_ = get_inline_head();
+    relocate(head_, prev_head, size_);
+    allocator_callbacks_.deallocate(prev_head, allocator_callbacks_.user_context);
+    return;
+  }
+  if constexpr (IsTriviallyRelocatable<T>::value) {
+    if (!was_inline && allocator_callbacks_.reallocate != nullptr) {
+      head_ = static_cast<T*>(allocator_callbacks_.reallocate(prev_head, GetAllocationSize(prev_capacity, sizeof(T)), GetAllocationSize(capacity_, sizeof(T)), alignof(T), allocator_callbacks_.user_context));
+      if (head_ != nullptr) { return; }
+    }
+  }
+  head_ = static_cast<T*>(allocator_callbacks_.allocate(GetAllocationSize(capacity_, sizeof(T)), alignof(T), allocator_callbacks_.user_context));
+  relocate(head_, prev_head, size_);
+  if (!was_inline) {
     allocator_callbacks_.deallocate(prev_head, allocator_callbacks_.user_context);
   }
 }
@@ -0,0 +1,289 @@
+#pragma once
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <string.h>
+#include <type_traits>
+#include <utility>
+#include "allocator_callbacks.h"
+#if !defined(TOTE_DISABLE_SIMD) && defined(__AVX2__)
+#define TOTE_ARRAY_AVX2
+#include <immintrin.h>
+#elif !defined(TOTE_DISABLE_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define TOTE_ARRAY_SSE2
+#include <emmintrin.h>
+#elif !defined(TOTE_DISABLE_SIMD) && (defined(__ARM_NEON) || defined(_M_ARM64))
+#define TOTE_ARRAY_NEON
+#include <arm_neon.h>
+#endif
+namespace tote {
+/**
+ * bytes processed at once by array kernels, zero without SIMD.
+ **/
+#if defined(TOTE_ARRAY_AVX2)
+constexpr uint32_t kArraySimdWidth = 32;
+#elif defined(TOTE_ARRAY_SSE2) || defined(TOTE_ARRAY_NEON)
+constexpr uint32_t kArraySimdWidth = 16;
+#else
+constexpr uint32_t kArraySimdWidth = 0;
+#endif
+/**
+ * types compared bitwise by SIMD kernels.
+ * floating point types are excluded as == differs from bitwise equality for NaN and signed zero.
+ **/
+template <typename T>
+constexpr bool kIsArraySimdComparable = (std::is_integral_v<T> || std::is_enum_v<T> || std::is_pointer_v<T>) && (sizeof(T) == 1 || sizeof(T) == 2 || sizeof(T) == 4 || sizeof(T) == 8);
+template <uint32_t size> struct ArrayLaneBits;
+template <> struct ArrayLaneBits<1> { using type = uint8_t; };
+template <> struct ArrayLaneBits<2> { using type = uint16_t; };
+template <> struct ArrayLaneBits<4> { using type = uint32_t; };
+template <> struct ArrayLaneBits<8> { using type = uint64_t; };
+#if defined(TOTE_ARRAY_AVX2) || defined(TOTE_ARRAY_SSE2) || defined(TOTE_ARRAY_NEON)
+#if defined(TOTE_ARRAY_NEON)
+constexpr uint32_t kArrayMatchMaskShift = 2; // 4 bits per byte.
+#else
+constexpr uint32_t kArrayMatchMaskShift = 0;
+#endif
+/**
+ * mask with bits set for every byte of kArraySimdWidth bytes at data
+ * belonging to an element equal to value.
+ **/
+template <typename T>
+inline uint64_t MatchArrayLanes(const T* data, const T value) {
+  const auto bits = std::bit_cast<typename ArrayLaneBits<sizeof(T)>::type>(value);
+#if defined(TOTE_ARRAY_AVX2)
+  const auto block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data));
+  __m256i eq;
+  if constexpr (sizeof(T) == 1) {
+    eq = _mm256_cmpeq_epi8(block, _mm256_set1_epi8(static_cast<char>(bits)));
+  } else if constexpr (sizeof(T) == 2) {
+    eq = _mm256_cmpeq_epi16(block, _mm256_set1_epi16(static_cast<short>(bits)));
+  } else if constexpr (sizeof(T) == 4) {
+    eq = _mm256_cmpeq_epi32(block, _mm256_set1_epi32(static_cast<int>(bits)));
+  } else {
+    eq = _mm256_cmpeq_epi64(block, _mm256_set1_epi64x(static_cast<long long>(bits)));
+  }
+  return static_cast<uint32_t>(_mm256_movemask_epi8(eq));
+#elif defined(TOTE_ARRAY_SSE2)
+  const auto block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+  __m128i eq;
+  if constexpr (sizeof(T) == 1) {
+    eq = _mm_cmpeq_epi8(block, _mm_set1_epi8(static_cast<char>(bits)));
+  } else if constexpr (sizeof(T) == 2) {
+    eq = _mm_cmpeq_epi16(block, _mm_set1_epi16(static_cast<short>(bits)));
+  } else if constexpr (sizeof(T) == 4) {
+    eq = _mm_cmpeq_epi32(block, _mm_set1_epi32(static_cast<int>(bits)));
+  } else {
+    // no 64-bit compare in SSE2, both 32-bit halves must match.
+    const auto eq32 = _mm_cmpeq_epi32(block, _mm_set1_epi64x(static_cast<long long>(bits)));
+    eq = _mm_and_si128(eq32, _mm_shuffle_epi32(eq32, _MM_SHUFFLE(2, 3, 0, 1)));
+  }
+  return static_cast<uint32_t>(_mm_movemask_epi8(eq));
+#else
+  const auto block = vld1q_u8(reinterpret_cast<const uint8_t*>(data));
+  uint8x16_t eq;
+  if constexpr (sizeof(T) == 1) {
+    eq = vceqq_u8(block, vdupq_n_u8(bits));
+  } else if constexpr (sizeof(T) == 2) {
+    eq = vreinterpretq_u8_u16(vceqq_u16(vreinterpretq_u16_u8(block), vdupq_n_u16(bits)));
+  } else if constexpr (sizeof(T) == 4) {
+    eq = vreinterpretq_u8_u32(vceqq_u32(vreinterpretq_u32_u8(block), vdupq_n_u32(bits)));
+  } else {
+    eq = vreinterpretq_u8_u64(vceqq_u64(vreinterpretq_u64_u8(block), vdupq_n_u64(bits)));
+  }
+  return vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(eq), 4)), 0);
+#endif
+}
+#if defined(TOTE_ARRAY_AVX2)
+/**
+ * for each mask of 8 kept 32-bit lanes, their indices packed into nibbles in order.
+ **/
+inline constexpr auto kArrayCompressPermutation = [] {
+  std::array<uint32_t, 256> table{};
+  for (uint32_t keep = 0; keep < 256; keep++) {
+    uint32_t kept = 0;
+    for (uint32_t i = 0; i < 8; i++) {
+      if ((keep >> i) & 1) {
+        table[keep] |= i << (kept * 4);
+        kept++;
+      }
+    }
+  }
+  return table;
+}();
+#endif
+/**
+ * copies the elements of kArraySimdWidth bytes at src not equal to value to dst in order,
+ * returns how many are copied.
+ * dst may equal or precede src, the rest of the block at dst may be overwritten.
+ **/
+template <typename T>
+inline uint32_t CompactArrayLanes(T* dst, const T* src, const T value) {
+  constexpr uint32_t lanes = kArraySimdWidth / sizeof(T);
+  constexpr uint32_t lane_mask_shift = static_cast<uint32_t>(sizeof(T)) << kArrayMatchMaskShift;
+  const auto mask = MatchArrayLanes(src, value);
+  if (mask == 0) {
+    memmove(static_cast<void*>(dst), static_cast<const void*>(src), kArraySimdWidth);
+    return lanes;
+  }
+#if defined(TOTE_ARRAY_AVX2)
+  if constexpr (sizeof(T) >= 4) {
+    // kept 32-bit lanes are gathered to the front with a single permutation,
+    // both halves of a 64-bit element share its mask.
+    uint32_t keep = 0;
+    for (uint32_t i = 0; i < 8; i++) {
+      keep |= static_cast<uint32_t>(((~mask) >> (i * 4)) & 1) << i;
+    }
+    const auto block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src));
+    const auto indices = _mm256_srlv_epi32(_mm256_set1_epi32(static_cast<int>(kArrayCompressPermutation[keep])), _mm256_setr_epi32(0, 4, 8, 12, 16, 20, 24, 28));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst), _mm256_permutevar8x32_epi32(block, indices));
+    return static_cast<uint32_t>(std::popcount(keep)) / static_cast<uint32_t>(sizeof(T) / 4);
+  }
+#endif
+  // every lane is written and kept ones advance the cursor,
+  // which never passes the lane being read as dst does not follow src.
+  uint32_t kept = 0;
+  for (uint32_t i = 0; i < lanes; i++) {
+    memmove(static_cast<void*>(dst + kept), static_cast<const void*>(src + i), sizeof(T));
+    kept += static_cast<uint32_t>((mask >> (i * lane_mask_shift)) & 1) ^ 1;
+  }
+  return kept;
+}
+#endif
+/**
+ * index of the first element equal to value, count when not found.
+ **/
+template <typename T>
+inline SizeType FindArrayValue(const T* data, const SizeType count, const T& value) {
+  SizeType i = 0;
+#if defined(TOTE_ARRAY_AVX2) || defined(TOTE_ARRAY_SSE2) || defined(TOTE_ARRAY_NEON)
+  if constexpr (kIsArraySimdComparable<T>) {
+    constexpr uint32_t lanes = kArraySimdWidth / sizeof(T);
+    for (; i + lanes <= count; i += lanes) {
+      const auto mask = MatchArrayLanes(data + i, value);
+      if (mask != 0) {
+        return i + (static_cast<uint32_t>(std::countr_zero(mask)) >> kArrayMatchMaskShift) / static_cast<uint32_t>(sizeof(T));
+      }
+    }
+  }
+#endif
+  for (; i < count; i++) {
+    if (data[i] == value) { return i; }
+  }
+  return count;
+}
+/**
+ * assigns value to count trivially copyable elements at data,
+ * storing a vector of repeated value at once when its size divides the vector.
+ **/
+template <typename T>
+inline void FillArrayValue(T* data, const SizeType count, const T& value) {
+  static_assert(std::is_trivially_copyable_v<T>);
+  if constexpr (sizeof(T) == 1) {
+    memset(static_cast<void*>(data), std::bit_cast<uint8_t>(value), count);
+    return;
+  }
+  SizeType i = 0;
+#if defined(TOTE_ARRAY_AVX2) || defined(TOTE_ARRAY_SSE2) || defined(TOTE_ARRAY_NEON)
+  if constexpr (kArraySimdWidth % sizeof(T) == 0) {
+    constexpr uint32_t lanes = kArraySimdWidth / sizeof(T);
+    alignas(kArraySimdWidth) T pattern[lanes];
+    for (uint32_t j = 0; j < lanes; j++) {
+      memcpy(static_cast<void*>(&pattern[j]), static_cast<const void*>(&value), sizeof(T));
+    }
+#if defined(TOTE_ARRAY_AVX2)
+    const auto block = _mm256_load_si256(reinterpret_cast<const __m256i*>(pattern));
+    for (; i + lanes <= count; i += lanes) {
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(data + i), block);
+    }
+#elif defined(TOTE_ARRAY_SSE2)
+    const auto block = _mm_load_si128(reinterpret_cast<const __m128i*>(pattern));
+    for (; i + lanes <= count; i += lanes) {
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(data + i), block);
+    }
+#else
+    const auto block = vld1q_u8(reinterpret_cast<const uint8_t*>(pattern));
+    for (; i + lanes <= count; i += lanes) {
+      vst1q_u8(reinterpret_cast<uint8_t*>(data + i), block);
+    }
+#endif
+  }
+#endif
+  for (; i < count; i++) {
+    memcpy(static_cast<void*>(data + i), static_cast<const void*>(&value), sizeof(T));
+  }
+}
+/**
+ * moves elements not equal to value to the front keeping their order, returns how many are kept.
+ * elements after the kept ones are left moved from.
+ **/
+template <typename T>
+inline SizeType RemoveArrayValue(T* data, const SizeType count, const T& value) {
+  auto dst = FindArrayValue(data, count, value);
+  if (dst == count) { return count; }
+  // value may refer to an element of data, copy before compaction.
+  const T val(value);
+  auto src = dst + 1;
+#if defined(TOTE_ARRAY_AVX2) || defined(TOTE_ARRAY_SSE2) || defined(TOTE_ARRAY_NEON)
+  if constexpr (kIsArraySimdComparable<T>) {
+    // vectors before the next match are moved at once,
+    // the vector holding it is compacted by its mask of matches.
+    constexpr uint32_t lanes = kArraySimdWidth / sizeof(T);
+    while (src + lanes <= count) {
+      const auto run = FindArrayValue(data + src, count - src, val) / lanes * lanes;
+      memmove(static_cast<void*>(data + dst), static_cast<const void*>(data + src), sizeof(T) * run);
+      dst += run;
+      src += run;
+      if (src + lanes > count) { break; }
+      dst += CompactArrayLanes(data + dst, data + src, val);
+      src += lanes;
+    }
+    for (; src < count; src++) {
+      const T element = data[src];
+      data[dst] = element;
+      dst += !(element == val);
+    }
+    return dst;
+  }
+#endif
+  // runs between matches are moved at once.
+  while (src < count) {
+    const auto next = src + FindArrayValue(data + src, count - src, val);
+    if constexpr (std::is_trivially_copyable_v<T>) {
+      memmove(static_cast<void*>(data + dst), static_cast<const void*>(data + src), sizeof(T) * (next - src));
+      dst += next - src;
+    } else {
+      for (; src < next; src++, dst++) {
+        data[dst] = std::move(data[src]);
+      }
+    }
+    src = next + 1;
+  }
+  return dst;
+}
+/**
+ * moves elements not satisfying pred to the front keeping their order, returns how many are kept.
+ * elements after the kept ones are left moved from.
+ **/
+template <typename T, typename F>
+inline SizeType RemoveArrayIf(T* data, const SizeType count, F&& pred) {
+  SizeType dst = 0;
+  if constexpr (std::is_trivially_copyable_v<T>) {
+    // branchless compaction, every element is written and kept ones advance the cursor.
+    for (SizeType i = 0; i < count; i++) {
+      const T val = data[i];
+      data[dst] = val;
+      dst += !pred(static_cast<const T&>(val));
+    }
+  } else {
+    for (SizeType i = 0; i < count; i++) {
+      if (pred(static_cast<const T&>(data[i]))) { continue; }
+      if (dst != i) {
+        data[dst] = std::move(data[i]);
+      }
+      dst++;
+    }
+  }
+  return dst;
+}
+} // namespace tote
@@ -0,0 +1,212 @@
+#pragma once
+#include <cstdint>
+#include <string.h>
+#include <string_view>
+#include <type_traits>
+#include "array.h"
+#include "hash_map.h"
+namespace tote {
+/**
+ * versioned position independent image of a container,
+ * arrays are referred to by offsets from the head of the blob and start at a cache line.
+ * a view reads a blob in place, e.g. from a memory mapped file, without copy or rehash.
+ * blobs are written in native byte order and rejected by views on other endianness.
+ **/
+constexpr uint32_t kBlobMagic = 0x65746f74; // "tote" in little endian.
+constexpr uint32_t kBlobVersion = 1;
+enum class BlobKind : uint32_t {
+  kArray = 1,
+  kHashMap = 2,
+};
+struct BlobHeader {
+  uint32_t magic;
+  uint32_t version;
+  BlobKind kind;
+  uint32_t key_size; // element size for arrays.
+  uint32_t value_size;
+  uint32_t size;
+  uint32_t capacity; // slot count for hash maps, same as size for arrays.
+  uint32_t reserved;
+  uint64_t flags_offset;
+  uint64_t keys_offset;
+  uint64_t values_offset;
+  uint64_t blob_size;
+};
+static_assert(sizeof(BlobHeader) == kCacheLineSize);
+/**
+ * types whose bytes stay meaningful in another process, i.e. trivially copyable and pointer free.
+ * specialize to false for types carrying pointers, such as a struct holding a const char*.
+ **/
+template <typename T>
+struct IsBlobSerializable : std::bool_constant<std::is_trivially_copyable_v<T> && !std::is_pointer_v<T> && !std::is_member_pointer_v<T>> {};
+template <typename T>
+inline constexpr bool kIsBlobSerializable = IsBlobSerializable<std::remove_cv_t<T>>::value;
+/**
+ * string_view is trivially copyable but points to its characters.
+ **/
+template <>
+struct IsBlobSerializable<std::string_view> : std::false_type {};
+/**
+ * fills header with offsets of flags, keys and values arrays laid out after it.
+ **/
+BlobHeader MakeBlobHeader(const BlobKind kind, const uint32_t key_size, const uint32_t value_size, const uint32_t size, const uint32_t capacity);
+/**
+ * returns header of blob when it matches kind, sizes and alignments, and all arrays lie within blob_size.
+ * returns nullptr otherwise.
+ **/
+const BlobHeader* GetBlobHeader(const void* blob, const uint64_t blob_size, const BlobKind kind, const uint32_t key_size, const uint32_t value_size, const uint32_t key_alignment, const uint32_t value_alignment);
+/**
+ * bytes required by SerializeToBlob.
+ **/
+template <typename T, typename U, typename G>
+uint64_t GetBlobSize(const ResizableArray<T, U, G>& array) {
+  return MakeBlobHeader(BlobKind::kArray, sizeof(T), 0, array.size(), array.size()).blob_size;
+}
+template <typename K, typename V, typename U, typename P, typename H, typename E, bool I>
+uint64_t GetBlobSize(const HashMap<K, V, U, P, H, E, I>& hash_map) {
+  return MakeBlobHeader(BlobKind::kHashMap, sizeof(K), sizeof(V), hash_map.size(), hash_map.capacity()).blob_size;
+}
+/**
+ * writes container to buffer and returns written bytes, or 0 when buffer_size is too small.
+ * buffer must be aligned to kCacheLineSize.
+ **/
+template <typename T, typename U, typename G>
+uint64_t SerializeToBlob(const ResizableArray<T, U, G>& array, void* buffer, const uint64_t buffer_size) {
+  static_assert(kIsBlobSerializable<T>, "T must be trivially copyable and pointer free.");
+  const auto header = MakeBlobHeader(BlobKind::kArray, sizeof(T), 0, array.size(), array.size());
+  if (header.blob_size > buffer_size) { return 0; }
+  auto head = static_cast<uint8_t*>(buffer);
+  memset(head, 0, header.blob_size);
+  memcpy(head, &header, sizeof(header));
+  if (array.size() > 0) {
+    memcpy(head + header.keys_offset, array.begin(), sizeof(T) * array.size());
+  }
+  return header.blob_size;
+}
+/**
+ * entries are written to a table of the same capacity with the same probing as HashMap,
+ * which also merges entries left in the previous table by an incremental rehash.
+ * KeyHash must give the same value in the reading process, which pointer free keys also ensure.
+ **/
+template <typename K, typename V, typename U, typename P, typename H, typename E, bool I>
+uint64_t SerializeToBlob(const HashMap<K, V, U, P, H, E, I>& hash_map, void* buffer, const uint64_t buffer_size) {
+  static_assert(kIsBlobSerializable<K>, "K must be trivially copyable and pointer free.");
+  static_assert(kIsBlobSerializable<V>, "V must be trivially copyable and pointer free.");
+  const auto header = MakeBlobHeader(BlobKind::kHashMap, sizeof(K), sizeof(V), hash_map.size(), hash_map.capacity());
+  if (header.blob_size > buffer_size) { return 0; }
+  auto head = static_cast<uint8_t*>(buffer);
+  memset(head, 0, header.blob_size);
+  memcpy(head, &header, sizeof(header));
+  auto flags = head + header.flags_offset;
+  auto keys = reinterpret_cast<K*>(head + header.keys_offset);
+  auto values = reinterpret_cast<V*>(head + header.values_offset);
+  const auto capacity = header.capacity;
+  hash_map.for_each([&](const K& key, const V& value) {
+    auto index = P::GetIndex(H{}(key), capacity);
+    while (flags[index]) {
+      index = index + 1 < capacity ? index + 1 : 0;
+    }
+    flags[index] = 1;
+    memcpy(static_cast<void*>(&keys[index]), &key, sizeof(K));
+    memcpy(static_cast<void*>(&values[index]), &value, sizeof(V));
+  });
+  return header.blob_size;
+}
+/**
+ * read only array over a blob written from ResizableArray of T.
+ * the blob must outlive the view.
+ **/
+template <typename T>
+class ArrayView final {
+  static_assert(kIsBlobSerializable<T>, "T must be trivially copyable and pointer free.");
+ public:
+  ArrayView(const void* blob, const uint64_t blob_size) {
+    const auto header = GetBlobHeader(blob, blob_size, BlobKind::kArray, sizeof(T), 0, alignof(T), 1);
+    if (header == nullptr) { return; }
+    head_ = reinterpret_cast<const T*>(static_cast<const uint8_t*>(blob) + header->keys_offset);
+    size_ = header->size;
+    valid_ = true;
+  }
+  /**
+   * false when blob is not an array of T of this version, the view is empty then.
+   **/
+  constexpr bool is_valid() const { return valid_; }
+  constexpr uint32_t size() const { return size_; }
+  constexpr bool empty() const { return size() == 0; }
+  const T* begin() const { return head_; }
+  const T* end() const { return head_ + size_; }
+  const T& front() const { return *head_; }
+  const T& back() const { return *(head_ + size_ - 1); }
+  const T& operator[](const uint32_t index) const { return *(head_ + index); }
+ private:
+  const T* head_{};
+  uint32_t size_{};
+  bool valid_{};
+};
+/**
+ * read only hash map over a blob written from HashMap.
+ * CapacityPolicy, KeyHash and KeyEqual must match those of the serialized HashMap.
+ * the blob must outlive the view.
+ **/
+template <typename K, typename V, typename CapacityPolicy = PrimeNumberCapacity<>, typename KeyHash = Hash<K>, typename KeyEqual = EqualTo<K>>
+class HashMapView final {
+  static_assert(kIsBlobSerializable<K>, "K must be trivially copyable and pointer free.");
+  static_assert(kIsBlobSerializable<V>, "V must be trivially copyable and pointer free.");
+ public:
+  HashMapView(const void* blob, const uint64_t blob_size) {
+    const auto header = GetBlobHeader(blob, blob_size, BlobKind::kHashMap, sizeof(K), sizeof(V), alignof(K), alignof(V));
+    if (header == nullptr) { return; }
+    const auto head = static_cast<const uint8_t*>(blob);
+    occupied_flags_ = head + header->flags_offset;
+    keys_ = reinterpret_cast<const K*>(head + header->keys_offset);
+    values_ = reinterpret_cast<const V*>(head + header->values_offset);
+    size_ = header->size;
+    capacity_ = header->capacity;
+    valid_ = true;
+  }
+  /**
+   * false when blob is not a hash map of K and V of this version, the view is empty then.
+   **/
+  constexpr bool is_valid() const { return valid_; }
+  constexpr uint32_t size() const { return size_; }
+  constexpr uint32_t capacity() const { return capacity_; }
+  constexpr bool empty() const { return size() == 0; }
+  const V* find(const K key) const {
+    if (size_ == 0) { return nullptr; }
+    auto index = CapacityPolicy::GetIndex(KeyHash{}(key), capacity_);
+    // probes are bounded by capacity in case of a broken blob.
+    for (uint32_t i = 0; i < capacity_ && occupied_flags_[index]; i++) {
+      if (KeyEqual{}(keys_[index], key)) { return &values_[index]; }
+      index = index + 1 < capacity_ ? index + 1 : 0;
+    }
+    return nullptr;
+  }
+  bool contains(const K key) const { return find(key) != nullptr; }
+  /**
+   * returns default constructed V for missing key.
+   **/
+  const V& operator[](const K key) const {
+    static const V default_value{};
+    const auto value = find(key);
+    return value ? *value : default_value;
+  }
+  /**
+   * calls f(const K&, const V&) for each entry.
+   **/
+  template <typename F>
+  void for_each(F&& f) const {
+    for (uint32_t i = 0; i < capacity_; i++) {
+      if (occupied_flags_[i]) {
+        f(keys_[i], values_[i]);
+      }
+    }
+  }
+ private:
+  const uint8_t* occupied_flags_{};
+  const K* keys_{};
+  const V* values_{};
+  uint32_t size_{};
+  uint32_t capacity_{};
+  bool valid_{};
+};
+} // namespace tote
@@ -0,0 +1,282 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <new>
+#include <string.h>
+#include <type_traits>
+#include "allocator_callbacks.h"
+#include "hash_map.h"
+namespace tote {
+/**
+ * HashMap for read-mostly tables shared between threads.
+ * find, contains and size may be called from any number of threads,
+ * other functions must be called from a single writer thread at a time.
+ * readers never block the writer nor each other, and retry only when
+ * their probe overlapped a write (seqlock per table).
+ * slots are accessed as atomic words, hence the map is free of data races.
+ * growth publishes a new table and retires the previous one, which readers may still read.
+ * retired tables are released by collect_retired_tables(), called by the writer
+ * when no reader is inside find (e.g. between frames), or by the destructor.
+ * K and V must be trivially copyable, find copies the value out.
+ * insert and reserve abort beyond a capacity of 2^31 slots.
+ **/
+template <typename K, typename V, typename U, typename KeyHash = Hash<K>, typename KeyEqual = EqualTo<K>>
+class ConcurrentHashMap final {
+ public:
+  ConcurrentHashMap(AllocatorCallbacks<U> allocator_callbacks, const uint32_t initial_capacity = 0);
+  ~ConcurrentHashMap();
+  uint32_t size() const { return size_.load(std::memory_order_relaxed); }
+  uint32_t capacity() const { return table_.load(std::memory_order_acquire)->capacity; }
+  bool empty() const { return size() == 0; }
+  /**
+   * thread safe, copies the value of key to value when found.
+   **/
+  bool find(const K, V* value) const;
+  bool contains(const K) const;
+  /**
+   * writer only.
+   **/
+  void insert(const K, const V);
+  void erase(const K);
+  void clear();
+  void reserve(const uint32_t n);
+  void collect_retired_tables();
+  constexpr bool has_retired_tables() const { return retired_tables_ != nullptr; }
+ private:
+  static_assert(std::is_trivially_copyable_v<K> && std::is_trivially_copyable_v<V>);
+  static constexpr uint32_t kKeyWordNum = (sizeof(K) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+  static constexpr uint32_t kValueWordNum = (sizeof(V) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+  static constexpr uint32_t kMinCapacity = 8;
+  static constexpr uint32_t kMaxCapacity = PowerOfTwoCapacity::kMaxCapacity;
+  struct Table {
+    std::atomic<uint32_t> sequence; // odd while the writer modifies slots.
+    uint32_t capacity; // power of two.
+    Table* retired_next;
+    uint8_t* occupied_flags;
+    uint64_t* key_words;
+    uint64_t* value_words;
+  };
+  /**
+   * a reader seeing any slot store also sees the odd sequence stored before it,
+   * which orders the seqlock without fences (free on x86).
+   **/
+  static uint64_t LoadWord(uint64_t* word) { return std::atomic_ref<uint64_t>(*word).load(std::memory_order_acquire); }
+  static void StoreWord(uint64_t* word, const uint64_t val) { std::atomic_ref<uint64_t>(*word).store(val, std::memory_order_release); }
+  static bool IsOccupied(const Table* table, const uint32_t index) { return std::atomic_ref<uint8_t>(table->occupied_flags[index]).load(std::memory_order_acquire) != 0; }
+  static void SetOccupied(Table* table, const uint32_t index, const bool occupied) { std::atomic_ref<uint8_t>(table->occupied_flags[index]).store(occupied ? 1 : 0, std::memory_order_release); }
+  template <typename T, uint32_t word_num>
+  static T LoadSlot(uint64_t* words) {
+    uint64_t buffer[word_num];
+    for (uint32_t i = 0; i < word_num; i++) {
+      buffer[i] = LoadWord(&words[i]);
+    }
+    T val;
+    memcpy(&val, buffer, sizeof(T));
+    return val;
+  }
+  template <typename T, uint32_t word_num>
+  static void StoreSlot(uint64_t* words, const T& val) {
+    uint64_t buffer[word_num]{};
+    memcpy(buffer, &val, sizeof(T));
+    for (uint32_t i = 0; i < word_num; i++) {
+      StoreWord(&words[i], buffer[i]);
+    }
+  }
+  static K LoadKey(const Table* table, const uint32_t index) { return LoadSlot<K, kKeyWordNum>(&table->key_words[index * kKeyWordNum]); }
+  static V LoadValue(const Table* table, const uint32_t index) { return LoadSlot<V, kValueWordNum>(&table->value_words[index * kValueWordNum]); }
+  static void StoreKey(Table* table, const uint32_t index, const K& key) { StoreSlot<K, kKeyWordNum>(&table->key_words[index * kKeyWordNum], key); }
+  static void StoreValue(Table* table, const uint32_t index, const V& value) { StoreSlot<V, kValueWordNum>(&table->value_words[index * kValueWordNum], value); }
+  static void BeginWrite(Table* table);
+  static void EndWrite(Table* table);
+  /**
+   * writer only, returns the slot of key or the empty slot to insert key at.
+   **/
+  static uint32_t FindSlotIndex(const Table*, const K, const uint64_t hash);
+  Table* allocate_table(const uint32_t capacity);
+  void change_capacity(const uint32_t new_capacity);
+  AllocatorCallbacks<U> allocator_callbacks_;
+  std::atomic<Table*> table_{};
+  std::atomic<uint32_t> size_{};
+  Table* retired_tables_{}; // accessed by the writer only.
+  ConcurrentHashMap() = delete;
+  ConcurrentHashMap(const ConcurrentHashMap&) = delete;
+  void operator=(const ConcurrentHashMap&) = delete;
+};
+template <typename K, typename V, typename U, typename H, typename E>
+ConcurrentHashMap<K, V, U, H, E>::ConcurrentHashMap(AllocatorCallbacks<U> allocator_callbacks, const uint32_t initial_capacity)
+    : allocator_callbacks_(allocator_callbacks)
+{
+  table_.store(allocate_table(GetLargerOrEqualPowerOfTwo(initial_capacity < kMinCapacity ? kMinCapacity : initial_capacity)), std::memory_order_release);
+}
+template <typename K, typename V, typename U, typename H, typename E>
+ConcurrentHashMap<K, V, U, H, E>::~ConcurrentHashMap() {
+  collect_retired_tables();
+  const auto table = table_.exchange(nullptr, std::memory_order_relaxed);
+  if (table != nullptr) {
+    allocator_callbacks_.deallocate(table, allocator_callbacks_.user_context);
+  }
+}
+template <typename K, typename V, typename U, typename H, typename E>
+bool ConcurrentHashMap<K, V, U, H, E>::find(const K key, V* value) const {
+  const auto hash = static_cast<uint64_t>(H{}(key));
+  while (true) {
+    const auto table = table_.load(std::memory_order_acquire);
+    const auto sequence = table->sequence.load(std::memory_order_acquire);
+    if (sequence & 1) { continue; }
+    const auto mask = table->capacity - 1;
+    auto index = static_cast<uint32_t>(hash) & mask;
+    bool found = false;
+    // bounded as slots read during a write may look all occupied.
+    for (uint32_t i = 0; i < table->capacity; i++) {
+      if (!IsOccupied(table, index)) { break; }
+      if (E{}(LoadKey(table, index), key)) {
+        found = true;
+        break;
+      }
+      index = (index + 1) & mask;
+    }
+    uint64_t value_words[kValueWordNum];
+    if (found && value != nullptr) {
+      for (uint32_t i = 0; i < kValueWordNum; i++) {
+        value_words[i] = LoadWord(&table->value_words[index * kValueWordNum + i]);
+      }
+    }
+    if (table->sequence.load(std::memory_order_relaxed) != sequence) { continue; }
+    if (found && value != nullptr) {
+      memcpy(value, value_words, sizeof(V));
+    }
+    return found;
+  }
+}
+template <typename K, typename V, typename U, typename H, typename E>
+bool ConcurrentHashMap<K, V, U, H, E>::contains(const K key) const {
+  return find(key, nullptr);
+}
+template <typename K, typename V, typename U, typename H, typename E>
+void ConcurrentHashMap<K, V, U, H, E>::insert(const K key, const V value) {
+  const auto hash = static_cast<uint64_t>(H{}(key));
+  auto table = table_.load(std::memory_order_relaxed);
+  auto index = FindSlotIndex(table, key, hash);
+  const auto found = IsOccupied(table, index);
+  if (!found && IsCloseToFull(size() + 1, table->capacity)) {
+    if (table->capacity >= kMaxCapacity) { abort(); }
+    change_capacity(table->capacity * 2);
+    table = table_.load(std::memory_order_relaxed);
+    index = FindSlotIndex(table, key, hash);
+  }
+  BeginWrite(table);
+  if (!found) {
+    StoreKey(table, index, key);
+    SetOccupied(table, index, true);
+  }
+  StoreValue(table, index, value);
+  EndWrite(table);
+  if (!found) {
+    size_.store(size() + 1, std::memory_order_relaxed);
+  }
+}
+template <typename K, typename V, typename U, typename H, typename E>
+void ConcurrentHashMap<K, V, U, H, E>::erase(const K key) {
+  const auto table = table_.load(std::memory_order_relaxed);
+  auto i = FindSlotIndex(table, key, static_cast<uint64_t>(H{}(key)));
+  if (!IsOccupied(table, i)) { return; }
+  const auto mask = table->capacity - 1;
+  BeginWrite(table);
+  // backward shift deletion as in HashMap, readers retry instead of seeing the gap.
+  SetOccupied(table, i, false);
+  auto j = i;
+  while (true) {
+    j = (j + 1) & mask;
+    if (!IsOccupied(table, j)) { break; }
+    const auto key_j = LoadKey(table, j);
+    const auto k = static_cast<uint32_t>(H{}(key_j)) & mask;
+    if (i <= j ? (i < k && k <= j) : (i < k || k <= j)) { continue; }
+    StoreKey(table, i, key_j);
+    StoreValue(table, i, LoadValue(table, j));
+    SetOccupied(table, i, true);
+    SetOccupied(table, j, false);
+    i = j;
+  }
+  EndWrite(table);
+  size_.store(size() - 1, std::memory_order_relaxed);
+}
+template <typename K, typename V, typename U, typename H, typename E>
+void ConcurrentHashMap<K, V, U, H, E>::clear() {
+  const auto table = table_.load(std::memory_order_relaxed);
+  BeginWrite(table);
+  for (uint32_t i = 0; i < table->capacity; i++) {
+    SetOccupied(table, i, false);
+  }
+  EndWrite(table);
+  size_.store(0, std::memory_order_relaxed);
+}
+template <typename K, typename V, typename U, typename H, typename E>
+void ConcurrentHashMap<K, V, U, H, E>::reserve(const uint32_t n) {
+  auto new_capacity = table_.load(std::memory_order_relaxed)->capacity;
+  while (IsCloseToFull(n, new_capacity)) {
+    if (new_capacity >= kMaxCapacity) { abort(); }
+    new_capacity *= 2;
+  }
+  change_capacity(new_capacity);
+}
+template <typename K, typename V, typename U, typename H, typename E>
+void ConcurrentHashMap<K, V, U, H, E>::collect_retired_tables() {
+  while (retired_tables_ != nullptr) {
+    const auto next = retired_tables_->retired_next;
+    allocator_callbacks_.deallocate(retired_tables_, allocator_callbacks_.user_context);
+    retired_tables_ = next;
+  }
+}
+template <typename K, typename V, typename U, typename H, typename E>
+void ConcurrentHashMap<K, V, U, H, E>::BeginWrite(Table* table) {
+  table->sequence.store(table->sequence.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+template <typename K, typename V, typename U, typename H, typename E>
+void ConcurrentHashMap<K, V, U, H, E>::EndWrite(Table* table) {
+  table->sequence.store(table->sequence.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+template <typename K, typename V, typename U, typename H, typename E>
+uint32_t ConcurrentHashMap<K, V, U, H, E>::FindSlotIndex(const Table* table, const K key, const uint64_t hash) {
+  const auto mask = table->capacity - 1;
+  auto index = static_cast<uint32_t>(hash) & mask;
+  while (IsOccupied(table, index) && !E{}(LoadKey(table, index), key)) {
+    index = (index + 1) & mask;
+  }
+  return index;
+}
+template <typename K, typename V, typename U, typename H, typename E>
+typename ConcurrentHashMap<K, V, U, H, E>::Table* ConcurrentHashMap<K, V, U, H, E>::allocate_table(const uint32_t capacity) {
+  // [table][flags][key words][value words] in a single allocation, each starting at a cache line.
+  auto get_array_size = [capacity](const uint64_t element_size) { return (element_size * capacity + kCacheLineSize - 1) & ~static_cast<uint64_t>(kCacheLineSize - 1); };
+  const auto table_size = Align(sizeof(Table), kCacheLineSize);
+  const auto flags_size = get_array_size(sizeof(uint8_t));
+  const auto keys_size = get_array_size(sizeof(uint64_t) * kKeyWordNum);
+  const auto values_size = get_array_size(sizeof(uint64_t) * kValueWordNum);
+  auto buffer = static_cast<uint8_t*>(allocator_callbacks_.allocate(GetAllocationSize(table_size + flags_size + keys_size + values_size, 1), kCacheLineSize, allocator_callbacks_.user_context));
+  auto table = new (buffer) Table{};
+  table->capacity = capacity;
+  table->occupied_flags = buffer + table_size;
+  table->key_words = reinterpret_cast<uint64_t*>(buffer + table_size + flags_size);
+  table->value_words = reinterpret_cast<uint64_t*>(buffer + table_size + flags_size + keys_size);
+  memset(table->occupied_flags, 0, flags_size);
+  return table;
+}
+template <typename K, typename V, typename U, typename H, typename E>
+void ConcurrentHashMap<K, V, U, H, E>::change_capacity(const uint32_t new_capacity) {
+  const auto prev_table = table_.load(std::memory_order_relaxed);
+  if (prev_table->capacity >= new_capacity) { return; }
+  // the new table is private until published, readers keep reading prev_table meanwhile.
+  auto table = allocate_table(new_capacity);
+  for (uint32_t i = 0; i < prev_table->capacity; i++) {
+    if (!IsOccupied(prev_table, i)) { continue; }
+    const auto key = LoadKey(prev_table, i);
+    const auto index = FindSlotIndex(table, key, static_cast<uint64_t>(H{}(key)));
+    StoreKey(table, index, key);
+    StoreValue(table, index, LoadValue(prev_table, i));
+    SetOccupied(table, index, true);
+  }
+  table_.store(table, std::memory_order_release);
+  prev_table->retired_next = retired_tables_;
+  retired_tables_ = prev_table;
+}
+} // namespace tote
@@ -0,0 +1,255 @@
+#pragma once
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <new>
+#include <string.h>
+#include <type_traits>
+#include <utility>
+#include "hash_map.h"
+namespace tote {
+/**
+ * HashMap holding up to N entries inline without any allocation.
+ * shares interface with HashMap except for allocator callbacks and growth.
+ * slots are linearly probed in a power of two table kept below 4/5 load,
+ * hence KeyHash must mix well into low bits.
+ * insertion into a full map fails and returns nullptr as value,
+ * operator[] must not be called with a new key on a full map.
+ * K and V are copied with assignment and must be trivially copyable.
+ **/
+template <typename K, typename V, uint32_t N, typename KeyHash = Hash<K>, typename KeyEqual = EqualTo<K>>
+class FixedHashMap final {
+ public:
+  using SimpleIteratorFunction = void (*)(const K, V*);
+  using ConstSimpleIteratorFunction = void (*)(const K, const V*);
+  template <typename T>
+  using IteratorFunction = void (*)(T*, const K, V*);
+  template <typename T>
+  using ConstIteratorFunction = void (*)(T*, const K, const V*);
+
+  FixedHashMap() { clear(); }
+  constexpr uint32_t size() const { return size_; }
+  constexpr uint32_t capacity() const { return N; }
+  constexpr bool empty() const { return size() == 0; }
+  constexpr bool full() const { return size() == N; }
+  /**
+   * clear entries and reset size to zero.
+   * destructor for T is not called.
+   **/
+  void clear();
+  using InsertResult = HashMapInsertResult<V>;
+  void insert(const K, V);
+  /**
+   * try_emplace constructs V from args only when key is not found.
+   **/
+  template <typename... Args> InsertResult try_emplace(const K, Args&&...);
+  InsertResult insert_or_assign(const K, V);
+  V* find(const K);
+  const V* find(const K) const;
+  void erase(const K);
+  bool contains(const K) const;
+  V& operator[](const K);
+  /**
+   * returns default constructed V for missing key.
+   **/
+  const V& operator[](const K) const;
+  /**
+   * insert (or assign) count entries, stops when the map is full.
+   **/
+  void insert_bulk(const K* keys, const V* values, const uint32_t count);
+  void iterate(SimpleIteratorFunction&&);
+  void iterate(ConstSimpleIteratorFunction&&) const;
+  template <typename T> void iterate(IteratorFunction<T>&&, T*);
+  template <typename T> void iterate(ConstIteratorFunction<T>&&, T*) const;
+  /**
+   * calls f(const K&, V&) for each entry, f may capture and is inlinable unlike iterate.
+   **/
+  template <typename F> void for_each(F&&);
+  template <typename F> void for_each(F&&) const;
+  template <bool is_const>
+  class Iterator final {
+   public:
+    using iterator_category = std::forward_iterator_tag;
+    using difference_type = std::ptrdiff_t;
+    using value_type = HashMapEntryReference<K, std::conditional_t<is_const, const V, V>>;
+    using reference = value_type;
+    Iterator() = default;
+    reference operator*() const { return {map_->keys_[index_], const_cast<FixedHashMap*>(map_)->values_[index_]}; }
+    Iterator& operator++() {
+      index_ = map_->find_occupied_index(index_ + 1);
+      return *this;
+    }
+    Iterator operator++(int) {
+      auto prev = *this;
+      ++*this;
+      return prev;
+    }
+    bool operator==(const Iterator& other) const { return index_ == other.index_; }
+   private:
+    friend class FixedHashMap;
+    Iterator(const FixedHashMap* map, const uint32_t index) : map_(map), index_(index) {}
+    const FixedHashMap* map_{};
+    uint32_t index_{};
+  };
+  using iterator = Iterator<false>;
+  using const_iterator = Iterator<true>;
+  /**
+   * iterators skip empty slots and are invalidated by insertion or erase.
+   **/
+  iterator begin() { return {this, find_occupied_index(0)}; }
+  iterator end() { return {this, kCapacity}; }
+  const_iterator begin() const { return {this, find_occupied_index(0)}; }
+  const_iterator end() const { return {this, kCapacity}; }
+ private:
+  static constexpr uint32_t kCapacity = std::bit_ceil(N + N / 4 + 1);
+  static constexpr uint32_t get_home_index(const K key) { return static_cast<uint32_t>(KeyHash{}(key)) & (kCapacity - 1); }
+  static constexpr uint32_t get_next_index(const uint32_t index) { return (index + 1) & (kCapacity - 1); }
+  uint32_t find_slot_index(const K) const;
+  uint32_t find_occupied_index(uint32_t index) const;
+  uint32_t size_;
+  bool occupied_flags_[kCapacity];
+  K keys_[kCapacity];
+  V values_[kCapacity];
+  static_assert(N > 0);
+  static_assert(std::is_trivially_copyable_v<K> && std::is_trivially_copyable_v<V>);
+};
+template <typename K, typename V, uint32_t N, typename H, typename E>
+void FixedHashMap<K, V, N, H, E>::clear() {
+  memset(occupied_flags_, 0, sizeof(occupied_flags_));
+  size_ = 0;
+}
+template <typename K, typename V, uint32_t N, typename H, typename E>
+void FixedHashMap<K, V, N, H, E>::insert(const K key, V value) {
+  insert_or_assign(key, value);
+}
+template <typename K, typename V, uint32_t N, typename H, typename E>
+template <typename... Args>
+typename FixedHashMap<K, V, N, H, E>::InsertResult FixedHashMap<K, V, N, H, E>::try_emplace(const K key, Args&&... args) {
+  const auto index = find_slot_index(key);
+  if (occupied_flags_[index]) {
+    return {&values_[index], false};
+  }
+  if (full()) {
+    return {nullptr, false};
+  }
+  occupied_flags_[index] = true;
+  keys_[index] = key;
+  new (&values_[index]) V(std::forward<Args>(args)...);
+  size_++;
+  return {&values_[index], true};
+}
+template <typename K, typename V, uint32_t N, typename H, typename E>
+typename FixedHashMap<K, V, N, H, E>::InsertResult FixedHashMap<K, V, N, H, E>::insert_or_assign(const K key, V value) {
+  auto result = try_emplace(key, value);
+  if (!result.inserted && result.value != nullptr) {
+    *result.value = value;
+  }
+  return result;
+}
+template <typename K, typename V, uint32_t N, typename H, typename E>
+V* FixedHashMap<K, V, N, H, E>::find(const K key) {
+  const auto index = find_slot_index(key);
+  return occupied_flags_[index] ? &values_[index] : nullptr;
+}
+template <typename K, typename V, uint32_t N, typename H, typename E>
+const V* FixedHashMap<K, V, N, H, E>::find(const K key) const {
+  const auto index = find_slot_index(key);
+  return occupied_flags_[index] ? &values_[index] : nullptr;
+}
+template <typename K, typename V, uint32_t N, typename H, typename E>
+void FixedHashMap<K, V, N, H, E>::insert_bulk(const K* keys, const V* values, const uint32_t count) {
+  for (uint32_t i = 0; i < count; i++) {
+    if (insert_or_assign(keys[i], values[i]).value == nullptr) { return; }
+  }
+}
+template <typename K, typename V, uint32_t N, typename H, typename E>
+void FixedHashMap<K, V, N, H, E>::erase(const K key) {
+  auto i = find_slot_index(key);
+  if (!occupied_flags_[i]) { return; }
+  occupied_flags_[i] = false;
+  // backward shift the following entries which may be placed at the emptied slot.
+  for (auto j = get_next_index(i); occupied_flags_[j]; j = get_next_index(j)) {
+    const auto k = get_home_index(keys_[j]);
+    if (((j - k) & (kCapacity - 1)) < ((j - i) & (kCapacity - 1))) { continue; }
+    occupied_flags_[i] = true;
+    keys_[i] = keys_[j];
+    values_[i] = values_[j];
+    occupied_flags_[j] = false;
+    i = j;
+  }
+  size_--;
+}
+template <typename K, typename V, uint32_t N, typename H, typename E>
+bool FixedHashMap<K, V, N, H, E>::contains(const K key) const {
+  return occupied_flags_[find_slot_index(key)];
+}
+template <typename K, typename V, uint32_t N, typename H, typename E>
+V& FixedHashMap<K, V, N, H, E>::operator[](const K key) {
+  return *try_emplace(key).value;
+}
+template <typename K, typename V, uint32_t N, typename H, typename E>
+const V& FixedHashMap<K, V, N, H, E>::operator[](const K key) const {
+  static const V default_value{};
+  const auto value = find(key);
+  return value ? *value : default_value;
+}
+template <typename K, typename V, uint32_t N, typename H, typename E>
+void FixedHashMap<K, V, N, H, E>::iterate(SimpleIteratorFunction&& f) {
+  for_each([&](const K& key, V& value) { f(key, &value); });
+}
+template <typename K, typename V, uint32_t N, typename H, typename E>
+void FixedHashMap<K, V, N, H, E>::iterate(ConstSimpleIteratorFunction&& f) const {
+  for_each([&](const K& key, const V& value) { f(key, &value); });
+}
+template <typename K, typename V, uint32_t N, typename H, typename E>
+template <typename T>
+void FixedHashMap<K, V, N, H, E>::iterate(IteratorFunction<T>&& f, T* entity) {
+  for_each([&](const K& key, V& value) { f(entity, key, &value); });
+}
+template <typename K, typename V, uint32_t N, typename H, typename E>
+template <typename T>
+void FixedHashMap<K, V, N, H, E>::iterate(ConstIteratorFunction<T>&& f, T* entity) const {
+  for_each([&](const K& key, const V& value) { f(entity, key, &value); });
+}
+template <typename K, typename V, uint32_t N, typename H, typename E>
+template <typename F>
+void FixedHashMap<K, V, N, H, E>::for_each(F&& f) {
+  for (auto i = find_occupied_index(0); i < kCapacity; i = find_occupied_index(i + 1)) {
+    f(static_cast<const K&>(keys_[i]), values_[i]);
+  }
+}
+template <typename K, typename V, uint32_t N, typename H, typename E>
+template <typename F>
+void FixedHashMap<K, V, N, H, E>::for_each(F&& f) const {
+  for (auto i = find_occupied_index(0); i < kCapacity; i = find_occupied_index(i + 1)) {
+    f(static_cast<const K&>(keys_[i]), static_cast<const V&>(values_[i]));
+  }
+}
+template <typename K, typename V, uint32_t N, typename H, typename E>
+uint32_t FixedHashMap<K, V, N, H, E>::find_slot_index(const K key) const {
+  // load is kept below capacity, an empty slot always ends the probe.
+  auto index = get_home_index(key);
+  while (occupied_flags_[index] && !E{}(keys_[index], key)) {
+    index = get_next_index(index);
+  }
+  return index;
+}
+template <typename K, typename V, uint32_t N, typename H, typename E>
+uint32_t FixedHashMap<K, V, N, H, E>::find_occupied_index(uint32_t index) const {
+  static_assert(sizeof(occupied_flags_[0]) == 1);
+  // sparse tables are skipped a word of flags at a time.
+  while (index + sizeof(uint64_t) <= kCapacity) {
+    uint64_t word;
+    memcpy(&word, &occupied_flags_[index], sizeof(word));
+    if (word != 0) {
+      return index + GetFirstSetByteIndex(word);
+    }
+    index += sizeof(word);
+  }
+  while (index < kCapacity && !occupied_flags_[index]) {
+    index++;
+  }
+  return index;
+}
+} // namespace tote
@@ -1,13 +1,167 @@
 #pragma once
+#include <bit>
+#include <cstddef>
 #include <cstdint>
+#include <iterator>
+#include <new>
 #include <string.h>
+#include <string_view>
+#include <type_traits>
 #include <utility>
 #include "allocator_callbacks.h"
+#include "task_callbacks.h"
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
 namespace tote {
+bool IsPrimeNumber(const uint32_t);
+/**
+ * capacity helpers saturate at the largest prime number and power of two in 32 bits.
+ **/
+uint32_t GetLargerOrEqualPrimeNumber(const uint32_t);
+bool IsCloseToFull(const uint32_t load, const uint32_t capacity);
+uint32_t GetMinCapacityNotCloseToFull(const uint32_t load);
+uint32_t Align(const uint32_t val, const uint32_t alignment);
+constexpr uint32_t kCacheLineSize = 64;
+uint32_t GetGrownCapacity(const uint32_t capacity, const uint32_t numerator, const uint32_t denominator);
+uint32_t GetLargerOrEqualPowerOfTwo(const uint32_t);
+uint64_t HashBytes(const void* data, const uint32_t size);
+/**
+ * hint to bring the cache line at address into all cache levels for reading.
+ **/
+inline void PrefetchForRead(const void* address) {
+#if defined(_MSC_VER) && !defined(__clang__) && (defined(_M_X64) || defined(_M_IX86))
+  _mm_prefetch(static_cast<const char*>(address), _MM_HINT_T0);
+#elif defined(_MSC_VER) && !defined(__clang__)
+  __prefetch(address);
+#else
+  __builtin_prefetch(address, 0, 3);
+#endif
+}
+/**
+ * finalizers from MurmurHash3 to spread low entropy keys over all bits.
+ **/
+constexpr uint32_t MixHash(uint32_t h) {
+  h ^= h >> 16;
+  h *= 0x85ebca6bU;
+  h ^= h >> 13;
+  h *= 0xc2b2ae35U;
+  h ^= h >> 16;
+  return h;
+}
+constexpr uint64_t MixHash(uint64_t h) {
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ULL;
+  h ^= h >> 33;
+  return h;
+}
+/**
+ * default hash functor for integral, enum and pointer keys.
+ * specialize or pass another functor for other key types.
+ **/
+template <typename K>
+struct Hash {
+  static_assert(std::is_integral_v<K> || std::is_enum_v<K> || std::is_pointer_v<K>, "pass a hash functor for this key type.");
+  constexpr auto operator()(const K key) const {
+    if constexpr (std::is_pointer_v<K>) {
+      return Hash<uintptr_t>{}(reinterpret_cast<uintptr_t>(key));
+    } else if constexpr (sizeof(K) <= sizeof(uint32_t)) {
+      return MixHash(static_cast<uint32_t>(key));
+    } else {
+      return MixHash(static_cast<uint64_t>(key));
+    }
+  }
+};
+template <>
+struct Hash<std::string_view> {
+  uint64_t operator()(const std::string_view key) const { return HashBytes(key.data(), static_cast<uint32_t>(key.size())); }
+};
+template <typename K>
+struct EqualTo {
+  constexpr bool operator()(const K& a, const K& b) const { return a == b; }
+};
+/**
+ * value slot of the entry and whether it was newly inserted.
+ * the pointer is invalidated by following insertion or erase.
+ **/
+template <typename V>
+struct HashMapInsertResult {
+  V* value;
+  bool inserted;
+};
+/**
+ * dereferenced hash map iterator, valid until following insertion or erase.
+ **/
+template <typename K, typename V>
+struct HashMapEntryReference {
+  const K& key;
+  V& value;
+};
+/**
+ * index of the first byte set in a word of flags read in memory order.
+ **/
+constexpr uint32_t GetFirstSetByteIndex(const uint64_t word) {
+  if constexpr (std::endian::native == std::endian::little) {
+    return static_cast<uint32_t>(std::countr_zero(word)) / 8;
+  } else {
+    return static_cast<uint32_t>(std::countl_zero(word)) / 8;
+  }
+}
+/**
+ * snapshot returned by HashMap::stats() when TOTE_ENABLE_HASH_MAP_STATISTICS is defined.
+ * probe length is the distance from the slot a key hashes to to the slot it is stored in.
+ * a cluster is a run of occupied slots.
+ **/
+constexpr uint32_t kHashMapProbeHistogramSize = 16;
+struct HashMapStatistics {
+  uint32_t size;
+  uint32_t capacity;
+  float load_factor;
+  float average_probe_length;
+  uint32_t max_probe_length;
+  uint32_t probe_length_histogram[kHashMapProbeHistogramSize]; // last bucket also counts longer probes.
+  uint32_t cluster_count;
+  uint32_t max_cluster_size;
+  float average_cluster_size;
+  uint32_t rehash_count;
+  uint64_t rehash_bytes_moved;
+};
+/**
+ * capacity is a prime number grown geometrically by numerator/denominator,
+ * which keeps amortized insertion cost O(1).
+ **/
+template <uint32_t numerator = 2, uint32_t denominator = 1>
+struct PrimeNumberCapacity {
+  static_assert(numerator > denominator);
+  static uint32_t GetInitialCapacity(const uint32_t capacity) { return GetLargerOrEqualPrimeNumber(capacity); }
+  static uint32_t GetNextCapacity(const uint32_t capacity) { return GetLargerOrEqualPrimeNumber(GetGrownCapacity(capacity, numerator, denominator)); }
+  template <typename H>
+  static uint32_t GetIndex(const H hash, const uint32_t capacity) { return static_cast<uint32_t>(hash % capacity); }
+};
+/**
+ * capacity is a power of two doubled on each resize.
+ * slot index is computed with a bit mask instead of a division,
+ * which relies on the hash functor mixing well into low bits.
+ **/
+struct PowerOfTwoCapacity {
+  static constexpr uint32_t kMaxCapacity = 1U << 31;
+  static uint32_t GetInitialCapacity(const uint32_t capacity) { return GetLargerOrEqualPowerOfTwo(capacity < 2 ? 2 : capacity); }
+  static uint32_t GetNextCapacity(const uint32_t capacity) { return capacity < 2 ? 2 : capacity < kMaxCapacity ? capacity * 2 : kMaxCapacity; }
+  template <typename H>
+  static uint32_t GetIndex(const H hash, const uint32_t capacity) { return static_cast<uint32_t>(hash) & (capacity - 1); }
+};
 /**
  * HashMap using open addressing.
+ * K and V are copied with assignment and must be trivially copyable.
+ * flags, keys and values are carved from a single cache line aligned allocation.
+ * with interleave_key_value, key and value of a slot are stored next to each other,
+ * which suits small V as a hit touches only one cache line.
+ * slot count is 32-bit while the table is sized in SizeType, which may exceed 4 GB with TOTE_ENABLE_64BIT_SIZE.
+ * insertion aborts when CapacityPolicy cannot grow the table any further.
  **/
-template <typename K, typename V, typename U>
+template <typename K, typename V, typename U, typename CapacityPolicy = PrimeNumberCapacity<>, typename KeyHash = Hash<K>, typename KeyEqual = EqualTo<K>, bool interleave_key_value = false>
 class HashMap final {
  public:
   using SimpleIteratorFunction = void (*)(const K, V*);
@@ -34,132 +188,424 @@ class HashMap final {
    * destructor for T is not called.
    **/
   void release_allocated_buffer();
+  using InsertResult = HashMapInsertResult<V>;
   void insert(const K, V);
+  /**
+   * following functions probe the table once unless a resize is required.
+   * try_emplace constructs V from args only when key is not found.
+   **/
+  template <typename... Args> InsertResult try_emplace(const K, Args&&...);
+  InsertResult insert_or_assign(const K, V);
+  V* find(const K);
+  const V* find(const K) const;
+  /**
+   * find for each of count keys, writing the value or nullptr to values[i].
+   * home slots of a block of keys are hashed first,
+   * and the slot prefetch_distance keys ahead is prefetched while resolving each probe,
+   * which overlaps cache misses of independent lookups on tables larger than the cache.
+   * zero prefetch_distance disables prefetch.
+   **/
+  void find_batch(const K* keys, const uint32_t count, V** values, const uint32_t prefetch_distance = kDefaultPrefetchDistance);
+  void find_batch(const K* keys, const uint32_t count, const V** values, const uint32_t prefetch_distance = kDefaultPrefetchDistance) const;
+  static constexpr uint32_t kDefaultPrefetchDistance = 16;
   void erase(const K);
   bool contains(const K) const;
   V& operator[](const K);
+  /**
+   * returns default constructed V for missing key.
+   **/
   const V& operator[](const K) const;
+  /**
+   * grow capacity so that n entries can be held without resize.
+   **/
+  void reserve(const uint32_t n);
+  /**
+   * resize at most once and insert (or assign) count entries without per-entry load check.
+   * completes a pending incremental rehash.
+   **/
+  void insert_bulk(const K* keys, const V* values, const uint32_t count);
+  /**
+   * parallel versions of reserve and insert_bulk for large tables.
+   * the table is split into ranges of home slots, one per task,
+   * and each task inserts entries hashed to its range without synchronization.
+   * entries whose probe runs past the end of the range are inserted serially afterwards.
+   * for the same key, the last entry in keys is kept as in insert_bulk.
+   **/
+  template <typename T> void reserve(const uint32_t n, const TaskCallbacks<T>& task_callbacks);
+  template <typename T> void insert_bulk(const K* keys, const V* values, const uint32_t count, const TaskCallbacks<T>& task_callbacks);
+  /**
+   * with a non-zero budget, growth keeps the previous table and migrates
+   * at least budget entries from it on each insertion or erase,
+   * which bounds the latency of an insertion triggering growth.
+   * lookups search both tables meanwhile.
+   * zero (default) rehashes every entry at once.
+   **/
+  void set_rehash_budget(const uint32_t budget) { rehash_budget_ = budget; }
+  constexpr bool is_rehashing() const { return draining_capacity_ > 0; }
+  /**
+   * migrate at least budget entries of a pending incremental rehash, e.g. in idle time.
+   **/
+  void step_rehash(const uint32_t budget);
   void iterate(SimpleIteratorFunction&&);
   void iterate(ConstSimpleIteratorFunction&&) const;
   template <typename T> void iterate(IteratorFunction<T>&&, T*);
   template <typename T> void iterate(ConstIteratorFunction<T>&&, T*) const;
+  /**
+   * calls f(const K&, V&) for each entry, f may capture and is inlinable unlike iterate.
+   **/
+  template <typename F> void for_each(F&&);
+  template <typename F> void for_each(F&&) const;
+  template <bool is_const>
+  class Iterator final {
+   public:
+    using iterator_category = std::forward_iterator_tag;
+    using difference_type = std::ptrdiff_t;
+    using value_type = HashMapEntryReference<K, std::conditional_t<is_const, const V, V>>;
+    using reference = value_type;
+    Iterator() = default;
+    reference operator*() const { return {map_->any_key_at(index_), map_->any_value_at(index_)}; }
+    Iterator& operator++() {
+      index_ = map_->find_occupied_index(index_ + 1);
+      return *this;
+    }
+    Iterator operator++(int) {
+      auto prev = *this;
+      ++*this;
+      return prev;
+    }
+    bool operator==(const Iterator& other) const { return index_ == other.index_; }
+   private:
+    friend class HashMap;
+    Iterator(const HashMap* map, const uint32_t index) : map_(map), index_(index) {}
+    const HashMap* map_{};
+    uint32_t index_{};
+  };
+  using iterator = Iterator<false>;
+  using const_iterator = Iterator<true>;
+  /**
+   * iterators skip empty slots and are invalidated by insertion or erase.
+   **/
+  iterator begin() { return {this, find_occupied_index(0)}; }
+  iterator end() { return {this, capacity_ + draining_capacity_}; }
+  const_iterator begin() const { return {this, find_occupied_index(0)}; }
+  const_iterator end() const { return {this, capacity_ + draining_capacity_}; }
+#ifdef TOTE_ENABLE_HASH_MAP_STATISTICS
+  /**
+   * scans the whole table, meant for diagnosing slow maps.
+   * entries not yet migrated by an incremental rehash are not included.
+   **/
+  HashMapStatistics stats() const;
+#endif
  private:
+  static constexpr uint32_t kNotFound = ~0U;
+  static uint32_t FindOccupiedIndex(const bool* occupied_flags, const uint32_t capacity, uint32_t index);
   uint32_t find_slot_index(const K) const;
+  uint32_t find_slot_index_from(uint32_t index, const K) const;
+  const V* find_from(const uint32_t home, const K) const;
+  /**
+   * index across the table followed by the draining table.
+   **/
+  uint32_t find_occupied_index(uint32_t index) const;
+  constexpr uint32_t get_next_index(const uint32_t index) const { return index + 1 < capacity_ ? index + 1 : 0; }
   bool check_load_factor_and_resize();
   void change_capacity(const uint32_t new_capacity);
+  void allocate_table(const uint32_t new_capacity);
+  /**
+   * inserts get_entry(i) for i in [0, count) in parallel, skipping nullptr keys.
+   * get_entry(i) returns a pair of key and value pointers and is called from tasks.
+   **/
+  template <typename T, typename F> void insert_parallel(const uint32_t count, F&& get_entry, const TaskCallbacks<T>& task_callbacks);
   void insert_impl(const uint32_t, const K, V value);
+  uint32_t find_draining_slot_index(const K) const;
+  uint32_t migrate_draining_cluster(const uint32_t index);
+  void release_draining_buffer();
+  struct Entry {
+    K key;
+    V value;
+  };
+  static_assert(alignof(K) <= kCacheLineSize && alignof(V) <= kCacheLineSize);
+  K& key_at(const uint32_t index) const {
+    if constexpr (interleave_key_value) { return entries_[index].key; } else { return keys_[index]; }
+  }
+  V& value_at(const uint32_t index) const {
+    if constexpr (interleave_key_value) { return entries_[index].value; } else { return values_[index]; }
+  }
+  K& draining_key_at(const uint32_t index) const {
+    if constexpr (interleave_key_value) { return draining_entries_[index].key; } else { return draining_keys_[index]; }
+  }
+  V& draining_value_at(const uint32_t index) const {
+    if constexpr (interleave_key_value) { return draining_entries_[index].value; } else { return draining_values_[index]; }
+  }
+  K& any_key_at(const uint32_t index) const { return index < capacity_ ? key_at(index) : draining_key_at(index - capacity_); }
+  V& any_value_at(const uint32_t index) const { return index < capacity_ ? value_at(index) : draining_value_at(index - capacity_); }
   AllocatorCallbacks<U> allocator_callbacks_;
-  bool* occupied_flags_{};
+  bool* occupied_flags_{}; // head of the allocated buffer.
   K* keys_{};
   V* values_{};
+  Entry* entries_{}; // used instead of keys_ and values_ with interleave_key_value.
   uint32_t size_{};
   uint32_t capacity_{}; // always >0 for simple implementation.
+  // previous table during incremental rehash, emptied a whole cluster at a time
+  // so that lookups of the remaining entries stop at the same empty slots as before.
+  bool* draining_occupied_flags_{};
+  K* draining_keys_{};
+  V* draining_values_{};
+  Entry* draining_entries_{};
+  uint32_t draining_capacity_{};
+  uint32_t draining_size_{};
+  uint32_t draining_index_{}; // slots before it are empty.
+  uint32_t rehash_budget_{};
+#ifdef TOTE_ENABLE_HASH_MAP_STATISTICS
+  uint32_t rehash_count_{};
+  uint64_t rehash_bytes_moved_{};
+#endif
   HashMap() = delete;
   HashMap(const HashMap&) = delete;
   void operator=(const HashMap&) = delete;
 };
-bool IsPrimeNumber(const uint32_t);
-uint32_t GetLargerOrEqualPrimeNumber(const uint32_t);
-bool IsCloseToFull(const uint32_t load, const uint32_t capacity);
-uint32_t Align(const uint32_t val, const uint32_t alignment);
-template <typename K, typename V, typename U>
-HashMap<K, V, U>::HashMap(AllocatorCallbacks<U> allocator_callbacks, const uint32_t initial_capacity)
+template <typename K, typename V, typename U, typename P, typename H, typename E, bool I>
+HashMap<K, V, U, P, H, E, I>::HashMap(AllocatorCallbacks<U> allocator_callbacks, const uint32_t initial_capacity)
     : allocator_callbacks_(allocator_callbacks)
     , size_(0)
     , capacity_(0)
 {
-  change_capacity(GetLargerOrEqualPrimeNumber(initial_capacity));
+  change_capacity(P::GetInitialCapacity(initial_capacity));
 }
-template <typename K, typename V, typename U>
-HashMap<K, V, U>::HashMap(HashMap&& other)
+template <typename K, typename V, typename U, typename P, typename H, typename E, bool I>
+HashMap<K, V, U, P, H, E, I>::HashMap(HashMap&& other)
     : allocator_callbacks_(std::move(other.allocator_callbacks_))
     , occupied_flags_(other.occupied_flags_)
     , keys_(other.keys_)
     , values_(other.values_)
+    , entries_(other.entries_)
     , size_(other.size_)
     , capacity_(other.capacity_)
+    , draining_occupied_flags_(other.draining_occupied_flags_)
+    , draining_keys_(other.draining_keys_)
+    , draining_values_(other.draining_values_)
+    , draining_entries_(other.draining_entries_)
+    , draining_capacity_(other.draining_capacity_)
+    , draining_size_(other.draining_size_)
+    , draining_index_(other.draining_index_)
+    , rehash_budget_(other.rehash_budget_)
+#ifdef TOTE_ENABLE_HASH_MAP_STATISTICS
+    , rehash_count_(other.rehash_count_)
+    , rehash_bytes_moved_(other.rehash_bytes_moved_)
+#endif
 {
   other.allocator_callbacks_ = {};
   other.occupied_flags_ = nullptr;
   other.keys_ = nullptr;
   other.values_ = nullptr;
+  other.entries_ = nullptr;
   other.size_ = 0;
   other.capacity_ = 0;
+  other.draining_occupied_flags_ = nullptr;
+  other.draining_keys_ = nullptr;
+  other.draining_values_ = nullptr;
+  other.draining_entries_ = nullptr;
+  other.draining_capacity_ = 0;
+  other.draining_size_ = 0;
+  other.draining_index_ = 0;
 }
-template <typename K, typename V, typename U>
-HashMap<K, V, U>& HashMap<K, V, U>::operator=(HashMap&& other)
+template <typename K, typename V, typename U, typename P, typename H, typename E, bool I>
+HashMap<K, V, U, P, H, E, I>& HashMap<K, V, U, P, H, E, I>::operator=(HashMap&& other)
 {
   if (this != &other) {
-    if (capacity_ > 0) {
-      allocator_callbacks_.deallocate(occupied_flags_, allocator_callbacks_.user_context);
-      allocator_callbacks_.deallocate(keys_, allocator_callbacks_.user_context);
-      allocator_callbacks_.deallocate(values_, allocator_callbacks_.user_context);
-    }
+    release_allocated_buffer();
     allocator_callbacks_ = std::move(other.allocator_callbacks_);
     occupied_flags_ = other.occupied_flags_;
     keys_ = other.keys_;
     values_ = other.values_;
+    entries_ = other.entries_;
     size_ = other.size_;
     capacity_ = other.capacity_;
+    draining_occupied_flags_ = other.draining_occupied_flags_;
+    draining_keys_ = other.draining_keys_;
+    draining_values_ = other.draining_values_;
+    draining_entries_ = other.draining_entries_;
+    draining_capacity_ = other.draining_capacity_;
+    draining_size_ = other.draining_size_;
+    draining_index_ = other.draining_index_;
+    rehash_budget_ = other.rehash_budget_;
+#ifdef TOTE_ENABLE_HASH_MAP_STATISTICS
+    rehash_count_ = other.rehash_count_;
+    rehash_bytes_moved_ = other.rehash_bytes_moved_;
+#endif
     other.allocator_callbacks_ = {};
     other.occupied_flags_ = nullptr;
     other.keys_ = nullptr;
     other.values_ = nullptr;
+    other.entries_ = nullptr;
     other.size_ = 0;
     other.capacity_ = 0;
+    other.draining_occupied_flags_ = nullptr;
+    other.draining_keys_ = nullptr;
+    other.draining_values_ = nullptr;
+    other.draining_entries_ = nullptr;
+    other.draining_capacity_ = 0;
+    other.draining_size_ = 0;
+    other.draining_index_ = 0;
   }
   return *this;
 }
-template <typename K, typename V, typename U>
-HashMap<K, V, U>::~HashMap() {
+template <typename K, typename V, typename U, typename P, typename H, typename E, bool I>
+HashMap<K, V, U, P, H, E, I>::~HashMap() {
   release_allocated_buffer();
 }
-template <typename K, typename V, typename U>
-void HashMap<K, V, U>::clear() {
+template <typename K, typename V, typename U, typename P, typename H, typename E, bool I>
+void HashMap<K, V, U, P, H, E, I>::clear() {
+  release_draining_buffer();
   if (capacity_ > 0) {
     memset(occupied_flags_, 0, sizeof(occupied_flags_[0]) * capacity_);
   }
   size_ = 0;
 }
-template <typename K, typename V, typename U>
-void HashMap<K, V, U>::release_allocated_buffer() {
+template <typename K, typename V, typename U, typename P, typename H, typename E, bool I>
+void HashMap<K, V, U, P, H, E, I>::release_allocated_buffer() {
+  release_draining_buffer();
   if (capacity_ > 0) {
     allocator_callbacks_.deallocate(occupied_flags_, allocator_callbacks_.user_context);
-    allocator_callbacks_.deallocate(keys_, allocator_callbacks_.user_context);
-    allocator_callbacks_.deallocate(values_, allocator_callbacks_.user_context);
+    occupied_flags_ = nullptr;
+    keys_ = nullptr;
+    values_ = nullptr;
+    entries_ = nullptr;
     capacity_ = 0;
   }
   size_ = 0;
 }
-template <typename K, typename V, typename U>
-void HashMap<K, V, U>::insert(const K key, V value) {
+template <typename K, typename V, typename U, typename P, typename H, typename E, bool I>
+void HashMap<K, V, U, P, H, E, I>::insert(const K key, V value) {
+  insert_or_assign(key, value);
+}
+template <typename K, typename V, typename U, typename P, typename H, typename E, bool I>
+template <typename... Args>
+typename HashMap<K, V, U, P, H, E, I>::InsertResult HashMap<K, V, U, P, H, E, I>::try_emplace(const K key, Args&&... args) {
+  if (is_rehashing()) {
+    step_rehash(rehash_budget_);
+  }
   auto index = capacity_ > 0 ? find_slot_index(key) : ~0U;
   if (index != ~0U && occupied_flags_[index]) {
-    values_[index] = value;
-    return;
+    return {&value_at(index), false};
+  }
+  if (is_rehashing()) {
+    const auto draining_index = find_draining_slot_index(key);
+    if (draining_index != kNotFound) {
+      migrate_draining_cluster(draining_index);
+      return {&value_at(find_slot_index(key)), false};
+    }
   }
-  size_++;
   if (check_load_factor_and_resize()) {
     index = find_slot_index(key);
   }
-  insert_impl(index, key, value);
+  size_++;
+  occupied_flags_[index] = true;
+  key_at(index) = key;
+  new (&value_at(index)) V(std::forward<Args>(args)...);
+  return {&value_at(index), true};
+}
+template <typename K, typename V, typename U, typename P, typename H, typename E, bool I>
+typename HashMap<K, V, U, P, H, E, I>::InsertResult HashMap<K, V, U, P, H, E, I>::insert_or_assign(const K key, V value) {
+  auto result = try_emplace(key, value);
+  if (!result.inserted) {
+    *result.value = value;
+  }
+  return result;
+}
+template <typename K, typename V, typename U, typename P, typename H, typename E, bool I>
+V* HashMap<K, V, U, P, H, E, I>::find(const K key) {
+  return const_cast<V*>(static_cast<const HashMap*>(this)->find(key));
+}
+template <typename K, typename V, typename U, typename P, typename H, typename E, bool I>
+const V* HashMap<K, V, U, P, H, E, I>::find(const K key) const {
+  if (size_ == 0) { return nullptr; }
+  return find_from(P::GetIndex(H{}(key), capacity_), key);
+}
+template <typename K, typename V, typename U, typename P, typename H, typename E, bool I>
+const V* HashMap<K, V, U, P, H, E, I>::find_from(const uint32_t home, const K key) const {
+  const auto index = find_slot_index_from(home, key);
+  if (occupied_flags_[index]) { return &value_at(index); }
+  if (!is_rehashing()) { return nullptr; }
+  const auto draining_index = find_draining_slot_index(key);
+  return draining_index != kNotFound ? &draining_value_at(draining_index) : nullptr;
+}
+template <typename K, typename V, typename U, typename P, typename H, typename E, bool I>
+void HashMap<K, V, U, P, H, E, I>::find_batch(const K* keys, const uint32_t count, V** values, const uint32_t prefetch_distance) {
+  static_cast<const HashMap*>(this)->find_batch(keys, count, const_cast<const V**>(values), prefetch_distance);
+}
+template <typename K, typename V, typename U, typename P, typename H, typename E, bool I>
+void HashMap<K, V, U, P, H, E, I>::find_batch(const K* keys, const uint32_t count, const V** values, const uint32_t prefetch_distance) const {
+  if (size_ == 0) {
+    for (uint32_t i = 0; i < count; i++) {
+      values[i] = nullptr;
+    }
+    return;
+  }
+  auto prefetch = [this](const uint32_t index) {
+    PrefetchForRead(&occupied_flags_[index]);
+    PrefetchForRead(&key_at(index));
+  };
+  constexpr uint32_t kBlockSize = 64;
+  uint32_t homes[kBlockSize];
+  for (uint32_t block = 0; block < count; block += kBlockSize) {
+    const auto block_count = count - block < kBlockSize ? count - block : kBlockSize;
+    for (uint32_t i = 0; i < block_count; i++) {
+      homes[i] = P::GetIndex(H{}(keys[block + i]), capacity_);
+      if (i < prefetch_distance) {
+        prefetch(homes[i]);
+      }
+    }
+    for (uint32_t i = 0; i < block_count; i++) {
+      if (i + prefetch_distance < block_count) {
+        prefetch(homes[i + prefetch_distance]);
+      }
+      values[block + i] = find_from(homes[i], keys[block + i]);
+    }
+  }
 }
-template <typename K, typename V, typename U>
-void HashMap<K, V, U>::insert_impl(const uint32_t index, const K key, V value) {
+template <typename K, typename V, typename U, typename P, typename H, typename E, bool I>
+void HashMap<K, V, U, P, H, E, I>::insert_impl(const uint32_t index, const K key, V value) {
   occupied_flags_[index] = true;
-  keys_[index] = key;
-  values_[index] = value;
+  key_at(index) = key;
+  value_at(index) = value;
 }
-template <typename K, typename V, typename U>
-void HashMap<K, V, U>::erase(const K key) {
+template <typename K, typename V, typename U, typename P, typename H, typename E, bool I>
+void HashMap<K, V, U, P, H, E, I>::reserve(const uint32_t n) {
+  change_capacity(P::GetInitialCapacity(GetMinCapacityNotCloseToFull(n)));
+}
+template <typename K, typename V, typename U, typename P, typename H, typename E, bool I>
+void HashMap<K, V, U, P, H, E, I>::insert_bulk(const K* keys, const V* values, const uint32_t count) {
+  // saturated rather than wrapped, which would reserve too little.
+  reserve(count < ~0U - size_ ? size_ + count : ~0U);
+  step_rehash(~0U);
+  for (uint32_t i = 0; i < count; i++) {
+    const auto index = find_slot_index(keys[i]);
+    if (!occupied_flags_[index]) {
+      size_++;
+    }
+    insert_impl(index, keys[i], values[i]);
+  }
+}
+template <typename K, typename V, typename U, typename P, typename H, typename E, bool I>
+void HashMap<K, V, U, P, H, E, I>::erase(const K key) {
+  if (size_ == 0) { return; }
+  if (is_rehashing()) {
+    step_rehash(rehash_budget_);
+  }
   auto i = find_slot_index(key);
-  if (!occupied_flags_[i]) { return; }
+  if (!occupied_flags_[i]) {
+    if (!is_rehashing()) { return; }
+    const auto draining_index = find_draining_slot_index(key);
+    if (draining_index == kNotFound) { return; }
+    migrate_draining_cluster(draining_index);
+    i = find_slot_index(key);
+  }
   occupied_flags_[i] = false;
   auto j = i;
   while (true) {
-    j = (j + 1) % capacity_;
+    j = get_next_index(j);
     if (!occupied_flags_[j]) { break; }
-    auto k = keys_[j] % capacity_;
+    auto k = P::GetIndex(H{}(key_at(j)), capacity_);
     if (i <= j) {
       if (i < k && k <= j) {
         continue;
@@ -170,105 +616,418 @@ void HashMap<K, V, U>::erase(const K key) {
       }
     }
     occupied_flags_[i] = occupied_flags_[j];
-    keys_[i] = keys_[j];
-    values_[i] = values_[j];
+    key_at(i) = key_at(j);
+    value_at(i) = value_at(j);
     occupied_flags_[j] = false;
     i = j;
   }
   size_--;
 }
-template <typename K, typename V, typename U>
-bool HashMap<K, V, U>::contains(const K key) const {
-  if (size_ == 0) { return false; }
-  const auto index = find_slot_index(key);
-  return occupied_flags_[index];
+template <typename K, typename V, typename U, typename P, typename H, typename E, bool I>
+bool HashMap<K, V, U, P, H, E, I>::contains(const K key) const {
+  return find(key) != nullptr;
 }
-template <typename K, typename V, typename U>
-V& HashMap<K, V, U>::operator[](const K key) {
-  if (!contains(key)) {
-    insert(key, {});
-  }
-  const auto index = find_slot_index(key);
-  return values_[index];
+template <typename K, typename V, typename U, typename P, typename H, typename E, bool I>
+V& HashMap<K, V, U, P, H, E, I>::operator[](const K key) {
+  return *try_emplace(key).value;
 }
-template <typename K, typename V, typename U>
-const V& HashMap<K, V, U>::operator[](const K key) const {
-  const auto index = find_slot_index(key);
-  return values_[index];
+template <typename K, typename V, typename U, typename P, typename H, typename E, bool I>
+const V& HashMap<K, V, U, P, H, E, I>::operator[](const K key) const {
+  static const V default_value{};
+  const auto value = find(key);
+  return value ? *value : default_value;
 }
-template <typename K, typename V, typename U>
-void HashMap<K, V, U>::iterate(SimpleIteratorFunction&& f) {
-  for (uint32_t i = 0; i < capacity_; i++) {
-    if (!occupied_flags_[i]) { continue; }
-    f(keys_[i], &values_[i]);
+template <typename K, typename V, typename U, typename P, typename H, typename E, bool I>
+void HashMap<K, V, U, P, H, E, I>::iterate(SimpleIteratorFunction&& f) {
+  for_each([&](const K& key, V& value) { f(key, &value); });
+}
+template <typename K, typename V, typename U, typename P, typename H, typename E, bool I>
+void HashMap<K, V, U, P, H, E, I>::iterate(ConstSimpleIteratorFunction&& f) const {
+  for_each([&](const K& key, const V& value) { f(key, &value); });
+}
+template <typename K, typename V, typename U, typename P, typename H, typename E, bool I>
+template <typename T>
+void HashMap<K, V, U, P, H, E, I>::iterate(IteratorFunction<T>&& f, T* entity) {
+  for_each([&](const K& key, V& value) { f(entity, key, &value); });
+}
+template <typename K, typename V, typename U, typename P, typename H, typename E, bool I>
+template <typename T>
+void HashMap<K, V, U, P, H, E, I>::iterate(ConstIteratorFunction<T>&& f, T* entity) const {
+  for_each([&](const K& key, const V& value) { f(entity, key, &value); });
+}
+template <typename K, typename V, typename U, typename P, typename H, typename E, bool I>
+template <typename F>
+void HashMap<K, V, U, P, H, E, I>::for_each(F&& f) {
+  for (auto i = FindOccupiedIndex(occupied_flags_, capacity_, 0); i < capacity_; i = FindOccupiedIndex(occupied_flags_, capacity_, i + 1)) {
+    f(static_cast<const K&>(key_at(i)), value_at(i));
+  }
+  for (auto i = FindOccupiedIndex(draining_occupied_flags_, draining_capacity_, 0); i < draining_capacity_; i = FindOccupiedIndex(draining_occupied_flags_, draining_capacity_, i + 1)) {
+    f(static_cast<const K&>(draining_key_at(i)), draining_value_at(i));
   }
 }
-template <typename K, typename V, typename U>
-void HashMap<K, V, U>::iterate(ConstSimpleIteratorFunction&& f) const {
-  for (uint32_t i = 0; i < capacity_; i++) {
-    if (!occupied_flags_[i]) { continue; }
-    f(keys_[i], &values_[i]);
+template <typename K, typename V, typename U, typename P, typename H, typename E, bool I>
+template <typename F>
+void HashMap<K, V, U, P, H, E, I>::for_each(F&& f) const {
+  for (auto i = FindOccupiedIndex(occupied_flags_, capacity_, 0); i < capacity_; i = FindOccupiedIndex(occupied_flags_, capacity_, i + 1)) {
+    f(static_cast<const K&>(key_at(i)), static_cast<const V&>(value_at(i)));
+  }
+  for (auto i = FindOccupiedIndex(draining_occupied_flags_, draining_capacity_, 0); i < draining_capacity_; i = FindOccupiedIndex(draining_occupied_flags_, draining_capacity_, i + 1)) {
+    f(static_cast<const K&>(draining_key_at(i)), static_cast<const V&>(draining_value_at(i)));
   }
 }
-template <typename K, typename V, typename U>
-template <typename T>
-void HashMap<K, V, U>::iterate(IteratorFunction<T>&& f, T* entity) {
-  for (uint32_t i = 0; i < capacity_; i++) {
-    if (!occupied_flags_[i]) { continue; }
-    f(entity, keys_[i], &values_[i]);
+template <typename K, typename V, typename U, typename P, typename H, typename E, bool I>
+uint32_t HashMap<K, V, U, P, H, E, I>::FindOccupiedIndex(const bool* occupied_flags, const uint32_t capacity, uint32_t index) {
+  // sparse tables are skipped a word of flags at a time.
+  static_assert(sizeof(occupied_flags[0]) == 1);
+  while (index + sizeof(uint64_t) <= capacity) {
+    uint64_t word;
+    memcpy(&word, &occupied_flags[index], sizeof(word));
+    if (word != 0) {
+      return index + GetFirstSetByteIndex(word);
+    }
+    index += sizeof(word);
   }
+  while (index < capacity && !occupied_flags[index]) {
+    index++;
+  }
+  return index;
 }
-template <typename K, typename V, typename U>
-template <typename T>
-void HashMap<K, V, U>::iterate(ConstIteratorFunction<T>&& f, T* entity) const {
-  for (uint32_t i = 0; i < capacity_; i++) {
-    if (!occupied_flags_[i]) { continue; }
-    f(entity, keys_[i], &values_[i]);
+template <typename K, typename V, typename U, typename P, typename H, typename E, bool I>
+uint32_t HashMap<K, V, U, P, H, E, I>::find_occupied_index(uint32_t index) const {
+  if (index < capacity_) {
+    index = FindOccupiedIndex(occupied_flags_, capacity_, index);
+    if (index < capacity_) { return index; }
   }
+  return capacity_ + FindOccupiedIndex(draining_occupied_flags_, draining_capacity_, index - capacity_);
 }
-template <typename K, typename V, typename U>
-uint32_t HashMap<K, V, U>::find_slot_index(const K key) const {
-  auto index = key % capacity_;
-  while (occupied_flags_[index] && keys_[index] != key) {
-    index = (index + 1) % capacity_;
+template <typename K, typename V, typename U, typename P, typename H, typename E, bool I>
+uint32_t HashMap<K, V, U, P, H, E, I>::find_slot_index(const K key) const {
+  return find_slot_index_from(P::GetIndex(H{}(key), capacity_), key);
+}
+template <typename K, typename V, typename U, typename P, typename H, typename E, bool I>
+uint32_t HashMap<K, V, U, P, H, E, I>::find_slot_index_from(uint32_t index, const K key) const {
+  while (occupied_flags_[index] && !E{}(key_at(index), key)) {
+    index = get_next_index(index);
   }
-  if constexpr (sizeof(K) == 4) { return index; }
-  return static_cast<uint32_t>(index);
+  return index;
 }
-template <typename K, typename V, typename U>
-bool HashMap<K, V, U>::check_load_factor_and_resize() {
-  if (!IsCloseToFull(size_, capacity_)) { return false; }
-  change_capacity(GetLargerOrEqualPrimeNumber(capacity_ + 2));
+template <typename K, typename V, typename U, typename P, typename H, typename E, bool I>
+bool HashMap<K, V, U, P, H, E, I>::check_load_factor_and_resize() {
+  if (!IsCloseToFull(size_ + 1, capacity_)) { return false; }
+  const auto new_capacity = P::GetNextCapacity(capacity_);
+  if (new_capacity <= capacity_) { abort(); }
+  change_capacity(new_capacity);
   return true;
 }
-template <typename K, typename V, typename U>
-void HashMap<K, V, U>::change_capacity(const uint32_t new_capacity) {
+template <typename K, typename V, typename U, typename P, typename H, typename E, bool I>
+void HashMap<K, V, U, P, H, E, I>::change_capacity(const uint32_t new_capacity) {
   if (capacity_ >= new_capacity) { return; }
+  step_rehash(~0U);
   const auto prev_capacity = capacity_;
   const auto prev_size = size_;
   const auto prev_occupied_flags = occupied_flags_;
   const auto prev_keys = keys_;
   const auto prev_values = values_;
-  capacity_ = new_capacity;
-  {
-    occupied_flags_ = static_cast<bool*>(allocator_callbacks_.allocate(sizeof(occupied_flags_[0]) * capacity_, alignof(bool), allocator_callbacks_.user_context));
-    keys_ = static_cast<K*>(allocator_callbacks_.allocate(sizeof(K) * capacity_, alignof(K), allocator_callbacks_.user_context));
-    values_ = static_cast<V*>(allocator_callbacks_.allocate(sizeof(V) * capacity_, alignof(V), allocator_callbacks_.user_context));
+  const auto prev_entries = entries_;
+  auto prev_key_at = [&](const uint32_t index) -> const K& {
+    if constexpr (I) { return prev_entries[index].key; } else { return prev_keys[index]; }
+  };
+  auto prev_value_at = [&](const uint32_t index) -> const V& {
+    if constexpr (I) { return prev_entries[index].value; } else { return prev_values[index]; }
+  };
+  allocate_table(new_capacity);
+  if (rehash_budget_ > 0 && prev_size > 0) {
+    draining_occupied_flags_ = prev_occupied_flags;
+    draining_keys_ = prev_keys;
+    draining_values_ = prev_values;
+    draining_entries_ = prev_entries;
+    draining_capacity_ = prev_capacity;
+    draining_size_ = prev_size;
+    draining_index_ = 0;
+    size_ = prev_size;
+    return;
   }
-  clear();
   for (uint32_t i = 0; i < prev_capacity; i++) {
     if (prev_occupied_flags[i]) {
-      const auto index = find_slot_index(prev_keys[i]);
-      insert_impl(index, prev_keys[i], prev_values[i]);
+      const auto index = find_slot_index(prev_key_at(i));
+      insert_impl(index, prev_key_at(i), prev_value_at(i));
     }
   }
   size_ = prev_size;
   if (prev_capacity > 0) {
     allocator_callbacks_.deallocate(prev_occupied_flags, allocator_callbacks_.user_context);
-    allocator_callbacks_.deallocate(prev_keys, allocator_callbacks_.user_context);
-    allocator_callbacks_.deallocate(prev_values, allocator_callbacks_.user_context);
+#ifdef TOTE_ENABLE_HASH_MAP_STATISTICS
+    rehash_count_++;
+    rehash_bytes_moved_ += static_cast<uint64_t>(prev_size) * (sizeof(K) + sizeof(V));
+#endif
+  }
+}
+template <typename K, typename V, typename U, typename P, typename H, typename E, bool I>
+void HashMap<K, V, U, P, H, E, I>::allocate_table(const uint32_t new_capacity) {
+  capacity_ = new_capacity;
+  // [flags][keys][values] or [flags][entries], each array starting at a cache line.
+  // sizes are summed in 64 bits as they overflow 32 bits well before the slot count does.
+  auto get_array_size = [this](const uint64_t element_size) { return (element_size * capacity_ + kCacheLineSize - 1) & ~static_cast<uint64_t>(kCacheLineSize - 1); };
+  const auto flags_size = get_array_size(sizeof(occupied_flags_[0]));
+  const auto keys_size = I ? 0 : get_array_size(sizeof(K));
+  const auto values_size = I ? get_array_size(sizeof(Entry)) : get_array_size(sizeof(V));
+  auto buffer = static_cast<uint8_t*>(allocator_callbacks_.allocate(GetAllocationSize(flags_size + keys_size + values_size, 1), kCacheLineSize, allocator_callbacks_.user_context));
+  occupied_flags_ = reinterpret_cast<bool*>(buffer);
+  if constexpr (I) {
+    entries_ = reinterpret_cast<Entry*>(buffer + flags_size);
+  } else {
+    keys_ = reinterpret_cast<K*>(buffer + flags_size);
+    values_ = reinterpret_cast<V*>(buffer + flags_size + keys_size);
+  }
+  clear();
+}
+template <typename K, typename V, typename U, typename P, typename H, typename E, bool I>
+template <typename T>
+void HashMap<K, V, U, P, H, E, I>::reserve(const uint32_t n, const TaskCallbacks<T>& task_callbacks) {
+  step_rehash(~0U);
+  const auto new_capacity = P::GetInitialCapacity(GetMinCapacityNotCloseToFull(n));
+  if (capacity_ >= new_capacity) { return; }
+  const auto prev_capacity = capacity_;
+  const auto prev_size = size_;
+  const auto prev_occupied_flags = occupied_flags_;
+  const auto prev_keys = keys_;
+  const auto prev_values = values_;
+  const auto prev_entries = entries_;
+  allocate_table(new_capacity);
+  insert_parallel(prev_capacity, [&](const uint32_t i) -> std::pair<const K*, const V*> {
+    if (!prev_occupied_flags[i]) { return {nullptr, nullptr}; }
+    if constexpr (I) { return {&prev_entries[i].key, &prev_entries[i].value}; } else { return {&prev_keys[i], &prev_values[i]}; }
+  }, task_callbacks);
+  if (prev_capacity > 0) {
+    allocator_callbacks_.deallocate(prev_occupied_flags, allocator_callbacks_.user_context);
+#ifdef TOTE_ENABLE_HASH_MAP_STATISTICS
+    rehash_count_++;
+    rehash_bytes_moved_ += static_cast<uint64_t>(prev_size) * (sizeof(K) + sizeof(V));
+#else
+    (void)prev_size;
+#endif
+  }
+}
+template <typename K, typename V, typename U, typename P, typename H, typename E, bool I>
+template <typename T>
+void HashMap<K, V, U, P, H, E, I>::insert_bulk(const K* keys, const V* values, const uint32_t count, const TaskCallbacks<T>& task_callbacks) {
+  reserve(count < ~0U - size_ ? size_ + count : ~0U, task_callbacks);
+  insert_parallel(count, [keys, values](const uint32_t i) { return std::pair<const K*, const V*>{&keys[i], &values[i]}; }, task_callbacks);
+}
+template <typename K, typename V, typename U, typename P, typename H, typename E, bool I>
+template <typename T, typename F>
+void HashMap<K, V, U, P, H, E, I>::insert_parallel(const uint32_t count, F&& get_entry, const TaskCallbacks<T>& task_callbacks) {
+  auto insert_serially = [&](const uint32_t i) {
+    const auto [key, value] = get_entry(i);
+    if (key == nullptr) { return; }
+    const auto index = find_slot_index(*key);
+    if (!occupied_flags_[index]) {
+      size_++;
+    }
+    insert_impl(index, *key, *value);
+  };
+  // ranges shorter than a few thousand slots would defer too many entries.
+  constexpr uint32_t kMinShardCapacity = 4096;
+  constexpr uint32_t kShardNumPerWorker = 4;
+  auto shard_num = task_callbacks.concurrency * kShardNumPerWorker;
+  if (shard_num > capacity_ / kMinShardCapacity) {
+    shard_num = capacity_ / kMinShardCapacity;
+  }
+  if (shard_num <= 1 || count < kMinShardCapacity) {
+    for (uint32_t i = 0; i < count; i++) {
+      insert_serially(i);
+    }
+    return;
+  }
+  // home slots [get_shard_begin(s), get_shard_begin(s + 1)) belong to shard s.
+  auto get_shard = [&](const uint32_t home) { return static_cast<uint32_t>(static_cast<uint64_t>(home) * shard_num / capacity_); };
+  auto get_shard_begin = [&](const uint32_t shard) { return static_cast<uint32_t>((static_cast<uint64_t>(shard) * capacity_ + shard_num - 1) / shard_num); };
+  const auto chunk_num = shard_num;
+  const auto chunk_size = (count + chunk_num - 1) / chunk_num;
+  auto get_chunk_end = [&](const uint32_t chunk) { return (chunk + 1) * chunk_size < count ? (chunk + 1) * chunk_size : count; };
+  // [homes][order][histogram][shard_offsets][inserted_num][deferred_num] as temporary working area.
+  const auto histogram_size = chunk_num * shard_num;
+  auto homes = static_cast<uint32_t*>(allocator_callbacks_.allocate(GetAllocationSize(static_cast<uint64_t>(count) * 2 + histogram_size + (shard_num + 1) * 3, sizeof(uint32_t)), alignof(uint32_t), allocator_callbacks_.user_context));
+  auto order = homes + count;
+  auto histogram = order + count;
+  auto shard_offsets = histogram + histogram_size;
+  auto inserted_num = shard_offsets + shard_num + 1;
+  auto deferred_num = inserted_num + shard_num + 1;
+  memset(histogram, 0, sizeof(uint32_t) * histogram_size);
+  // hash each entry and count entries per chunk and shard.
+  auto hash_chunk = [&](const uint32_t chunk) {
+    auto chunk_histogram = histogram + chunk * shard_num;
+    for (auto i = chunk * chunk_size; i < get_chunk_end(chunk); i++) {
+      const auto key = get_entry(i).first;
+      if (key == nullptr) {
+        homes[i] = kNotFound;
+        continue;
+      }
+      homes[i] = P::GetIndex(H{}(*key), capacity_);
+      chunk_histogram[get_shard(homes[i])]++;
+    }
+  };
+  DispatchTasks(task_callbacks, chunk_num, hash_chunk);
+  // entries of a shard are placed contiguously in order, keeping their order in the input.
+  uint32_t offset = 0;
+  for (uint32_t shard = 0; shard < shard_num; shard++) {
+    shard_offsets[shard] = offset;
+    for (uint32_t chunk = 0; chunk < chunk_num; chunk++) {
+      const auto num = histogram[chunk * shard_num + shard];
+      histogram[chunk * shard_num + shard] = offset;
+      offset += num;
+    }
+  }
+  shard_offsets[shard_num] = offset;
+  auto scatter_chunk = [&](const uint32_t chunk) {
+    auto chunk_histogram = histogram + chunk * shard_num;
+    for (auto i = chunk * chunk_size; i < get_chunk_end(chunk); i++) {
+      if (homes[i] == kNotFound) { continue; }
+      order[chunk_histogram[get_shard(homes[i])]++] = i;
+    }
+  };
+  DispatchTasks(task_callbacks, chunk_num, scatter_chunk);
+  // each shard writes only slots in its range, probes reaching the end are deferred.
+  auto insert_shard = [&](const uint32_t shard) {
+    const auto slot_end = get_shard_begin(shard + 1);
+    const auto order_begin = shard_offsets[shard];
+    const auto order_end = shard_offsets[shard + 1];
+    uint32_t inserted = 0;
+    uint32_t deferred = 0;
+    for (auto j = order_begin; j < order_end; j++) {
+      const auto i = order[j];
+      const auto [key, value] = get_entry(i);
+      auto index = homes[i];
+      while (index < slot_end && occupied_flags_[index] && !E{}(key_at(index), *key)) {
+        index++;
+      }
+      if (index == slot_end) {
+        // deferred entries are compacted at the head of the shard's part of order.
+        order[order_begin + deferred] = i;
+        deferred++;
+        continue;
+      }
+      if (!occupied_flags_[index]) {
+        inserted++;
+      }
+      insert_impl(index, *key, *value);
+    }
+    inserted_num[shard] = inserted;
+    deferred_num[shard] = deferred;
+  };
+  DispatchTasks(task_callbacks, shard_num, insert_shard);
+  for (uint32_t shard = 0; shard < shard_num; shard++) {
+    size_ += inserted_num[shard];
+    for (uint32_t j = 0; j < deferred_num[shard]; j++) {
+      insert_serially(order[shard_offsets[shard] + j]);
+    }
+  }
+  allocator_callbacks_.deallocate(homes, allocator_callbacks_.user_context);
+}
+template <typename K, typename V, typename U, typename P, typename H, typename E, bool I>
+void HashMap<K, V, U, P, H, E, I>::step_rehash(const uint32_t budget) {
+  uint32_t migrated = 0;
+  while (draining_size_ > 0 && migrated < budget) {
+    draining_index_ = FindOccupiedIndex(draining_occupied_flags_, draining_capacity_, draining_index_);
+    migrated += migrate_draining_cluster(draining_index_);
+  }
+  if (is_rehashing() && draining_size_ == 0) {
+    release_draining_buffer();
+#ifdef TOTE_ENABLE_HASH_MAP_STATISTICS
+    rehash_count_++;
+#endif
+  }
+}
+template <typename K, typename V, typename U, typename P, typename H, typename E, bool I>
+uint32_t HashMap<K, V, U, P, H, E, I>::find_draining_slot_index(const K key) const {
+  auto index = P::GetIndex(H{}(key), draining_capacity_);
+  while (draining_occupied_flags_[index]) {
+    if (E{}(draining_key_at(index), key)) { return index; }
+    index = index + 1 < draining_capacity_ ? index + 1 : 0;
+  }
+  return kNotFound;
+}
+template <typename K, typename V, typename U, typename P, typename H, typename E, bool I>
+uint32_t HashMap<K, V, U, P, H, E, I>::migrate_draining_cluster(const uint32_t index) {
+  auto get_prev = [this](const uint32_t i) { return i > 0 ? i - 1 : draining_capacity_ - 1; };
+  auto get_next = [this](const uint32_t i) { return i + 1 < draining_capacity_ ? i + 1 : 0; };
+  auto i = index;
+  while (draining_occupied_flags_[get_prev(i)]) {
+    i = get_prev(i);
+  }
+  uint32_t migrated = 0;
+  for (; draining_occupied_flags_[i]; i = get_next(i)) {
+    insert_impl(find_slot_index(draining_key_at(i)), draining_key_at(i), draining_value_at(i));
+    draining_occupied_flags_[i] = false;
+    migrated++;
+  }
+  draining_size_ -= migrated;
+#ifdef TOTE_ENABLE_HASH_MAP_STATISTICS
+  rehash_bytes_moved_ += static_cast<uint64_t>(migrated) * (sizeof(K) + sizeof(V));
+#endif
+  return migrated;
+}
+template <typename K, typename V, typename U, typename P, typename H, typename E, bool I>
+void HashMap<K, V, U, P, H, E, I>::release_draining_buffer() {
+  if (draining_capacity_ > 0) {
+    allocator_callbacks_.deallocate(draining_occupied_flags_, allocator_callbacks_.user_context);
+    draining_occupied_flags_ = nullptr;
+    draining_keys_ = nullptr;
+    draining_values_ = nullptr;
+    draining_entries_ = nullptr;
+    draining_capacity_ = 0;
+    draining_size_ = 0;
+    draining_index_ = 0;
+  }
+}
+#ifdef TOTE_ENABLE_HASH_MAP_STATISTICS
+template <typename K, typename V, typename U, typename P, typename H, typename E, bool I>
+HashMapStatistics HashMap<K, V, U, P, H, E, I>::stats() const {
+  HashMapStatistics stats{};
+  stats.size = size_;
+  stats.capacity = capacity_;
+  stats.rehash_count = rehash_count_;
+  stats.rehash_bytes_moved = rehash_bytes_moved_;
+  if (size_ == 0) { return stats; }
+  stats.load_factor = static_cast<float>(size_) / static_cast<float>(capacity_);
+  const auto live_size = size_ - draining_size_;
+  if (live_size == 0) { return stats; }
+  uint64_t probe_length_sum = 0;
+  uint32_t empty_index = 0;
+  for (uint32_t i = 0; i < capacity_; i++) {
+    if (!occupied_flags_[i]) {
+      empty_index = i;
+      continue;
+    }
+    const auto home_index = P::GetIndex(H{}(key_at(i)), capacity_);
+    const auto probe_length = i >= home_index ? i - home_index : i + capacity_ - home_index;
+    probe_length_sum += probe_length;
+    if (stats.max_probe_length < probe_length) {
+      stats.max_probe_length = probe_length;
+    }
+    stats.probe_length_histogram[probe_length < kHashMapProbeHistogramSize ? probe_length : kHashMapProbeHistogramSize - 1]++;
+  }
+  stats.average_probe_length = static_cast<float>(probe_length_sum) / static_cast<float>(live_size);
+  // start right after an empty slot so that a cluster wrapping around the end is counted once.
+  uint32_t cluster_size = 0;
+  auto index = empty_index;
+  for (uint32_t i = 0; i < capacity_; i++) {
+    index = get_next_index(index);
+    if (occupied_flags_[index]) {
+      cluster_size++;
+      continue;
+    }
+    if (cluster_size == 0) { continue; }
+    stats.cluster_count++;
+    if (stats.max_cluster_size < cluster_size) {
+      stats.max_cluster_size = cluster_size;
+    }
+    cluster_size = 0;
   }
+  stats.average_cluster_size = static_cast<float>(live_size) / static_cast<float>(stats.cluster_count);
+  return stats;
 }
+#endif
 } // namespace tote
 #undef TOTE_HASH_KEY_TYPE
 #undef TOTE_ALIGNMENT_BYTE
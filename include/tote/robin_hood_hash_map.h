@@ -0,0 +1,467 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <new>
+#include <string.h>
+#include <utility>
+#include "allocator_callbacks.h"
+#include "hash_map.h"
+namespace tote {
+/**
+ * HashMap alternative using Robin Hood linear probing.
+ * shares interface with HashMap so that either engine can be chosen per table.
+ * each slot stores its probe distance, an entry never sits farther from its home slot
+ * than the entry it displaced, which keeps worst case probes short
+ * and lets a miss stop as soon as a closer-to-home entry is reached.
+ * this allows running at 7/8 load.
+ * capacity is a power of two.
+ * distances are stored in a byte saturating at 255, longer ones are recomputed from the hash of the key,
+ * hence colliding hashes slow down probes but never grow the table.
+ * insertion aborts when the table cannot grow any further.
+ * K and V are copied with assignment and must be trivially copyable.
+ **/
+template <typename K, typename V, typename U, typename KeyHash = Hash<K>, typename KeyEqual = EqualTo<K>>
+class RobinHoodHashMap final {
+ public:
+  using SimpleIteratorFunction = void (*)(const K, V*);
+  using ConstSimpleIteratorFunction = void (*)(const K, const V*);
+  template <typename T>
+  using IteratorFunction = void (*)(T*, const K, V*);
+  template <typename T>
+  using ConstIteratorFunction = void (*)(T*, const K, const V*);
+
+  RobinHoodHashMap(AllocatorCallbacks<U> allocator_callbacks, const uint32_t initial_capacity = 0);
+  RobinHoodHashMap(RobinHoodHashMap&&);
+  RobinHoodHashMap& operator=(RobinHoodHashMap&&);
+  ~RobinHoodHashMap();
+  constexpr uint32_t size() const { return size_; }
+  constexpr uint32_t capacity() const { return capacity_; }
+  constexpr bool empty() const { return size() == 0; }
+  /**
+   * clear entries and reset size to zero.
+   * destructor for T is not called.
+   **/
+  void clear();
+  /**
+   * release allocated buffer which reduces size and capacity to zero.
+   * destructor for T is not called.
+   **/
+  void release_allocated_buffer();
+  using InsertResult = HashMapInsertResult<V>;
+  void insert(const K, V);
+  /**
+   * following functions probe the table once unless a resize is required.
+   * try_emplace constructs V from args only when key is not found.
+   **/
+  template <typename... Args> InsertResult try_emplace(const K, Args&&...);
+  InsertResult insert_or_assign(const K, V);
+  V* find(const K);
+  const V* find(const K) const;
+  void erase(const K);
+  bool contains(const K) const;
+  V& operator[](const K);
+  /**
+   * returns default constructed V for missing key.
+   **/
+  const V& operator[](const K) const;
+  /**
+   * grow capacity so that n entries can be held without resize.
+   * aborts when n exceeds the load of the largest table.
+   **/
+  void reserve(const uint32_t n);
+  /**
+   * resize at most once and insert (or assign) count entries without per-entry load check.
+   **/
+  void insert_bulk(const K* keys, const V* values, const uint32_t count);
+  void iterate(SimpleIteratorFunction&&);
+  void iterate(ConstSimpleIteratorFunction&&) const;
+  template <typename T> void iterate(IteratorFunction<T>&&, T*);
+  template <typename T> void iterate(ConstIteratorFunction<T>&&, T*) const;
+  /**
+   * calls f(const K&, V&) for each entry, f may capture and is inlinable unlike iterate.
+   **/
+  template <typename F> void for_each(F&&);
+  template <typename F> void for_each(F&&) const;
+  template <bool is_const>
+  class Iterator final {
+   public:
+    using iterator_category = std::forward_iterator_tag;
+    using difference_type = std::ptrdiff_t;
+    using value_type = HashMapEntryReference<K, std::conditional_t<is_const, const V, V>>;
+    using reference = value_type;
+    Iterator() = default;
+    reference operator*() const { return {map_->keys_[index_], map_->values_[index_]}; }
+    Iterator& operator++() {
+      index_ = map_->find_occupied_index(index_ + 1);
+      return *this;
+    }
+    Iterator operator++(int) {
+      auto prev = *this;
+      ++*this;
+      return prev;
+    }
+    bool operator==(const Iterator& other) const { return index_ == other.index_; }
+   private:
+    friend class RobinHoodHashMap;
+    Iterator(const RobinHoodHashMap* map, const uint32_t index) : map_(map), index_(index) {}
+    const RobinHoodHashMap* map_{};
+    uint32_t index_{};
+  };
+  using iterator = Iterator<false>;
+  using const_iterator = Iterator<true>;
+  /**
+   * iterators skip empty slots and are invalidated by insertion or erase.
+   **/
+  iterator begin() { return {this, find_occupied_index(0)}; }
+  iterator end() { return {this, capacity_}; }
+  const_iterator begin() const { return {this, find_occupied_index(0)}; }
+  const_iterator end() const { return {this, capacity_}; }
+ private:
+  static constexpr uint32_t kMinCapacity = 16;
+  static constexpr uint32_t kMaxCapacity = PowerOfTwoCapacity::kMaxCapacity;
+  static constexpr uint32_t kMaxDistance = 255; // distance is stored as probe length + 1, zero marks an empty slot.
+  static constexpr uint32_t get_max_load(const uint32_t capacity) { return capacity - capacity / 8; }
+  constexpr uint32_t get_home_index(const uint64_t hash) const { return static_cast<uint32_t>(hash) & (capacity_ - 1); }
+  constexpr uint32_t get_next_index(const uint32_t index) const { return (index + 1) & (capacity_ - 1); }
+  constexpr uint32_t get_prev_index(const uint32_t index) const { return (index - 1) & (capacity_ - 1); }
+  /**
+   * returns true with the slot of key, or false with the slot and distance to insert key at.
+   **/
+  bool find_slot_index(const K, const uint64_t hash, uint32_t* index, uint32_t* distance) const;
+  void find_insert_slot_index(const uint64_t hash, uint32_t* index, uint32_t* distance) const;
+  /**
+   * distance of the entry at index, a saturated one is recomputed from the hash of its key.
+   **/
+  uint32_t get_distance(const uint32_t index) const;
+  /**
+   * distance of the entry at index to compare with probe distance d,
+   * which skips recomputation while a saturated distance is known to be larger.
+   **/
+  uint32_t get_distance_for_probe(const uint32_t index, const uint32_t d) const {
+    return distances_[index] == kMaxDistance && d >= kMaxDistance ? get_distance(index) : distances_[index];
+  }
+  static constexpr uint8_t get_stored_distance(const uint32_t distance) { return static_cast<uint8_t>(distance < kMaxDistance ? distance : kMaxDistance); }
+  /**
+   * shifts the run of entries starting at index by one slot to empty the slot for an entry at distance.
+   **/
+  void make_room(const uint32_t index, const uint32_t distance);
+  uint32_t find_occupied_index(uint32_t index) const;
+  bool check_load_factor_and_resize();
+  void change_capacity(const uint32_t new_capacity);
+  AllocatorCallbacks<U> allocator_callbacks_;
+  uint8_t* distances_{}; // head of the allocated buffer.
+  K* keys_{};
+  V* values_{};
+  uint32_t size_{};
+  uint32_t capacity_{}; // always >0 for simple implementation.
+  static_assert(alignof(K) <= kCacheLineSize && alignof(V) <= kCacheLineSize);
+  RobinHoodHashMap() = delete;
+  RobinHoodHashMap(const RobinHoodHashMap&) = delete;
+  void operator=(const RobinHoodHashMap&) = delete;
+};
+template <typename K, typename V, typename U, typename H, typename E>
+RobinHoodHashMap<K, V, U, H, E>::RobinHoodHashMap(AllocatorCallbacks<U> allocator_callbacks, const uint32_t initial_capacity)
+    : allocator_callbacks_(allocator_callbacks)
+    , size_(0)
+    , capacity_(0)
+{
+  change_capacity(GetLargerOrEqualPowerOfTwo(initial_capacity < kMinCapacity ? kMinCapacity : initial_capacity));
+}
+template <typename K, typename V, typename U, typename H, typename E>
+RobinHoodHashMap<K, V, U, H, E>::RobinHoodHashMap(RobinHoodHashMap&& other)
+    : allocator_callbacks_(std::move(other.allocator_callbacks_))
+    , distances_(other.distances_)
+    , keys_(other.keys_)
+    , values_(other.values_)
+    , size_(other.size_)
+    , capacity_(other.capacity_)
+{
+  other.allocator_callbacks_ = {};
+  other.distances_ = nullptr;
+  other.keys_ = nullptr;
+  other.values_ = nullptr;
+  other.size_ = 0;
+  other.capacity_ = 0;
+}
+template <typename K, typename V, typename U, typename H, typename E>
+RobinHoodHashMap<K, V, U, H, E>& RobinHoodHashMap<K, V, U, H, E>::operator=(RobinHoodHashMap&& other)
+{
+  if (this != &other) {
+    release_allocated_buffer();
+    allocator_callbacks_ = std::move(other.allocator_callbacks_);
+    distances_ = other.distances_;
+    keys_ = other.keys_;
+    values_ = other.values_;
+    size_ = other.size_;
+    capacity_ = other.capacity_;
+    other.allocator_callbacks_ = {};
+    other.distances_ = nullptr;
+    other.keys_ = nullptr;
+    other.values_ = nullptr;
+    other.size_ = 0;
+    other.capacity_ = 0;
+  }
+  return *this;
+}
+template <typename K, typename V, typename U, typename H, typename E>
+RobinHoodHashMap<K, V, U, H, E>::~RobinHoodHashMap() {
+  release_allocated_buffer();
+}
+template <typename K, typename V, typename U, typename H, typename E>
+void RobinHoodHashMap<K, V, U, H, E>::clear() {
+  if (capacity_ > 0) {
+    memset(distances_, 0, sizeof(distances_[0]) * capacity_);
+  }
+  size_ = 0;
+}
+template <typename K, typename V, typename U, typename H, typename E>
+void RobinHoodHashMap<K, V, U, H, E>::release_allocated_buffer() {
+  if (capacity_ > 0) {
+    allocator_callbacks_.deallocate(distances_, allocator_callbacks_.user_context);
+    distances_ = nullptr;
+    keys_ = nullptr;
+    values_ = nullptr;
+    capacity_ = 0;
+  }
+  size_ = 0;
+}
+template <typename K, typename V, typename U, typename H, typename E>
+void RobinHoodHashMap<K, V, U, H, E>::insert(const K key, V value) {
+  insert_or_assign(key, value);
+}
+template <typename K, typename V, typename U, typename H, typename E>
+template <typename... Args>
+typename RobinHoodHashMap<K, V, U, H, E>::InsertResult RobinHoodHashMap<K, V, U, H, E>::try_emplace(const K key, Args&&... args) {
+  const auto hash = static_cast<uint64_t>(H{}(key));
+  uint32_t index{}, distance{};
+  if (find_slot_index(key, hash, &index, &distance)) {
+    return {&values_[index], false};
+  }
+  if (check_load_factor_and_resize()) {
+    find_insert_slot_index(hash, &index, &distance);
+  }
+  make_room(index, distance);
+  keys_[index] = key;
+  new (&values_[index]) V(std::forward<Args>(args)...);
+  size_++;
+  return {&values_[index], true};
+}
+template <typename K, typename V, typename U, typename H, typename E>
+typename RobinHoodHashMap<K, V, U, H, E>::InsertResult RobinHoodHashMap<K, V, U, H, E>::insert_or_assign(const K key, V value) {
+  auto result = try_emplace(key, value);
+  if (!result.inserted) {
+    *result.value = value;
+  }
+  return result;
+}
+template <typename K, typename V, typename U, typename H, typename E>
+V* RobinHoodHashMap<K, V, U, H, E>::find(const K key) {
+  uint32_t index{}, distance{};
+  return find_slot_index(key, static_cast<uint64_t>(H{}(key)), &index, &distance) ? &values_[index] : nullptr;
+}
+template <typename K, typename V, typename U, typename H, typename E>
+const V* RobinHoodHashMap<K, V, U, H, E>::find(const K key) const {
+  uint32_t index{}, distance{};
+  return find_slot_index(key, static_cast<uint64_t>(H{}(key)), &index, &distance) ? &values_[index] : nullptr;
+}
+template <typename K, typename V, typename U, typename H, typename E>
+void RobinHoodHashMap<K, V, U, H, E>::reserve(const uint32_t n) {
+  auto new_capacity = capacity_ < kMinCapacity ? kMinCapacity : capacity_;
+  while (get_max_load(new_capacity) < n) {
+    if (new_capacity >= kMaxCapacity) { abort(); }
+    new_capacity *= 2;
+  }
+  if (new_capacity > capacity_) {
+    change_capacity(new_capacity);
+  }
+}
+template <typename K, typename V, typename U, typename H, typename E>
+void RobinHoodHashMap<K, V, U, H, E>::insert_bulk(const K* keys, const V* values, const uint32_t count) {
+  // saturated rather than wrapped, which would reserve too little.
+  reserve(count < ~0U - size_ ? size_ + count : ~0U);
+  for (uint32_t i = 0; i < count; i++) {
+    const auto hash = static_cast<uint64_t>(H{}(keys[i]));
+    uint32_t index{}, distance{};
+    if (!find_slot_index(keys[i], hash, &index, &distance)) {
+      make_room(index, distance);
+      keys_[index] = keys[i];
+      size_++;
+    }
+    values_[index] = values[i];
+  }
+}
+template <typename K, typename V, typename U, typename H, typename E>
+void RobinHoodHashMap<K, V, U, H, E>::erase(const K key) {
+  uint32_t index{}, distance{};
+  if (!find_slot_index(key, static_cast<uint64_t>(H{}(key)), &index, &distance)) { return; }
+  // backward shift the following entries which are not at their home slot.
+  auto next = get_next_index(index);
+  while (distances_[next] > 1) {
+    distances_[index] = get_stored_distance(get_distance(next) - 1);
+    keys_[index] = keys_[next];
+    values_[index] = values_[next];
+    index = next;
+    next = get_next_index(next);
+  }
+  distances_[index] = 0;
+  size_--;
+}
+template <typename K, typename V, typename U, typename H, typename E>
+bool RobinHoodHashMap<K, V, U, H, E>::contains(const K key) const {
+  return find(key) != nullptr;
+}
+template <typename K, typename V, typename U, typename H, typename E>
+V& RobinHoodHashMap<K, V, U, H, E>::operator[](const K key) {
+  return *try_emplace(key).value;
+}
+template <typename K, typename V, typename U, typename H, typename E>
+const V& RobinHoodHashMap<K, V, U, H, E>::operator[](const K key) const {
+  static const V default_value{};
+  const auto value = find(key);
+  return value ? *value : default_value;
+}
+template <typename K, typename V, typename U, typename H, typename E>
+void RobinHoodHashMap<K, V, U, H, E>::iterate(SimpleIteratorFunction&& f) {
+  for_each([&](const K& key, V& value) { f(key, &value); });
+}
+template <typename K, typename V, typename U, typename H, typename E>
+void RobinHoodHashMap<K, V, U, H, E>::iterate(ConstSimpleIteratorFunction&& f) const {
+  for_each([&](const K& key, const V& value) { f(key, &value); });
+}
+template <typename K, typename V, typename U, typename H, typename E>
+template <typename T>
+void RobinHoodHashMap<K, V, U, H, E>::iterate(IteratorFunction<T>&& f, T* entity) {
+  for_each([&](const K& key, V& value) { f(entity, key, &value); });
+}
+template <typename K, typename V, typename U, typename H, typename E>
+template <typename T>
+void RobinHoodHashMap<K, V, U, H, E>::iterate(ConstIteratorFunction<T>&& f, T* entity) const {
+  for_each([&](const K& key, const V& value) { f(entity, key, &value); });
+}
+template <typename K, typename V, typename U, typename H, typename E>
+template <typename F>
+void RobinHoodHashMap<K, V, U, H, E>::for_each(F&& f) {
+  for (auto i = find_occupied_index(0); i < capacity_; i = find_occupied_index(i + 1)) {
+    f(static_cast<const K&>(keys_[i]), values_[i]);
+  }
+}
+template <typename K, typename V, typename U, typename H, typename E>
+template <typename F>
+void RobinHoodHashMap<K, V, U, H, E>::for_each(F&& f) const {
+  for (auto i = find_occupied_index(0); i < capacity_; i = find_occupied_index(i + 1)) {
+    f(static_cast<const K&>(keys_[i]), static_cast<const V&>(values_[i]));
+  }
+}
+template <typename K, typename V, typename U, typename H, typename E>
+bool RobinHoodHashMap<K, V, U, H, E>::find_slot_index(const K key, const uint64_t hash, uint32_t* index, uint32_t* distance) const {
+  if (capacity_ == 0) {
+    *index = 0;
+    *distance = 1;
+    return false;
+  }
+  auto i = get_home_index(hash);
+  uint32_t d = 1;
+  // an entry closer to its home than the probe means key would have displaced it.
+  for (auto distance_i = get_distance_for_probe(i, d); d <= distance_i; distance_i = get_distance_for_probe(i, d)) {
+    if (d == distance_i && E{}(keys_[i], key)) {
+      *index = i;
+      return true;
+    }
+    i = get_next_index(i);
+    d++;
+  }
+  *index = i;
+  *distance = d;
+  return false;
+}
+template <typename K, typename V, typename U, typename H, typename E>
+void RobinHoodHashMap<K, V, U, H, E>::find_insert_slot_index(const uint64_t hash, uint32_t* index, uint32_t* distance) const {
+  auto i = get_home_index(hash);
+  uint32_t d = 1;
+  while (d <= get_distance_for_probe(i, d)) {
+    i = get_next_index(i);
+    d++;
+  }
+  *index = i;
+  *distance = d;
+}
+template <typename K, typename V, typename U, typename H, typename E>
+uint32_t RobinHoodHashMap<K, V, U, H, E>::get_distance(const uint32_t index) const {
+  if (distances_[index] < kMaxDistance) { return distances_[index]; }
+  return ((index - get_home_index(static_cast<uint64_t>(H{}(keys_[index])))) & (capacity_ - 1)) + 1;
+}
+template <typename K, typename V, typename U, typename H, typename E>
+void RobinHoodHashMap<K, V, U, H, E>::make_room(const uint32_t index, const uint32_t distance) {
+  auto empty_index = index;
+  while (distances_[empty_index] != 0) {
+    empty_index = get_next_index(empty_index);
+  }
+  while (empty_index != index) {
+    const auto prev = get_prev_index(empty_index);
+    // a saturated distance stays saturated as it is recomputed from the new slot.
+    distances_[empty_index] = get_stored_distance(distances_[prev] + 1U);
+    keys_[empty_index] = keys_[prev];
+    values_[empty_index] = values_[prev];
+    empty_index = prev;
+  }
+  distances_[index] = get_stored_distance(distance);
+}
+template <typename K, typename V, typename U, typename H, typename E>
+uint32_t RobinHoodHashMap<K, V, U, H, E>::find_occupied_index(uint32_t index) const {
+  // sparse tables are skipped a word of distances at a time.
+  while (index + sizeof(uint64_t) <= capacity_) {
+    uint64_t word;
+    memcpy(&word, &distances_[index], sizeof(word));
+    if (word != 0) {
+      return index + GetFirstSetByteIndex(word);
+    }
+    index += sizeof(word);
+  }
+  while (index < capacity_ && distances_[index] == 0) {
+    index++;
+  }
+  return index;
+}
+template <typename K, typename V, typename U, typename H, typename E>
+bool RobinHoodHashMap<K, V, U, H, E>::check_load_factor_and_resize() {
+  if (size_ + 1 <= get_max_load(capacity_)) { return false; }
+  if (capacity_ >= kMaxCapacity) { abort(); }
+  change_capacity(capacity_ == 0 ? kMinCapacity : capacity_ * 2);
+  return true;
+}
+template <typename K, typename V, typename U, typename H, typename E>
+void RobinHoodHashMap<K, V, U, H, E>::change_capacity(const uint32_t new_capacity) {
+  if (capacity_ >= new_capacity) { return; }
+  const auto prev_capacity = capacity_;
+  const auto prev_size = size_;
+  const auto prev_distances = distances_;
+  const auto prev_keys = keys_;
+  const auto prev_values = values_;
+  capacity_ = new_capacity;
+  {
+    // [distances][keys][values] in a single allocation, each array starting at a cache line.
+    auto get_array_size = [this](const uint64_t element_size) { return (element_size * capacity_ + kCacheLineSize - 1) & ~static_cast<uint64_t>(kCacheLineSize - 1); };
+    const auto distances_size = get_array_size(sizeof(distances_[0]));
+    const auto keys_size = get_array_size(sizeof(K));
+    const auto values_size = get_array_size(sizeof(V));
+    auto buffer = static_cast<uint8_t*>(allocator_callbacks_.allocate(GetAllocationSize(distances_size + keys_size + values_size, 1), kCacheLineSize, allocator_callbacks_.user_context));
+    distances_ = buffer;
+    keys_ = reinterpret_cast<K*>(buffer + distances_size);
+    values_ = reinterpret_cast<V*>(buffer + distances_size + keys_size);
+  }
+  clear();
+  for (uint32_t i = 0; i < prev_capacity; i++) {
+    if (prev_distances[i] == 0) { continue; }
+    uint32_t index{}, distance{};
+    find_insert_slot_index(static_cast<uint64_t>(H{}(prev_keys[i])), &index, &distance);
+    make_room(index, distance);
+    keys_[index] = prev_keys[i];
+    values_[index] = prev_values[i];
+  }
+  size_ = prev_size;
+  if (prev_capacity > 0) {
+    allocator_callbacks_.deallocate(prev_distances, allocator_callbacks_.user_context);
+  }
+}
+} // namespace tote
@@ -0,0 +1,209 @@
+#pragma once
+#include <cstdint>
+#include <utility>
+#include <type_traits>
+#include "allocator_callbacks.h"
+#include "array.h"
+namespace tote {
+/**
+ * generational handle packing a slot index into the lower index_bit_num bits
+ * and the generation of the slot into the rest.
+ * generation zero is never used, hence a zero handle is always invalid.
+ **/
+template <typename W, uint32_t index_bit_num>
+struct SlotMapHandle {
+  using Word = W;
+  static_assert(std::is_unsigned_v<W> && index_bit_num > 0 && index_bit_num <= 32 && index_bit_num < sizeof(W) * 8);
+  static constexpr uint32_t kIndexBitNum = index_bit_num;
+  static constexpr uint32_t kMaxSlotNum = index_bit_num == 32 ? ~0U : (1U << index_bit_num);
+  // shifted in W as narrow words are promoted to int, capped to the 32 bits of a slot generation.
+  static constexpr W kWordGenerationMask = static_cast<W>(static_cast<W>(~W{}) >> index_bit_num);
+  static constexpr uint32_t kGenerationMask = kWordGenerationMask < ~0U ? static_cast<uint32_t>(kWordGenerationMask) : ~0U;
+  static constexpr SlotMapHandle Make(const uint32_t index, const uint32_t generation) {
+    return {static_cast<W>((static_cast<W>(generation) << index_bit_num) | index)};
+  }
+  constexpr uint32_t index() const { return static_cast<uint32_t>(value & ((W{1} << index_bit_num) - 1)); }
+  constexpr uint32_t generation() const { return static_cast<uint32_t>(value >> index_bit_num); }
+  constexpr explicit operator bool() const { return value != 0; }
+  constexpr bool operator==(const SlotMapHandle&) const = default;
+  W value{};
+};
+/**
+ * up to a million slots and 4096 generations per slot.
+ **/
+using SlotMapHandle32 = SlotMapHandle<uint32_t, 20>;
+using SlotMapHandle64 = SlotMapHandle<uint64_t, 32>;
+/**
+ * values packed densely for iteration, addressed through stable generational handles.
+ * a handle resolves with two array indexings, slot then value,
+ * and becomes stale when its value is erased, which find and erase detect.
+ * insert and erase are O(1), erased slots are reused from a free list
+ * and erase moves the last value into the hole, so the order of values is not kept.
+ * a generation wraps around after kGenerationMask reuses of a slot,
+ * which may make a very old stale handle valid again.
+ **/
+template <typename T, typename U, typename Handle = SlotMapHandle32>
+class SlotMap final {
+ public:
+  SlotMap(AllocatorCallbacks<U> allocator_callbacks, const uint32_t initial_capacity = 0);
+  SlotMap(SlotMap&&);
+  SlotMap& operator=(SlotMap&&);
+  ~SlotMap() = default;
+  constexpr uint32_t size() const { return values_.size(); }
+  constexpr bool empty() const { return size() == 0; }
+  /**
+   * erase all values, every handle issued so far becomes stale.
+   * destructor for T is called unless trivially destructible.
+   **/
+  void clear();
+  /**
+   * release allocated buffers, every handle issued so far must not be used anymore.
+   **/
+  void release_allocated_buffer();
+  /**
+   * returns an invalid (zero) handle without inserting when slots are exhausted.
+   **/
+  template <typename... Args> Handle emplace(Args&&...);
+  Handle insert(const T& value) { return emplace(value); }
+  Handle insert(T&& value) { return emplace(std::move(value)); }
+  /**
+   * returns false for a stale or invalid handle.
+   **/
+  bool erase(const Handle);
+  /**
+   * nullptr for a stale or invalid handle.
+   * the pointer is invalidated by following insertion or erase.
+   **/
+  T* find(const Handle);
+  const T* find(const Handle) const;
+  bool contains(const Handle handle) const { return find(handle) != nullptr; }
+  /**
+   * handle of the value at a position of the dense array, for use during iteration.
+   **/
+  Handle get_handle(const uint32_t dense_index) const;
+  T* begin() { return values_.begin(); }
+  const T* begin() const { return values_.begin(); }
+  T* end() { return values_.end(); }
+  const T* end() const { return values_.end(); }
+  T& operator[](const uint32_t dense_index) { return values_[dense_index]; }
+  const T& operator[](const uint32_t dense_index) const { return values_[dense_index]; }
+ private:
+  static constexpr uint32_t kNoFreeSlot = ~0U;
+  static constexpr uint32_t GetNextGeneration(const uint32_t generation) {
+    const auto next = (generation + 1) & Handle::kGenerationMask;
+    return next == 0 ? 1 : next;
+  }
+  struct Slot {
+    uint32_t index; // position in values_ when used, next free slot otherwise.
+    uint32_t generation;
+  };
+  const Slot* find_slot(const Handle) const;
+  ResizableArray<T, U> values_;
+  ResizableArray<uint32_t, U> value_slots_; // slot index of each value, to fix up the slot of the moved value on erase.
+  ResizableArray<Slot, U> slots_;
+  uint32_t free_slot_head_{kNoFreeSlot};
+  SlotMap() = delete;
+  SlotMap(const SlotMap&) = delete;
+  void operator=(const SlotMap&) = delete;
+};
+template <typename T, typename U, typename Handle>
+SlotMap<T, U, Handle>::SlotMap(AllocatorCallbacks<U> allocator_callbacks, const uint32_t initial_capacity)
+    : values_(allocator_callbacks, 0, initial_capacity)
+    , value_slots_(allocator_callbacks, 0, initial_capacity)
+    , slots_(allocator_callbacks, 0, initial_capacity)
+{
+}
+template <typename T, typename U, typename Handle>
+SlotMap<T, U, Handle>::SlotMap(SlotMap&& other)
+    : values_(std::move(other.values_))
+    , value_slots_(std::move(other.value_slots_))
+    , slots_(std::move(other.slots_))
+    , free_slot_head_(other.free_slot_head_)
+{
+  other.free_slot_head_ = kNoFreeSlot;
+}
+template <typename T, typename U, typename Handle>
+SlotMap<T, U, Handle>& SlotMap<T, U, Handle>::operator=(SlotMap&& other) {
+  if (this != &other) {
+    values_ = std::move(other.values_);
+    value_slots_ = std::move(other.value_slots_);
+    slots_ = std::move(other.slots_);
+    free_slot_head_ = other.free_slot_head_;
+    other.free_slot_head_ = kNoFreeSlot;
+  }
+  return *this;
+}
+template <typename T, typename U, typename Handle>
+void SlotMap<T, U, Handle>::clear() {
+  for (const auto slot_index : value_slots_) {
+    slots_[slot_index].generation = GetNextGeneration(slots_[slot_index].generation);
+  }
+  // every slot becomes free, chained in index order.
+  for (uint32_t i = 0; i < slots_.size(); i++) {
+    slots_[i].index = i + 1 < slots_.size() ? i + 1 : kNoFreeSlot;
+  }
+  free_slot_head_ = slots_.empty() ? kNoFreeSlot : 0;
+  values_.clear();
+  value_slots_.clear();
+}
+template <typename T, typename U, typename Handle>
+void SlotMap<T, U, Handle>::release_allocated_buffer() {
+  values_.release_allocated_buffer();
+  value_slots_.release_allocated_buffer();
+  slots_.release_allocated_buffer();
+  free_slot_head_ = kNoFreeSlot;
+}
+template <typename T, typename U, typename Handle>
+template <typename... Args>
+Handle SlotMap<T, U, Handle>::emplace(Args&&... args) {
+  uint32_t slot_index = free_slot_head_;
+  if (slot_index != kNoFreeSlot) {
+    free_slot_head_ = slots_[slot_index].index;
+  } else {
+    if (slots_.size() >= Handle::kMaxSlotNum) { return {}; }
+    slot_index = slots_.size();
+    slots_.push_back({0, 1});
+  }
+  auto& slot = slots_[slot_index];
+  slot.index = values_.size();
+  values_.emplace_back(std::forward<Args>(args)...);
+  value_slots_.push_back(slot_index);
+  return Handle::Make(slot_index, slot.generation);
+}
+template <typename T, typename U, typename Handle>
+bool SlotMap<T, U, Handle>::erase(const Handle handle) {
+  const auto slot = const_cast<Slot*>(find_slot(handle));
+  if (slot == nullptr) { return false; }
+  const auto dense_index = slot->index;
+  // the last value moves into the hole, its slot follows.
+  slots_[value_slots_.back()].index = dense_index;
+  values_.erase_unordered(dense_index);
+  value_slots_.erase_unordered(dense_index);
+  slot->generation = GetNextGeneration(slot->generation);
+  slot->index = free_slot_head_;
+  free_slot_head_ = handle.index();
+  return true;
+}
+template <typename T, typename U, typename Handle>
+T* SlotMap<T, U, Handle>::find(const Handle handle) {
+  return const_cast<T*>(static_cast<const SlotMap*>(this)->find(handle));
+}
+template <typename T, typename U, typename Handle>
+const T* SlotMap<T, U, Handle>::find(const Handle handle) const {
+  const auto slot = find_slot(handle);
+  return slot != nullptr ? &values_[slot->index] : nullptr;
+}
+template <typename T, typename U, typename Handle>
+Handle SlotMap<T, U, Handle>::get_handle(const uint32_t dense_index) const {
+  const auto slot_index = value_slots_[dense_index];
+  return Handle::Make(slot_index, slots_[slot_index].generation);
+}
+template <typename T, typename U, typename Handle>
+const typename SlotMap<T, U, Handle>::Slot* SlotMap<T, U, Handle>::find_slot(const Handle handle) const {
+  const auto slot_index = handle.index();
+  if (slot_index >= slots_.size()) { return nullptr; }
+  // a free slot always holds a generation newer than any handle issued for it.
+  const auto& slot = slots_[slot_index];
+  return slot.generation == handle.generation() ? &slot : nullptr;
+}
+} // namespace tote
@@ -0,0 +1,191 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string.h>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include "allocator_callbacks.h"
+#include "array.h"
+namespace tote {
+/**
+ * structure of arrays holding one contiguous column per field,
+ * so that a pass touching a single field streams only that column.
+ * columns are carved from a single allocation and each starts at a cache line,
+ * all columns share size and capacity and grow together,
+ * push_back and resize grow them geometrically as ResizableArray does.
+ * fields are copied with memcpy and must be trivially copyable.
+ **/
+template <typename U, typename... Fields>
+class SoAArray final {
+ public:
+  static constexpr uint32_t kFieldNum = sizeof...(Fields);
+  static constexpr uint32_t kColumnAlignment = 64;
+  template <uint32_t field>
+  using FieldType = std::tuple_element_t<field, std::tuple<Fields...>>;
+  SoAArray(AllocatorCallbacks<U> allocator_callbacks, const uint32_t initial_size = 0, const uint32_t initial_capacity = 0);
+  SoAArray(SoAArray&&);
+  SoAArray& operator=(SoAArray&&);
+  ~SoAArray();
+  constexpr uint32_t size() const { return size_; }
+  constexpr uint32_t capacity() const { return capacity_; }
+  constexpr bool empty() const { return size() == 0; }
+  /**
+   * reset size to zero.
+   **/
+  void clear() { size_ = 0; }
+  /**
+   * release allocated buffer which reduces size and capacity to zero.
+   **/
+  void release_allocated_buffer();
+  /**
+   * grow capacity of all columns so that n elements can be held without reallocation.
+   **/
+  void reserve(const uint32_t n);
+  /**
+   * shrinks or appends zero filled elements up to n.
+   **/
+  void resize(const uint32_t n);
+  /**
+   * appends an element with a value per field, returns its index.
+   **/
+  uint32_t push_back(const Fields&... values);
+  /**
+   * moves the last element to index and pops it, which does not keep the order.
+   **/
+  void erase_unordered(const uint32_t index);
+  /**
+   * contiguous column of a field, invalidated by reallocation.
+   **/
+  template <uint32_t field> std::span<FieldType<field>> column() { return {std::get<field>(columns_), size_}; }
+  template <uint32_t field> std::span<const FieldType<field>> column() const { return {std::get<field>(columns_), size_}; }
+  template <uint32_t field> FieldType<field>& get(const uint32_t index) { return std::get<field>(columns_)[index]; }
+  template <uint32_t field> const FieldType<field>& get(const uint32_t index) const { return std::get<field>(columns_)[index]; }
+ private:
+  template <size_t... field> void change_capacity(const uint32_t new_capacity, std::index_sequence<field...>);
+  void change_capacity(const uint32_t new_capacity) { change_capacity(new_capacity, std::index_sequence_for<Fields...>{}); }
+  uint32_t get_grown_capacity(const uint32_t count) const;
+  static constexpr uint64_t align_column(const uint64_t offset) { return (offset + kColumnAlignment - 1) & ~uint64_t{kColumnAlignment - 1}; }
+  AllocatorCallbacks<U> allocator_callbacks_;
+  uint32_t size_;
+  uint32_t capacity_;
+  std::tuple<Fields*...> columns_; // first column is the head of the allocated buffer.
+  static_assert(kFieldNum > 0);
+  static_assert((std::is_trivially_copyable_v<Fields> && ...));
+  static_assert(((alignof(Fields) <= kColumnAlignment) && ...));
+  SoAArray() = delete;
+  SoAArray(const SoAArray&) = delete;
+  void operator=(const SoAArray&) = delete;
+};
+template <typename U, typename... Fields>
+SoAArray<U, Fields...>::SoAArray(AllocatorCallbacks<U> allocator_callbacks, const uint32_t initial_size, const uint32_t initial_capacity)
+    : allocator_callbacks_(allocator_callbacks)
+    , size_(0)
+    , capacity_(0)
+    , columns_{}
+{
+  reserve(initial_size > initial_capacity ? initial_size : initial_capacity);
+  resize(initial_size);
+}
+template <typename U, typename... Fields>
+SoAArray<U, Fields...>::~SoAArray() {
+  release_allocated_buffer();
+}
+template <typename U, typename... Fields>
+SoAArray<U, Fields...>::SoAArray(SoAArray&& other)
+    : allocator_callbacks_(std::move(other.allocator_callbacks_))
+    , size_(other.size_)
+    , capacity_(other.capacity_)
+    , columns_(other.columns_)
+{
+  other.allocator_callbacks_ = {};
+  other.size_ = 0;
+  other.capacity_ = 0;
+  other.columns_ = {};
+}
+template <typename U, typename... Fields>
+SoAArray<U, Fields...>& SoAArray<U, Fields...>::operator=(SoAArray&& other) {
+  if (this != &other) {
+    release_allocated_buffer();
+    allocator_callbacks_ = std::move(other.allocator_callbacks_);
+    size_ = other.size_;
+    capacity_ = other.capacity_;
+    columns_ = other.columns_;
+    other.allocator_callbacks_ = {};
+    other.size_ = 0;
+    other.capacity_ = 0;
+    other.columns_ = {};
+  }
+  return *this;
+}
+template <typename U, typename... Fields>
+void SoAArray<U, Fields...>::release_allocated_buffer() {
+  if (std::get<0>(columns_) != nullptr) {
+    allocator_callbacks_.deallocate(std::get<0>(columns_), allocator_callbacks_.user_context);
+  }
+  size_ = 0;
+  capacity_ = 0;
+  columns_ = {};
+}
+template <typename U, typename... Fields>
+void SoAArray<U, Fields...>::reserve(const uint32_t n) {
+  if (n > capacity_) {
+    change_capacity(n);
+  }
+}
+template <typename U, typename... Fields>
+void SoAArray<U, Fields...>::resize(const uint32_t n) {
+  if (n > capacity_) {
+    change_capacity(get_grown_capacity(n - size_));
+  }
+  if (n > size_) {
+    std::apply([this, n](Fields*... columns) {
+      (memset(static_cast<void*>(columns + size_), 0, sizeof(Fields) * (n - size_)), ...);
+    }, columns_);
+  }
+  size_ = n;
+}
+template <typename U, typename... Fields>
+uint32_t SoAArray<U, Fields...>::push_back(const Fields&... values) {
+  if (size_ == capacity_) {
+    // values may refer to elements of this array, copy before reallocation.
+    const std::tuple<Fields...> copied(values...);
+    change_capacity(get_grown_capacity(1));
+    std::apply([this](const Fields&... copied_values) { push_back(copied_values...); }, copied);
+    return size_ - 1;
+  }
+  std::apply([&](Fields*... columns) { ((columns[size_] = values), ...); }, columns_);
+  return size_++;
+}
+template <typename U, typename... Fields>
+void SoAArray<U, Fields...>::erase_unordered(const uint32_t index) {
+  size_--;
+  if (index < size_) {
+    std::apply([this, index](Fields*... columns) { ((columns[index] = columns[size_]), ...); }, columns_);
+  }
+}
+template <typename U, typename... Fields>
+uint32_t SoAArray<U, Fields...>::get_grown_capacity(const uint32_t count) const {
+  // a row of all fields sizes the growth, capacity stays 32-bit as size is.
+  if (count > ~0U - size_) { abort(); }
+  const auto new_capacity = GetGrownArrayCapacity<std::tuple<Fields...>>(size_, count);
+  return new_capacity < ~0U ? static_cast<uint32_t>(new_capacity) : ~0U;
+}
+template <typename U, typename... Fields>
+template <size_t... field>
+void SoAArray<U, Fields...>::change_capacity(const uint32_t new_capacity, std::index_sequence<field...>) {
+  // summed in 64 bits so that GetAllocationSize catches sizes beyond SizeType.
+  uint64_t offsets[kFieldNum]{};
+  uint64_t buffer_size = 0;
+  ((offsets[field] = buffer_size, buffer_size = align_column(buffer_size + sizeof(Fields) * static_cast<uint64_t>(new_capacity))), ...);
+  auto buffer = static_cast<uint8_t*>(allocator_callbacks_.allocate(GetAllocationSize(buffer_size, 1), kColumnAlignment, allocator_callbacks_.user_context));
+  const auto prev_columns = columns_;
+  columns_ = {reinterpret_cast<Fields*>(buffer + offsets[field])...};
+  if (std::get<0>(prev_columns) != nullptr) {
+    (memcpy(static_cast<void*>(std::get<field>(columns_)), static_cast<const void*>(std::get<field>(prev_columns)), sizeof(Fields) * size_), ...);
+    allocator_callbacks_.deallocate(std::get<0>(prev_columns), allocator_callbacks_.user_context);
+  }
+  capacity_ = new_capacity;
+}
+} // namespace tote
@@ -0,0 +1,571 @@
+#pragma once
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <new>
+#include <string.h>
+#include <utility>
+#include "allocator_callbacks.h"
+#include "hash_map.h"
+#if !defined(TOTE_DISABLE_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define TOTE_SWISS_SSE2
+#include <emmintrin.h>
+#elif !defined(TOTE_DISABLE_SIMD) && (defined(__ARM_NEON) || defined(_M_ARM64))
+#define TOTE_SWISS_NEON
+#include <arm_neon.h>
+#endif
+namespace tote {
+/**
+ * control byte per slot, empty and deleted have the sign bit set,
+ * full slots hold top 7 bits of the hash.
+ **/
+constexpr int8_t kSwissCtrlEmpty = -128;
+constexpr int8_t kSwissCtrlDeleted = -2;
+constexpr uint32_t kSwissGroupWidth = 16;
+/**
+ * set of slot indices in a group matched by a control byte query.
+ **/
+class SwissBitMask final {
+ public:
+#ifdef TOTE_SWISS_NEON
+  static constexpr uint32_t kShift = 2; // 4 bits per slot.
+#else
+  static constexpr uint32_t kShift = 0;
+#endif
+  explicit constexpr SwissBitMask(const uint64_t mask) : mask_(mask) {}
+  constexpr explicit operator bool() const { return mask_ != 0; }
+  constexpr uint32_t lowest() const { return static_cast<uint32_t>(std::countr_zero(mask_)) >> kShift; }
+  constexpr void clear_lowest() { mask_ &= mask_ - 1; }
+ private:
+  uint64_t mask_;
+};
+/**
+ * kSwissGroupWidth control bytes probed at once.
+ **/
+class SwissGroup final {
+ public:
+  explicit SwissGroup(const int8_t* ctrl);
+  SwissBitMask match(const int8_t h2) const;
+  SwissBitMask match_empty() const;
+  SwissBitMask match_empty_or_deleted() const;
+  SwissBitMask match_full() const;
+ private:
+#if defined(TOTE_SWISS_SSE2)
+  __m128i ctrl_;
+#elif defined(TOTE_SWISS_NEON)
+  int8x16_t ctrl_;
+  static uint64_t to_mask(const uint8x16_t eq) {
+    return vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(eq), 4)), 0) & 0x8888888888888888ULL;
+  }
+#else
+  const int8_t* ctrl_;
+#endif
+};
+#if defined(TOTE_SWISS_SSE2)
+inline SwissGroup::SwissGroup(const int8_t* ctrl) : ctrl_(_mm_load_si128(reinterpret_cast<const __m128i*>(ctrl))) {}
+inline SwissBitMask SwissGroup::match(const int8_t h2) const {
+  return SwissBitMask(static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(ctrl_, _mm_set1_epi8(h2)))));
+}
+inline SwissBitMask SwissGroup::match_empty() const {
+  return match(kSwissCtrlEmpty);
+}
+inline SwissBitMask SwissGroup::match_empty_or_deleted() const {
+  return SwissBitMask(static_cast<uint32_t>(_mm_movemask_epi8(ctrl_)));
+}
+inline SwissBitMask SwissGroup::match_full() const {
+  return SwissBitMask(static_cast<uint32_t>(_mm_movemask_epi8(ctrl_)) ^ 0xFFFFU);
+}
+#elif defined(TOTE_SWISS_NEON)
+inline SwissGroup::SwissGroup(const int8_t* ctrl) : ctrl_(vld1q_s8(ctrl)) {}
+inline SwissBitMask SwissGroup::match(const int8_t h2) const {
+  return SwissBitMask(to_mask(vceqq_s8(ctrl_, vdupq_n_s8(h2))));
+}
+inline SwissBitMask SwissGroup::match_empty() const {
+  return match(kSwissCtrlEmpty);
+}
+inline SwissBitMask SwissGroup::match_empty_or_deleted() const {
+  return SwissBitMask(to_mask(vcltq_s8(ctrl_, vdupq_n_s8(0))));
+}
+inline SwissBitMask SwissGroup::match_full() const {
+  return SwissBitMask(to_mask(vcgeq_s8(ctrl_, vdupq_n_s8(0))));
+}
+#else
+inline SwissGroup::SwissGroup(const int8_t* ctrl) : ctrl_(ctrl) {}
+inline SwissBitMask SwissGroup::match(const int8_t h2) const {
+  uint64_t mask = 0;
+  for (uint32_t i = 0; i < kSwissGroupWidth; i++) {
+    if (ctrl_[i] == h2) { mask |= 1ULL << i; }
+  }
+  return SwissBitMask(mask);
+}
+inline SwissBitMask SwissGroup::match_empty() const {
+  return match(kSwissCtrlEmpty);
+}
+inline SwissBitMask SwissGroup::match_empty_or_deleted() const {
+  uint64_t mask = 0;
+  for (uint32_t i = 0; i < kSwissGroupWidth; i++) {
+    if (ctrl_[i] < 0) { mask |= 1ULL << i; }
+  }
+  return SwissBitMask(mask);
+}
+inline SwissBitMask SwissGroup::match_full() const {
+  uint64_t mask = 0;
+  for (uint32_t i = 0; i < kSwissGroupWidth; i++) {
+    if (ctrl_[i] >= 0) { mask |= 1ULL << i; }
+  }
+  return SwissBitMask(mask);
+}
+#endif
+/**
+ * HashMap alternative probing groups of control bytes with SIMD (Swiss table).
+ * shares interface with HashMap so that either engine can be chosen per table.
+ * capacity is a power of two and a multiple of kSwissGroupWidth.
+ * insertion and reserve abort beyond a capacity of 2^31 slots.
+ * K and V are copied with assignment and must be trivially copyable.
+ **/
+template <typename K, typename V, typename U, typename KeyHash = Hash<K>, typename KeyEqual = EqualTo<K>>
+class SwissHashMap final {
+ public:
+  using SimpleIteratorFunction = void (*)(const K, V*);
+  using ConstSimpleIteratorFunction = void (*)(const K, const V*);
+  template <typename T>
+  using IteratorFunction = void (*)(T*, const K, V*);
+  template <typename T>
+  using ConstIteratorFunction = void (*)(T*, const K, const V*);
+
+  SwissHashMap(AllocatorCallbacks<U> allocator_callbacks, const uint32_t initial_capacity = 0);
+  SwissHashMap(SwissHashMap&&);
+  SwissHashMap& operator=(SwissHashMap&&);
+  ~SwissHashMap();
+  constexpr uint32_t size() const { return size_; }
+  constexpr uint32_t capacity() const { return capacity_; }
+  constexpr bool empty() const { return size() == 0; }
+  /**
+   * clear entries and reset size to zero.
+   * destructor for T is not called.
+   **/
+  void clear();
+  /**
+   * release allocated buffer which reduces size and capacity to zero.
+   * destructor for T is not called.
+   **/
+  void release_allocated_buffer();
+  using InsertResult = HashMapInsertResult<V>;
+  void insert(const K, V);
+  /**
+   * following functions probe the table once unless a resize is required.
+   * try_emplace constructs V from args only when key is not found.
+   **/
+  template <typename... Args> InsertResult try_emplace(const K, Args&&...);
+  InsertResult insert_or_assign(const K, V);
+  V* find(const K);
+  const V* find(const K) const;
+  void erase(const K);
+  bool contains(const K) const;
+  V& operator[](const K);
+  /**
+   * returns default constructed V for missing key.
+   **/
+  const V& operator[](const K) const;
+  /**
+   * grow capacity so that n entries can be held without resize.
+   **/
+  void reserve(const uint32_t n);
+  /**
+   * resize at most once and insert (or assign) count entries without per-entry load check.
+   **/
+  void insert_bulk(const K* keys, const V* values, const uint32_t count);
+  void iterate(SimpleIteratorFunction&&);
+  void iterate(ConstSimpleIteratorFunction&&) const;
+  template <typename T> void iterate(IteratorFunction<T>&&, T*);
+  template <typename T> void iterate(ConstIteratorFunction<T>&&, T*) const;
+  /**
+   * calls f(const K&, V&) for each entry, f may capture and is inlinable unlike iterate.
+   **/
+  template <typename F> void for_each(F&&);
+  template <typename F> void for_each(F&&) const;
+  template <bool is_const>
+  class Iterator final {
+   public:
+    using iterator_category = std::forward_iterator_tag;
+    using difference_type = std::ptrdiff_t;
+    using value_type = HashMapEntryReference<K, std::conditional_t<is_const, const V, V>>;
+    using reference = value_type;
+    Iterator() = default;
+    reference operator*() const { return {map_->keys_[index_], map_->values_[index_]}; }
+    Iterator& operator++() {
+      index_ = map_->find_full_slot_index(index_ + 1);
+      return *this;
+    }
+    Iterator operator++(int) {
+      auto prev = *this;
+      ++*this;
+      return prev;
+    }
+    bool operator==(const Iterator& other) const { return index_ == other.index_; }
+   private:
+    friend class SwissHashMap;
+    Iterator(const SwissHashMap* map, const uint32_t index) : map_(map), index_(index) {}
+    const SwissHashMap* map_{};
+    uint32_t index_{};
+  };
+  using iterator = Iterator<false>;
+  using const_iterator = Iterator<true>;
+  /**
+   * iterators skip empty and deleted slots and are invalidated by insertion or erase.
+   **/
+  iterator begin() { return {this, find_full_slot_index(0)}; }
+  iterator end() { return {this, capacity_}; }
+  const_iterator begin() const { return {this, find_full_slot_index(0)}; }
+  const_iterator end() const { return {this, capacity_}; }
+ private:
+  static constexpr uint32_t kNotFound = ~0U;
+  static constexpr uint32_t kMaxCapacity = PowerOfTwoCapacity::kMaxCapacity;
+  static constexpr uint32_t get_max_load(const uint32_t capacity) { return capacity - capacity / 8; }
+  /**
+   * 32 bit hashes are widened so that h2 and the group are taken from independent bits,
+   * h2 from the top and the group from the bottom.
+   **/
+  static constexpr uint64_t get_hash(const K key) {
+    const auto hash = KeyHash{}(key);
+    if constexpr (sizeof(hash) < sizeof(uint64_t)) {
+      return MixHash(static_cast<uint64_t>(hash));
+    } else {
+      return static_cast<uint64_t>(hash);
+    }
+  }
+  static constexpr int8_t get_h2(const uint64_t hash) { return static_cast<int8_t>(hash >> 57); }
+  constexpr uint32_t get_first_group(const uint64_t hash) const { return static_cast<uint32_t>(hash) & (capacity_ / kSwissGroupWidth - 1); }
+  uint32_t find_slot_index(const K key) const { return find_slot_index(key, get_hash(key)); }
+  uint32_t find_slot_index(const K, const uint64_t hash) const;
+  uint32_t find_insert_slot_index(const uint64_t hash) const;
+  bool check_load_factor_and_resize();
+  void change_capacity(const uint32_t new_capacity);
+  template <typename F> void for_each_full_slot(F&&) const;
+  uint32_t find_full_slot_index(uint32_t index) const;
+  AllocatorCallbacks<U> allocator_callbacks_;
+  int8_t* ctrl_{}; // head of the allocated buffer.
+  K* keys_{};
+  V* values_{};
+  uint32_t size_{};
+  uint32_t deleted_{};
+  uint32_t capacity_{}; // always >0 for simple implementation.
+  static_assert(alignof(K) <= kCacheLineSize && alignof(V) <= kCacheLineSize);
+  SwissHashMap() = delete;
+  SwissHashMap(const SwissHashMap&) = delete;
+  void operator=(const SwissHashMap&) = delete;
+};
+template <typename K, typename V, typename U, typename H, typename E>
+SwissHashMap<K, V, U, H, E>::SwissHashMap(AllocatorCallbacks<U> allocator_callbacks, const uint32_t initial_capacity)
+    : allocator_callbacks_(allocator_callbacks)
+    , size_(0)
+    , deleted_(0)
+    , capacity_(0)
+{
+  change_capacity(GetLargerOrEqualPowerOfTwo(initial_capacity < kSwissGroupWidth ? kSwissGroupWidth : initial_capacity));
+}
+template <typename K, typename V, typename U, typename H, typename E>
+SwissHashMap<K, V, U, H, E>::SwissHashMap(SwissHashMap&& other)
+    : allocator_callbacks_(std::move(other.allocator_callbacks_))
+    , ctrl_(other.ctrl_)
+    , keys_(other.keys_)
+    , values_(other.values_)
+    , size_(other.size_)
+    , deleted_(other.deleted_)
+    , capacity_(other.capacity_)
+{
+  other.allocator_callbacks_ = {};
+  other.ctrl_ = nullptr;
+  other.keys_ = nullptr;
+  other.values_ = nullptr;
+  other.size_ = 0;
+  other.deleted_ = 0;
+  other.capacity_ = 0;
+}
+template <typename K, typename V, typename U, typename H, typename E>
+SwissHashMap<K, V, U, H, E>& SwissHashMap<K, V, U, H, E>::operator=(SwissHashMap&& other)
+{
+  if (this != &other) {
+    release_allocated_buffer();
+    allocator_callbacks_ = std::move(other.allocator_callbacks_);
+    ctrl_ = other.ctrl_;
+    keys_ = other.keys_;
+    values_ = other.values_;
+    size_ = other.size_;
+    deleted_ = other.deleted_;
+    capacity_ = other.capacity_;
+    other.allocator_callbacks_ = {};
+    other.ctrl_ = nullptr;
+    other.keys_ = nullptr;
+    other.values_ = nullptr;
+    other.size_ = 0;
+    other.deleted_ = 0;
+    other.capacity_ = 0;
+  }
+  return *this;
+}
+template <typename K, typename V, typename U, typename H, typename E>
+SwissHashMap<K, V, U, H, E>::~SwissHashMap() {
+  release_allocated_buffer();
+}
+template <typename K, typename V, typename U, typename H, typename E>
+void SwissHashMap<K, V, U, H, E>::clear() {
+  if (capacity_ > 0) {
+    memset(ctrl_, kSwissCtrlEmpty, sizeof(ctrl_[0]) * capacity_);
+  }
+  size_ = 0;
+  deleted_ = 0;
+}
+template <typename K, typename V, typename U, typename H, typename E>
+void SwissHashMap<K, V, U, H, E>::release_allocated_buffer() {
+  if (capacity_ > 0) {
+    allocator_callbacks_.deallocate(ctrl_, allocator_callbacks_.user_context);
+    ctrl_ = nullptr;
+    keys_ = nullptr;
+    values_ = nullptr;
+    capacity_ = 0;
+  }
+  size_ = 0;
+  deleted_ = 0;
+}
+template <typename K, typename V, typename U, typename H, typename E>
+void SwissHashMap<K, V, U, H, E>::insert(const K key, V value) {
+  insert_or_assign(key, value);
+}
+template <typename K, typename V, typename U, typename H, typename E>
+template <typename... Args>
+typename SwissHashMap<K, V, U, H, E>::InsertResult SwissHashMap<K, V, U, H, E>::try_emplace(const K key, Args&&... args) {
+  const auto hash = get_hash(key);
+  auto index = find_slot_index(key, hash);
+  if (index != kNotFound) {
+    return {&values_[index], false};
+  }
+  check_load_factor_and_resize();
+  index = find_insert_slot_index(hash);
+  if (ctrl_[index] == kSwissCtrlDeleted) {
+    deleted_--;
+  }
+  ctrl_[index] = get_h2(hash);
+  keys_[index] = key;
+  new (&values_[index]) V(std::forward<Args>(args)...);
+  size_++;
+  return {&values_[index], true};
+}
+template <typename K, typename V, typename U, typename H, typename E>
+typename SwissHashMap<K, V, U, H, E>::InsertResult SwissHashMap<K, V, U, H, E>::insert_or_assign(const K key, V value) {
+  auto result = try_emplace(key, value);
+  if (!result.inserted) {
+    *result.value = value;
+  }
+  return result;
+}
+template <typename K, typename V, typename U, typename H, typename E>
+V* SwissHashMap<K, V, U, H, E>::find(const K key) {
+  const auto index = find_slot_index(key);
+  return index != kNotFound ? &values_[index] : nullptr;
+}
+template <typename K, typename V, typename U, typename H, typename E>
+const V* SwissHashMap<K, V, U, H, E>::find(const K key) const {
+  const auto index = find_slot_index(key);
+  return index != kNotFound ? &values_[index] : nullptr;
+}
+template <typename K, typename V, typename U, typename H, typename E>
+void SwissHashMap<K, V, U, H, E>::reserve(const uint32_t n) {
+  auto new_capacity = capacity_ < kSwissGroupWidth ? kSwissGroupWidth : capacity_;
+  while (get_max_load(new_capacity) < n) {
+    if (new_capacity >= kMaxCapacity) { abort(); }
+    new_capacity *= 2;
+  }
+  if (new_capacity > capacity_) {
+    change_capacity(new_capacity);
+  }
+}
+template <typename K, typename V, typename U, typename H, typename E>
+void SwissHashMap<K, V, U, H, E>::insert_bulk(const K* keys, const V* values, const uint32_t count) {
+  // filling a deleted slot keeps size_ + deleted_ unchanged, so this bound holds throughout.
+  // saturated rather than wrapped, which would reserve too little.
+  const auto load = size_ + deleted_;
+  reserve(count < ~0U - load ? load + count : ~0U);
+  for (uint32_t i = 0; i < count; i++) {
+    const auto hash = get_hash(keys[i]);
+    auto index = find_slot_index(keys[i], hash);
+    if (index == kNotFound) {
+      index = find_insert_slot_index(hash);
+      if (ctrl_[index] == kSwissCtrlDeleted) {
+        deleted_--;
+      }
+      ctrl_[index] = get_h2(hash);
+      keys_[index] = keys[i];
+      size_++;
+    }
+    values_[index] = values[i];
+  }
+}
+template <typename K, typename V, typename U, typename H, typename E>
+void SwissHashMap<K, V, U, H, E>::erase(const K key) {
+  const auto index = find_slot_index(key);
+  if (index == kNotFound) { return; }
+  // probing never passes a group with an empty slot, so the slot can be emptied.
+  const auto group_head = index & ~(kSwissGroupWidth - 1);
+  if (SwissGroup(&ctrl_[group_head]).match_empty()) {
+    ctrl_[index] = kSwissCtrlEmpty;
+  } else {
+    ctrl_[index] = kSwissCtrlDeleted;
+    deleted_++;
+  }
+  size_--;
+}
+template <typename K, typename V, typename U, typename H, typename E>
+bool SwissHashMap<K, V, U, H, E>::contains(const K key) const {
+  return find_slot_index(key) != kNotFound;
+}
+template <typename K, typename V, typename U, typename H, typename E>
+V& SwissHashMap<K, V, U, H, E>::operator[](const K key) {
+  return *try_emplace(key).value;
+}
+template <typename K, typename V, typename U, typename H, typename E>
+const V& SwissHashMap<K, V, U, H, E>::operator[](const K key) const {
+  static const V default_value{};
+  const auto value = find(key);
+  return value ? *value : default_value;
+}
+template <typename K, typename V, typename U, typename H, typename E>
+template <typename F>
+void SwissHashMap<K, V, U, H, E>::for_each_full_slot(F&& f) const {
+  for (uint32_t group_head = 0; group_head < capacity_; group_head += kSwissGroupWidth) {
+    auto mask = SwissGroup(&ctrl_[group_head]).match_full();
+    while (mask) {
+      f(group_head + mask.lowest());
+      mask.clear_lowest();
+    }
+  }
+}
+template <typename K, typename V, typename U, typename H, typename E>
+void SwissHashMap<K, V, U, H, E>::iterate(SimpleIteratorFunction&& f) {
+  for_each_full_slot([&](const uint32_t i) { f(keys_[i], &values_[i]); });
+}
+template <typename K, typename V, typename U, typename H, typename E>
+void SwissHashMap<K, V, U, H, E>::iterate(ConstSimpleIteratorFunction&& f) const {
+  for_each_full_slot([&](const uint32_t i) { f(keys_[i], &values_[i]); });
+}
+template <typename K, typename V, typename U, typename H, typename E>
+template <typename T>
+void SwissHashMap<K, V, U, H, E>::iterate(IteratorFunction<T>&& f, T* entity) {
+  for_each_full_slot([&](const uint32_t i) { f(entity, keys_[i], &values_[i]); });
+}
+template <typename K, typename V, typename U, typename H, typename E>
+template <typename T>
+void SwissHashMap<K, V, U, H, E>::iterate(ConstIteratorFunction<T>&& f, T* entity) const {
+  for_each_full_slot([&](const uint32_t i) { f(entity, keys_[i], &values_[i]); });
+}
+template <typename K, typename V, typename U, typename H, typename E>
+template <typename F>
+void SwissHashMap<K, V, U, H, E>::for_each(F&& f) {
+  for_each_full_slot([&](const uint32_t i) { f(static_cast<const K&>(keys_[i]), values_[i]); });
+}
+template <typename K, typename V, typename U, typename H, typename E>
+template <typename F>
+void SwissHashMap<K, V, U, H, E>::for_each(F&& f) const {
+  for_each_full_slot([&](const uint32_t i) { f(static_cast<const K&>(keys_[i]), static_cast<const V&>(values_[i])); });
+}
+template <typename K, typename V, typename U, typename H, typename E>
+uint32_t SwissHashMap<K, V, U, H, E>::find_full_slot_index(uint32_t index) const {
+  // full slots are the control bytes with the sign bit cleared.
+  while (index + sizeof(uint64_t) <= capacity_) {
+    uint64_t word;
+    memcpy(&word, &ctrl_[index], sizeof(word));
+    const auto full = ~word & 0x8080808080808080ULL;
+    if (full != 0) {
+      return index + GetFirstSetByteIndex(full);
+    }
+    index += sizeof(word);
+  }
+  while (index < capacity_ && ctrl_[index] < 0) {
+    index++;
+  }
+  return index;
+}
+template <typename K, typename V, typename U, typename H, typename E>
+uint32_t SwissHashMap<K, V, U, H, E>::find_slot_index(const K key, const uint64_t hash) const {
+  if (size_ == 0) { return kNotFound; }
+  const auto h2 = get_h2(hash);
+  const auto group_mask = capacity_ / kSwissGroupWidth - 1;
+  auto group = get_first_group(hash);
+  // triangular probing visits every group once when group count is a power of two.
+  for (uint32_t step = 1; step <= group_mask + 1; step++) {
+    const auto group_head = group * kSwissGroupWidth;
+    const SwissGroup g(&ctrl_[group_head]);
+    auto mask = g.match(h2);
+    while (mask) {
+      const auto index = group_head + mask.lowest();
+      if (E{}(keys_[index], key)) { return index; }
+      mask.clear_lowest();
+    }
+    if (g.match_empty()) { return kNotFound; }
+    group = (group + step) & group_mask;
+  }
+  return kNotFound;
+}
+template <typename K, typename V, typename U, typename H, typename E>
+uint32_t SwissHashMap<K, V, U, H, E>::find_insert_slot_index(const uint64_t hash) const {
+  const auto group_mask = capacity_ / kSwissGroupWidth - 1;
+  auto group = get_first_group(hash);
+  for (uint32_t step = 1;; step++) {
+    const auto group_head = group * kSwissGroupWidth;
+    const auto mask = SwissGroup(&ctrl_[group_head]).match_empty_or_deleted();
+    if (mask) { return group_head + mask.lowest(); }
+    group = (group + step) & group_mask;
+  }
+}
+template <typename K, typename V, typename U, typename H, typename E>
+bool SwissHashMap<K, V, U, H, E>::check_load_factor_and_resize() {
+  // deleted slots lengthen probing as well as full slots.
+  const auto max_load = get_max_load(capacity_);
+  if (size_ + deleted_ + 1 <= max_load) { return false; }
+  // rehash at the same capacity to purge deleted slots when the table is mostly deleted.
+  if (capacity_ == 0) {
+    change_capacity(kSwissGroupWidth);
+  } else if ((size_ + 1) * 2 <= max_load) {
+    change_capacity(capacity_);
+  } else {
+    if (capacity_ >= kMaxCapacity) { abort(); }
+    change_capacity(capacity_ * 2);
+  }
+  return true;
+}
+template <typename K, typename V, typename U, typename H, typename E>
+void SwissHashMap<K, V, U, H, E>::change_capacity(const uint32_t new_capacity) {
+  if (capacity_ > new_capacity) { return; }
+  const auto prev_capacity = capacity_;
+  const auto prev_size = size_;
+  const auto prev_ctrl = ctrl_;
+  const auto prev_keys = keys_;
+  const auto prev_values = values_;
+  capacity_ = new_capacity;
+  {
+    // [ctrl][keys][values] in a single allocation, each array starting at a cache line.
+    auto get_array_size = [this](const uint64_t element_size) { return (element_size * capacity_ + kCacheLineSize - 1) & ~static_cast<uint64_t>(kCacheLineSize - 1); };
+    const auto ctrl_size = get_array_size(sizeof(ctrl_[0]));
+    const auto keys_size = get_array_size(sizeof(K));
+    const auto values_size = get_array_size(sizeof(V));
+    auto buffer = static_cast<uint8_t*>(allocator_callbacks_.allocate(GetAllocationSize(ctrl_size + keys_size + values_size, 1), kCacheLineSize, allocator_callbacks_.user_context));
+    ctrl_ = reinterpret_cast<int8_t*>(buffer);
+    keys_ = reinterpret_cast<K*>(buffer + ctrl_size);
+    values_ = reinterpret_cast<V*>(buffer + ctrl_size + keys_size);
+  }
+  clear();
+  for (uint32_t i = 0; i < prev_capacity; i++) {
+    if (prev_ctrl[i] < 0) { continue; }
+    const auto hash = get_hash(prev_keys[i]);
+    const auto index = find_insert_slot_index(hash);
+    ctrl_[index] = get_h2(hash);
+    keys_[index] = prev_keys[i];
+    values_[index] = prev_values[i];
+  }
+  size_ = prev_size;
+  if (prev_capacity > 0) {
+    allocator_callbacks_.deallocate(prev_ctrl, allocator_callbacks_.user_context);
+  }
+}
+} // namespace tote
@@ -0,0 +1,39 @@
+#pragma once
+#include <stdint.h>
+namespace tote{
+template <typename T>
+struct TaskCallbacks {
+  using TaskFunction = void(void* task_context, const uint32_t task_index);
+  /**
+   * runs task(task_context, i) for each i in [0, task_count), possibly in parallel,
+   * and returns after all of them finished.
+   **/
+  using DispatchFunction = void(TaskFunction* task, void* task_context, const uint32_t task_count, T* user_context);
+  DispatchFunction* dispatch;
+  T* user_context;
+  uint32_t concurrency; // number of workers, used to decide how finely work is split.
+};
+/**
+ * runs f(i) for each i in [0, task_count) through task_callbacks.
+ **/
+template <typename T, typename F>
+void DispatchTasks(const TaskCallbacks<T>& task_callbacks, const uint32_t task_count, F& f) {
+  task_callbacks.dispatch([](void* task_context, const uint32_t task_index) { (*static_cast<F*>(task_context))(task_index); }, &f, task_count, task_callbacks.user_context);
+}
+/**
+ * fallback dispatcher spawning std::thread per call,
+ * meant for tools and tests without a job system.
+ **/
+class ThreadTaskDispatcher final {
+ public:
+  /**
+   * zero thread_num uses std::thread::hardware_concurrency().
+   **/
+  explicit ThreadTaskDispatcher(const uint32_t thread_num = 0);
+  void dispatch(TaskCallbacks<ThreadTaskDispatcher>::TaskFunction* task, void* task_context, const uint32_t task_count);
+  constexpr uint32_t thread_num() const { return thread_num_; }
+  TaskCallbacks<ThreadTaskDispatcher> callbacks();
+ private:
+  uint32_t thread_num_;
+};
+}
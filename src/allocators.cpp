@@ -0,0 +1,322 @@
+#include <bit>
+#include <stdint.h>
+#include "tote/allocators.h"
+namespace tote {
+uint32_t Align(const uint32_t val, const uint32_t alignment);
+namespace {
+uintptr_t AlignAddress(const uintptr_t address, const uintptr_t alignment) {
+  const auto mask = alignment - 1;
+  return (address + mask) & ~mask;
+}
+void AddAllocation(AllocatorStatistics* statistics, const uint64_t bytes) {
+  statistics->live_bytes += bytes;
+  if (statistics->peak_bytes < statistics->live_bytes) {
+    statistics->peak_bytes = statistics->live_bytes;
+  }
+  statistics->allocation_count++;
+}
+void RemoveAllocation(AllocatorStatistics* statistics, const uint64_t bytes) {
+  statistics->live_bytes -= bytes;
+  statistics->deallocation_count++;
+}
+template <typename T>
+void* AllocateWith(const SizeType size, const uint32_t alignment, T* allocator) {
+  // buffers of these allocators are addressed in 32 bits.
+  if constexpr (sizeof(SizeType) > sizeof(uint32_t)) {
+    if (size > UINT32_MAX) { return nullptr; }
+  }
+  return allocator->allocate(static_cast<uint32_t>(size), alignment);
+}
+template <typename T>
+void DeallocateWith(void* ptr, T* allocator) {
+  allocator->deallocate(ptr);
+}
+template <typename T>
+void* ReallocateWith(void* ptr, const SizeType old_size, const SizeType new_size, const uint32_t alignment, T* allocator) {
+  if (reinterpret_cast<uintptr_t>(ptr) % alignment != 0) { return nullptr; }
+  if constexpr (sizeof(SizeType) > sizeof(uint32_t)) {
+    if (new_size > UINT32_MAX) { return nullptr; }
+  }
+  return allocator->reallocate(ptr, static_cast<uint32_t>(old_size), static_cast<uint32_t>(new_size));
+}
+template <typename T>
+AllocatorCallbacks<T> GetCallbacks(T* allocator) {
+  return {
+    .allocate = AllocateWith<T>,
+    .deallocate = DeallocateWith<T>,
+    .user_context = allocator,
+    .reallocate = ReallocateWith<T>,
+  };
+}
+} // namespace
+LinearAllocator::LinearAllocator(void* buffer, const uint32_t size)
+    : buffer_(static_cast<uint8_t*>(buffer))
+    , size_(size)
+{}
+void* LinearAllocator::allocate(const uint32_t size, const uint32_t alignment) {
+  const auto head = reinterpret_cast<uintptr_t>(buffer_);
+  const auto offset = static_cast<uint32_t>(AlignAddress(head + used_, alignment) - head);
+  if (offset > size_ || size > size_ - offset) { return nullptr; }
+  const auto prev_used = used_;
+  last_offset_ = offset;
+  used_ = offset + size;
+  AddAllocation(&statistics_, used_ - prev_used);
+  return buffer_ + offset;
+}
+void LinearAllocator::deallocate(void*) {
+  // memory is reclaimed on reset().
+  statistics_.deallocation_count++;
+}
+void* LinearAllocator::reallocate(void* ptr, const uint32_t, const uint32_t new_size) {
+  if (ptr != buffer_ + last_offset_ || new_size > size_ - last_offset_) { return nullptr; }
+  const auto new_used = last_offset_ + new_size;
+  if (new_used > used_) {
+    statistics_.live_bytes += new_used - used_;
+    if (statistics_.peak_bytes < statistics_.live_bytes) {
+      statistics_.peak_bytes = statistics_.live_bytes;
+    }
+  } else {
+    statistics_.live_bytes -= used_ - new_used;
+  }
+  used_ = new_used;
+  return ptr;
+}
+void LinearAllocator::reset() {
+  used_ = 0;
+  last_offset_ = 0;
+  statistics_.live_bytes = 0;
+}
+AllocatorCallbacks<LinearAllocator> LinearAllocator::callbacks() {
+  return GetCallbacks(this);
+}
+PoolAllocator::PoolAllocator(void* buffer, const uint32_t size, const uint32_t block_size, const uint32_t block_alignment)
+    : block_size_(Align(block_size < sizeof(FreeBlock) ? static_cast<uint32_t>(sizeof(FreeBlock)) : block_size, block_alignment))
+    , block_alignment_(block_alignment)
+{
+  const auto head = reinterpret_cast<uintptr_t>(buffer);
+  const auto offset = static_cast<uint32_t>(AlignAddress(head, block_alignment_) - head);
+  if (offset >= size) { return; }
+  block_num_ = (size - offset) / block_size_;
+  free_block_num_ = block_num_;
+  auto block_head = static_cast<uint8_t*>(buffer) + offset;
+  for (uint32_t i = block_num_; i > 0; i--) {
+    auto block = reinterpret_cast<FreeBlock*>(block_head + block_size_ * (i - 1));
+    block->next = free_list_;
+    free_list_ = block;
+  }
+}
+void* PoolAllocator::allocate(const uint32_t size, const uint32_t alignment) {
+  if (size > block_size_ || alignment > block_alignment_ || free_list_ == nullptr) { return nullptr; }
+  auto block = free_list_;
+  free_list_ = block->next;
+  free_block_num_--;
+  AddAllocation(&statistics_, block_size_);
+  return block;
+}
+void PoolAllocator::deallocate(void* ptr) {
+  if (ptr == nullptr) { return; }
+  auto block = static_cast<FreeBlock*>(ptr);
+  block->next = free_list_;
+  free_list_ = block;
+  free_block_num_++;
+  RemoveAllocation(&statistics_, block_size_);
+}
+void* PoolAllocator::reallocate(void* ptr, const uint32_t, const uint32_t new_size) {
+  return new_size <= block_size_ ? ptr : nullptr;
+}
+AllocatorCallbacks<PoolAllocator> PoolAllocator::callbacks() {
+  return GetCallbacks(this);
+}
+namespace {
+constexpr uint32_t kTlsfFlagFree = 1;
+constexpr uint32_t kTlsfFlagPrevFree = 2;
+} // namespace
+uint8_t* TlsfAllocator::get_data(Block* block) {
+  return reinterpret_cast<uint8_t*>(block) + kHeaderSize;
+}
+TlsfAllocator::Block* TlsfAllocator::get_block(void* data) {
+  return reinterpret_cast<Block*>(static_cast<uint8_t*>(data) - kHeaderSize);
+}
+TlsfAllocator::Block* TlsfAllocator::get_next_physical(Block* block) {
+  return reinterpret_cast<Block*>(get_data(block) + block->size);
+}
+void TlsfAllocator::mark_free(Block* block) {
+  block->flags |= kTlsfFlagFree;
+  auto next = get_next_physical(block);
+  next->flags |= kTlsfFlagPrevFree;
+  next->prev_physical = block;
+}
+void TlsfAllocator::mark_used(Block* block) {
+  block->flags &= ~kTlsfFlagFree;
+  get_next_physical(block)->flags &= ~kTlsfFlagPrevFree;
+}
+void TlsfAllocator::get_list_index(const uint32_t size, uint32_t* fl, uint32_t* sl) {
+  if (size < kSmallBlockSize) {
+    *fl = 0;
+    *sl = size / (kSmallBlockSize / kSlIndexCount);
+    return;
+  }
+  const auto f = static_cast<uint32_t>(std::bit_width(size)) - 1;
+  *sl = (size >> (f - kSlIndexCountLog2)) ^ kSlIndexCount;
+  *fl = f - (kFlIndexShift - 1);
+}
+void TlsfAllocator::insert_free_block(Block* block) {
+  uint32_t fl{}, sl{};
+  get_list_index(block->size, &fl, &sl);
+  auto head = free_lists_[fl][sl];
+  block->next_free = head;
+  block->prev_free = nullptr;
+  if (head) {
+    head->prev_free = block;
+  }
+  free_lists_[fl][sl] = block;
+  fl_bitmap_ |= 1U << fl;
+  sl_bitmap_[fl] |= 1U << sl;
+}
+void TlsfAllocator::remove_free_block(Block* block) {
+  uint32_t fl{}, sl{};
+  get_list_index(block->size, &fl, &sl);
+  if (block->prev_free) {
+    block->prev_free->next_free = block->next_free;
+  } else {
+    free_lists_[fl][sl] = block->next_free;
+  }
+  if (block->next_free) {
+    block->next_free->prev_free = block->prev_free;
+  }
+  if (free_lists_[fl][sl] == nullptr) {
+    sl_bitmap_[fl] &= ~(1U << sl);
+    if (sl_bitmap_[fl] == 0) {
+      fl_bitmap_ &= ~(1U << fl);
+    }
+  }
+}
+TlsfAllocator::Block* TlsfAllocator::find_free_block(const uint32_t size) {
+  // round up to the next list so that any block in it is large enough.
+  auto rounded_size = size;
+  if (size >= kSmallBlockSize) {
+    rounded_size += (1U << (static_cast<uint32_t>(std::bit_width(size)) - 1 - kSlIndexCountLog2)) - 1;
+  }
+  uint32_t fl{}, sl{};
+  get_list_index(rounded_size, &fl, &sl);
+  if (fl >= kFlIndexCount) { return nullptr; }
+  auto sl_map = sl_bitmap_[fl] & (~0U << sl);
+  if (sl_map == 0) {
+    const auto fl_map = fl + 1 < kFlIndexCount ? fl_bitmap_ & (~0U << (fl + 1)) : 0;
+    if (fl_map == 0) { return nullptr; }
+    fl = static_cast<uint32_t>(std::countr_zero(fl_map));
+    sl_map = sl_bitmap_[fl];
+  }
+  sl = static_cast<uint32_t>(std::countr_zero(sl_map));
+  auto block = free_lists_[fl][sl];
+  remove_free_block(block);
+  return block;
+}
+TlsfAllocator::Block* TlsfAllocator::split(Block* block, const uint32_t size) {
+  auto rest = reinterpret_cast<Block*>(get_data(block) + size);
+  rest->size = block->size - size - kHeaderSize;
+  rest->prev_physical = block;
+  rest->flags = kTlsfFlagPrevFree;
+  block->size = size;
+  mark_free(rest);
+  return rest;
+}
+TlsfAllocator::Block* TlsfAllocator::merge_prev(Block* block) {
+  if ((block->flags & kTlsfFlagPrevFree) == 0) { return block; }
+  auto prev = block->prev_physical;
+  remove_free_block(prev);
+  prev->size += kHeaderSize + block->size;
+  mark_free(prev);
+  return prev;
+}
+void TlsfAllocator::merge_next(Block* block) {
+  auto next = get_next_physical(block);
+  if ((next->flags & kTlsfFlagFree) == 0) { return; }
+  remove_free_block(next);
+  block->size += kHeaderSize + next->size;
+  mark_free(block);
+}
+void TlsfAllocator::add_live_bytes(const uint32_t bytes) {
+  statistics_.live_bytes += bytes;
+  if (statistics_.peak_bytes < statistics_.live_bytes) {
+    statistics_.peak_bytes = statistics_.live_bytes;
+  }
+}
+TlsfAllocator::TlsfAllocator(void* buffer, const uint32_t size) {
+  const auto head = reinterpret_cast<uintptr_t>(buffer);
+  const auto offset = static_cast<uint32_t>(AlignAddress(head, kAlignment) - head);
+  if (offset >= size || size - offset < kHeaderSize * 2 + kMinBlockSize) { return; }
+  const auto usable_size = (size - offset) & ~(kAlignment - 1);
+  // a single free block followed by a zero sized used sentinel block.
+  auto block = reinterpret_cast<Block*>(static_cast<uint8_t*>(buffer) + offset);
+  block->size = usable_size - kHeaderSize * 2;
+  block->flags = 0;
+  auto sentinel = get_next_physical(block);
+  sentinel->size = 0;
+  sentinel->flags = 0;
+  mark_free(block);
+  insert_free_block(block);
+}
+void* TlsfAllocator::allocate(const uint32_t size, const uint32_t alignment) {
+  if (size > (1U << 31)) { return nullptr; }
+  const auto adjusted_size = size < kMinBlockSize ? kMinBlockSize : Align(size, kAlignment);
+  Block* block{};
+  if (alignment <= kAlignment) {
+    block = find_free_block(adjusted_size);
+    if (block == nullptr) { return nullptr; }
+  } else {
+    // room for aligning the address and splitting off a free block in front of it.
+    const auto gap_min = kHeaderSize + kMinBlockSize;
+    if (alignment > (1U << 30)) { return nullptr; }
+    block = find_free_block(adjusted_size + alignment + gap_min);
+    if (block == nullptr) { return nullptr; }
+    const auto data = reinterpret_cast<uintptr_t>(get_data(block));
+    auto aligned = AlignAddress(data, alignment);
+    if (aligned != data && aligned - data < gap_min) {
+      aligned = AlignAddress(data + gap_min, alignment);
+    }
+    if (aligned != data) {
+      auto aligned_block = split(block, static_cast<uint32_t>(aligned - data) - kHeaderSize);
+      mark_free(block);
+      insert_free_block(block);
+      block = aligned_block;
+    }
+  }
+  if (block->size >= adjusted_size + kHeaderSize + kMinBlockSize) {
+    insert_free_block(split(block, adjusted_size));
+  }
+  mark_used(block);
+  add_live_bytes(block->size);
+  statistics_.allocation_count++;
+  return get_data(block);
+}
+void TlsfAllocator::deallocate(void* ptr) {
+  if (ptr == nullptr) { return; }
+  auto block = get_block(ptr);
+  RemoveAllocation(&statistics_, block->size);
+  mark_free(block);
+  block = merge_prev(block);
+  merge_next(block);
+  insert_free_block(block);
+}
+void* TlsfAllocator::reallocate(void* ptr, const uint32_t, const uint32_t new_size) {
+  if (new_size > (1U << 31)) { return nullptr; }
+  auto block = get_block(ptr);
+  const auto adjusted_size = new_size < kMinBlockSize ? kMinBlockSize : Align(new_size, kAlignment);
+  if (adjusted_size <= block->size) { return ptr; }
+  auto next = get_next_physical(block);
+  if ((next->flags & kTlsfFlagFree) == 0 || block->size + kHeaderSize + next->size < adjusted_size) { return nullptr; }
+  const auto prev_size = block->size;
+  remove_free_block(next);
+  block->size += kHeaderSize + next->size;
+  if (block->size >= adjusted_size + kHeaderSize + kMinBlockSize) {
+    insert_free_block(split(block, adjusted_size));
+  }
+  mark_used(block);
+  add_live_bytes(block->size - prev_size);
+  return ptr;
+}
+AllocatorCallbacks<TlsfAllocator> TlsfAllocator::callbacks() {
+  return GetCallbacks(this);
+}
+} // namespace tote
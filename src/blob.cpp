@@ -0,0 +1,45 @@
+#include <stdint.h>
+#include "tote/blob.h"
+namespace tote {
+namespace {
+uint64_t AlignOffset(const uint64_t offset) {
+  const uint64_t mask = kCacheLineSize - 1;
+  return (offset + mask) & ~mask;
+}
+bool IsWithinBlob(const uint64_t offset, const uint64_t size, const uint64_t blob_size) {
+  return offset <= blob_size && size <= blob_size - offset;
+}
+} // namespace
+BlobHeader MakeBlobHeader(const BlobKind kind, const uint32_t key_size, const uint32_t value_size, const uint32_t size, const uint32_t capacity) {
+  BlobHeader header{};
+  header.magic = kBlobMagic;
+  header.version = kBlobVersion;
+  header.kind = kind;
+  header.key_size = key_size;
+  header.value_size = value_size;
+  header.size = size;
+  header.capacity = capacity;
+  // flags exist only for hash maps.
+  const uint64_t flags_size = kind == BlobKind::kHashMap ? capacity : 0;
+  header.flags_offset = sizeof(BlobHeader);
+  header.keys_offset = AlignOffset(header.flags_offset + flags_size);
+  header.values_offset = AlignOffset(header.keys_offset + static_cast<uint64_t>(key_size) * capacity);
+  header.blob_size = AlignOffset(header.values_offset + static_cast<uint64_t>(value_size) * capacity);
+  return header;
+}
+const BlobHeader* GetBlobHeader(const void* blob, const uint64_t blob_size, const BlobKind kind, const uint32_t key_size, const uint32_t value_size, const uint32_t key_alignment, const uint32_t value_alignment) {
+  if (blob == nullptr || blob_size < sizeof(BlobHeader)) { return nullptr; }
+  if (reinterpret_cast<uintptr_t>(blob) % alignof(BlobHeader) != 0) { return nullptr; }
+  const auto header = static_cast<const BlobHeader*>(blob);
+  if (header->magic != kBlobMagic || header->version != kBlobVersion || header->kind != kind) { return nullptr; }
+  if (header->key_size != key_size || header->value_size != value_size) { return nullptr; }
+  if (header->size > header->capacity) { return nullptr; }
+  // offsets are recomputed rather than trusted.
+  const auto expected = MakeBlobHeader(kind, key_size, value_size, header->size, header->capacity);
+  if (header->flags_offset != expected.flags_offset || header->keys_offset != expected.keys_offset || header->values_offset != expected.values_offset) { return nullptr; }
+  if (header->blob_size != expected.blob_size || !IsWithinBlob(0, header->blob_size, blob_size)) { return nullptr; }
+  const auto head = reinterpret_cast<uintptr_t>(blob);
+  if ((head + header->keys_offset) % key_alignment != 0 || (head + header->values_offset) % value_alignment != 0) { return nullptr; }
+  return header;
+}
+} // namespace tote
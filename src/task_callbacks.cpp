@@ -0,0 +1,44 @@
+#include <atomic>
+#include <stdint.h>
+#include <thread>
+#include <vector>
+#include "tote/task_callbacks.h"
+namespace tote {
+namespace {
+void DispatchWithThreads(TaskCallbacks<ThreadTaskDispatcher>::TaskFunction* task, void* task_context, const uint32_t task_count, ThreadTaskDispatcher* dispatcher) {
+  dispatcher->dispatch(task, task_context, task_count);
+}
+} // namespace
+ThreadTaskDispatcher::ThreadTaskDispatcher(const uint32_t thread_num)
+    : thread_num_(thread_num > 0 ? thread_num : std::thread::hardware_concurrency())
+{
+  if (thread_num_ == 0) {
+    thread_num_ = 1;
+  }
+}
+void ThreadTaskDispatcher::dispatch(TaskCallbacks<ThreadTaskDispatcher>::TaskFunction* task, void* task_context, const uint32_t task_count) {
+  std::atomic<uint32_t> next_task_index{0};
+  auto run = [&]() {
+    for (auto i = next_task_index.fetch_add(1, std::memory_order_relaxed); i < task_count; i = next_task_index.fetch_add(1, std::memory_order_relaxed)) {
+      task(task_context, i);
+    }
+  };
+  // calling thread works as well.
+  const auto worker_num = (task_count < thread_num_ ? task_count : thread_num_);
+  std::vector<std::thread> threads;
+  for (uint32_t i = 1; i < worker_num; i++) {
+    threads.emplace_back(run);
+  }
+  run();
+  for (auto& thread : threads) {
+    thread.join();
+  }
+}
+TaskCallbacks<ThreadTaskDispatcher> ThreadTaskDispatcher::callbacks() {
+  return {
+    .dispatch = DispatchWithThreads,
+    .user_context = this,
+    .concurrency = thread_num_,
+  };
+}
+} // namespace tote
@@ -1,14 +1,19 @@
 #include <stdint.h>
 #include <string.h>
+#include "tote/hash_map.h"
 namespace tote {
+namespace {
+constexpr uint32_t kMaxPrimeNumber = 4294967291U; // largest prime number in 32 bits.
+} // namespace
 bool IsPrimeNumber(const uint32_t n) {
   if (n <= 1) { return false; }
-  for (uint32_t i = 2; i * i <= n; i++) {
+  for (uint32_t i = 2; static_cast<uint64_t>(i) * i <= n; i++) {
     if (n % i == 0) { return false; }
   }
   return true;
 }
 uint32_t GetLargerOrEqualPrimeNumber(const uint32_t n) {
+  if (n >= kMaxPrimeNumber) { return kMaxPrimeNumber; }
   if (IsPrimeNumber(n)) { return n; }
   if (n <= 2) { return 2; }
   auto p = n + 1 + n % 2; // odd number larger than n.
@@ -21,6 +26,43 @@ bool IsCloseToFull(const uint32_t load, const uint32_t capacity) {
   const float loadFactor = 0.65f;
   return static_cast<float>(load) / static_cast<float>(capacity) >= loadFactor;
 }
+uint32_t GetMinCapacityNotCloseToFull(const uint32_t load) {
+  const float loadFactor = 0.65f;
+  const auto min_capacity = static_cast<float>(load) / loadFactor;
+  if (min_capacity >= static_cast<float>(UINT32_MAX)) { return UINT32_MAX; }
+  auto capacity = static_cast<uint32_t>(min_capacity);
+  while (capacity < UINT32_MAX && IsCloseToFull(load, capacity)) {
+    capacity++;
+  }
+  return capacity;
+}
+uint32_t GetGrownCapacity(const uint32_t capacity, const uint32_t numerator, const uint32_t denominator) {
+  const auto grown = static_cast<uint64_t>(capacity) * numerator / denominator;
+  if (grown <= capacity) { return capacity < UINT32_MAX ? capacity + 1 : capacity; }
+  if (grown > UINT32_MAX) { return UINT32_MAX; }
+  return static_cast<uint32_t>(grown);
+}
+uint32_t GetLargerOrEqualPowerOfTwo(const uint32_t n) {
+  if (n <= 1) { return 1; }
+  if (n > 0x80000000U) { return 0x80000000U; }
+  auto p = n - 1;
+  p |= p >> 1;
+  p |= p >> 2;
+  p |= p >> 4;
+  p |= p >> 8;
+  p |= p >> 16;
+  return p + 1;
+}
+uint64_t HashBytes(const void* data, const uint32_t size) {
+  // FNV-1a followed by a finalizer to spread entropy into low bits.
+  const auto bytes = static_cast<const uint8_t*>(data);
+  uint64_t h = 0xcbf29ce484222325ULL;
+  for (uint32_t i = 0; i < size; i++) {
+    h ^= bytes[i];
+    h *= 0x100000001b3ULL;
+  }
+  return MixHash(h);
+}
 uint32_t Align(const uint32_t val, const uint32_t alignment) {
   const auto mask = alignment - 1;
   return (val + mask) & ~mask;
@@ -7,7 +7,7 @@ struct UserContext {
   uint32_t dealloc_count = 0;
   std::unordered_set<void*> ptr{};
 };
-void* Allocate(const uint32_t size, const uint32_t alignment, UserContext* user_context) {
+void* Allocate(const tote::SizeType size, const uint32_t alignment, UserContext* user_context) {
   user_context->alloc_count++;
 #ifdef _MSC_VER
   auto ptr = _aligned_malloc(size, alignment);
@@ -0,0 +1,163 @@
+#include <stdlib.h>
+#include <string.h>
+#include "tote/allocators.h"
+#include "tote/array.h"
+#include "tote/hash_map.h"
+#include <doctest/doctest.h>
+namespace {
+bool IsFilledWith(const void* ptr, const uint32_t size, const uint8_t val) {
+  const auto data = static_cast<const uint8_t*>(ptr);
+  for (uint32_t i = 0; i < size; i++) {
+    if (data[i] != val) { return false; }
+  }
+  return true;
+}
+} // namespace
+TEST_CASE("linear allocator") {
+  using namespace tote;
+  alignas(64) uint8_t buffer[1024];
+  LinearAllocator allocator(buffer, sizeof(buffer));
+  CHECK_EQ(allocator.capacity(), 1024);
+  auto a = allocator.allocate(3, 1);
+  CHECK_EQ(a, buffer);
+  auto b = allocator.allocate(8, 8);
+  CHECK_EQ(b, buffer + 8);
+  auto c = allocator.allocate(1, 64);
+  CHECK_EQ(c, buffer + 64);
+  CHECK_EQ(allocator.used(), 65);
+  CHECK_EQ(allocator.statistics().live_bytes, 65);
+  CHECK_EQ(allocator.statistics().allocation_count, 3);
+  CHECK_EQ(allocator.reallocate(b, 8, 16), nullptr);
+  CHECK_EQ(allocator.reallocate(c, 1, 100), c);
+  CHECK_EQ(allocator.used(), 164);
+  CHECK_EQ(allocator.allocate(1024, 1), nullptr);
+  allocator.deallocate(a);
+  CHECK_EQ(allocator.statistics().deallocation_count, 1);
+  CHECK_EQ(allocator.used(), 164);
+  allocator.reset();
+  CHECK_EQ(allocator.used(), 0);
+  CHECK_EQ(allocator.statistics().live_bytes, 0);
+  CHECK_EQ(allocator.statistics().peak_bytes, 164);
+  CHECK_EQ(allocator.allocate(1024, 1), buffer);
+  CHECK_EQ(allocator.allocate(1, 1), nullptr);
+  allocator.reset();
+  {
+    ResizableArray<uint32_t, LinearAllocator> resizable_array(allocator.callbacks(), 0, 1);
+    const auto allocation_count = allocator.statistics().allocation_count;
+    for (uint32_t i = 0; i < 150; i++) {
+      resizable_array.push_back(i);
+    }
+    // grown in place as the last allocation.
+    CHECK_EQ(allocator.statistics().allocation_count, allocation_count);
+    CHECK_EQ(resizable_array.begin(), reinterpret_cast<uint32_t*>(buffer));
+    CHECK_EQ(resizable_array[149], 149);
+  }
+  allocator.reset();
+  {
+    HashMap<uint32_t, uint32_t, LinearAllocator> hash_map(allocator.callbacks(), 16);
+    for (uint32_t i = 0; i < 8; i++) {
+      hash_map.insert(i, i);
+    }
+    CHECK_EQ(hash_map[7], 7);
+  }
+  CHECK_GT(allocator.used(), 0);
+}
+TEST_CASE("pool allocator") {
+  using namespace tote;
+  alignas(16) uint8_t buffer[16 * 33 + 8];
+  PoolAllocator allocator(buffer + 8, sizeof(buffer) - 8, 10);
+  CHECK_EQ(allocator.block_size(), 16);
+  CHECK_EQ(allocator.block_num(), 32);
+  CHECK_EQ(allocator.free_block_num(), 32);
+  void* ptr[32]{};
+  for (uint32_t i = 0; i < 32; i++) {
+    ptr[i] = allocator.allocate(16, 16);
+    CHECK_NE(ptr[i], nullptr);
+    CHECK_EQ(reinterpret_cast<uintptr_t>(ptr[i]) % 16, 0);
+  }
+  CHECK_EQ(allocator.allocate(16, 16), nullptr);
+  CHECK_EQ(allocator.free_block_num(), 0);
+  CHECK_EQ(allocator.statistics().live_bytes, 16 * 32);
+  allocator.deallocate(ptr[3]);
+  allocator.deallocate(ptr[5]);
+  CHECK_EQ(allocator.free_block_num(), 2);
+  CHECK_EQ(allocator.allocate(16, 16), ptr[5]);
+  CHECK_EQ(allocator.allocate(16, 16), ptr[3]);
+  CHECK_EQ(allocator.allocate(17, 16), nullptr);
+  CHECK_EQ(allocator.allocate(8, 32), nullptr);
+  CHECK_EQ(allocator.reallocate(ptr[0], 8, 16), ptr[0]);
+  CHECK_EQ(allocator.reallocate(ptr[0], 8, 17), nullptr);
+  for (uint32_t i = 0; i < 32; i++) {
+    allocator.deallocate(ptr[i]);
+  }
+  CHECK_EQ(allocator.free_block_num(), 32);
+  CHECK_EQ(allocator.statistics().live_bytes, 0);
+  CHECK_EQ(allocator.statistics().peak_bytes, 16 * 32);
+  CHECK_EQ(allocator.statistics().allocation_count, 34);
+  CHECK_EQ(allocator.statistics().deallocation_count, 34);
+}
+TEST_CASE("tlsf allocator") {
+  using namespace tote;
+  const uint32_t buffer_size = 1024 * 1024;
+  auto buffer = static_cast<uint8_t*>(malloc(buffer_size));
+  {
+    TlsfAllocator allocator(buffer, buffer_size);
+    // a request is rounded up to the next size class, so not all of the buffer can be taken at once.
+    auto whole = allocator.allocate(buffer_size / 8 * 7, 8);
+    CHECK_NE(whole, nullptr);
+    CHECK_EQ(allocator.allocate(buffer_size / 8, 8), nullptr);
+    allocator.deallocate(whole);
+    void* ptr[256]{};
+    uint32_t size[256]{};
+    uint32_t seed = 1;
+    for (uint32_t loop = 0; loop < 8; loop++) {
+      for (uint32_t i = 0; i < 256; i++) {
+        seed = seed * 1103515245 + 12345;
+        if (ptr[i] != nullptr && (seed >> 16) % 2 == 0) {
+          CHECK_UNARY(IsFilledWith(ptr[i], size[i], static_cast<uint8_t>(i)));
+          allocator.deallocate(ptr[i]);
+          ptr[i] = nullptr;
+        }
+        if (ptr[i] == nullptr) {
+          size[i] = (seed >> 8) % 2000 + 1;
+          const auto alignment = 1U << ((seed >> 4) % 8);
+          ptr[i] = allocator.allocate(size[i], alignment);
+          CHECK_NE(ptr[i], nullptr);
+          CHECK_EQ(reinterpret_cast<uintptr_t>(ptr[i]) % alignment, 0);
+          memset(ptr[i], static_cast<int>(i), size[i]);
+        }
+      }
+    }
+    CHECK_GT(allocator.statistics().live_bytes, 0);
+    CHECK_GE(allocator.statistics().peak_bytes, allocator.statistics().live_bytes);
+    for (uint32_t i = 0; i < 256; i++) {
+      CHECK_UNARY(IsFilledWith(ptr[i], size[i], static_cast<uint8_t>(i)));
+      allocator.deallocate(ptr[i]);
+    }
+    CHECK_EQ(allocator.statistics().live_bytes, 0);
+    CHECK_EQ(allocator.statistics().allocation_count, allocator.statistics().deallocation_count);
+    // free blocks are merged back into one.
+    whole = allocator.allocate(buffer_size / 8 * 7, 8);
+    CHECK_NE(whole, nullptr);
+    allocator.deallocate(whole);
+    auto a = allocator.allocate(100, 8);
+    auto b = allocator.allocate(100, 8);
+    CHECK_EQ(allocator.reallocate(a, 100, 1000), nullptr);
+    CHECK_EQ(allocator.reallocate(b, 100, 1000), b);
+    allocator.deallocate(a);
+    CHECK_EQ(allocator.reallocate(b, 1000, 100000), b);
+    {
+      ResizableArray<uint64_t, TlsfAllocator> resizable_array(allocator.callbacks());
+      HashMap<uint32_t, uint64_t, TlsfAllocator> hash_map(allocator.callbacks());
+      for (uint32_t i = 0; i < 1000; i++) {
+        resizable_array.push_back(i);
+        hash_map.insert(i, i);
+      }
+      CHECK_EQ(resizable_array[999], 999);
+      CHECK_EQ(hash_map[999], 999);
+    }
+    allocator.deallocate(b);
+    CHECK_EQ(allocator.statistics().live_bytes, 0);
+  }
+  free(buffer);
+}
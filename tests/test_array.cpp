@@ -1,6 +1,31 @@
+#include <string>
+#include <vector>
+#ifndef _WIN32
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
 #include "tote/array.h"
 #include "test_alloc.inl"
 #include <doctest/doctest.h>
+#ifndef _WIN32
+namespace {
+/**
+ * runs f in a child process and tells whether it was killed by abort().
+ **/
+template <typename F>
+bool AbortsInChildProcess(F&& f) {
+  const auto pid = fork();
+  if (pid == 0) {
+    f();
+    _exit(0);
+  }
+  int status = 0;
+  waitpid(pid, &status, 0);
+  return WIFSIGNALED(status) && WTERMSIG(status) == SIGABRT;
+}
+} // namespace
+#endif
 TEST_CASE("resizable array") {
   using namespace tote;
   UserContext user_context{};
@@ -186,3 +211,701 @@ TEST_CASE("move") {
   CHECK_EQ(user_context_d.alloc_count, user_context_d.dealloc_count);
   CHECK_UNARY(user_context_d.ptr.empty());
 }
+namespace {
+struct LifetimeCounter {
+  static inline int32_t constructed = 0;
+  static inline int32_t destructed = 0;
+  static inline int32_t moved = 0;
+  uint32_t value{};
+  LifetimeCounter(const uint32_t v) : value(v) { constructed++; }
+  LifetimeCounter(const LifetimeCounter& other) : value(other.value) { constructed++; }
+  LifetimeCounter(LifetimeCounter&& other) : value(other.value) { constructed++; moved++; other.value = 0; }
+  ~LifetimeCounter() { destructed++; }
+  LifetimeCounter& operator=(const LifetimeCounter&) = default;
+};
+} // namespace
+TEST_CASE("non trivially copyable element") {
+  using namespace tote;
+  UserContext user_context{};
+  {
+    ResizableArray<LifetimeCounter, UserContext> resizable_array({.allocate = Allocate, .deallocate = Deallocate, .user_context = &user_context,});
+    for (uint32_t i = 0; i < 10; i++) {
+      resizable_array.emplace_back(i);
+    }
+    CHECK_EQ(resizable_array.size(), 10);
+    for (uint32_t i = 0; i < 10; i++) {
+      CHECK_EQ(resizable_array[i].value, i);
+    }
+    CHECK_GT(LifetimeCounter::moved, 0);
+    CHECK_EQ(LifetimeCounter::constructed - LifetimeCounter::destructed, 10);
+    LifetimeCounter counter(100);
+    resizable_array.push_back(counter);
+    CHECK_EQ(counter.value, 100);
+    resizable_array.push_back(std::move(counter));
+    CHECK_EQ(counter.value, 0);
+    CHECK_EQ(resizable_array[10].value, 100);
+    CHECK_EQ(resizable_array[11].value, 100);
+    // element of itself as an argument while growing.
+    while (resizable_array.size() < resizable_array.capacity()) {
+      resizable_array.push_back(resizable_array[0]);
+    }
+    resizable_array.push_back(resizable_array[1]);
+    CHECK_EQ(resizable_array.back().value, 1);
+    const auto size = resizable_array.size();
+    CHECK_EQ(LifetimeCounter::constructed - LifetimeCounter::destructed, size + 1);
+    resizable_array.clear();
+    CHECK_EQ(LifetimeCounter::constructed - LifetimeCounter::destructed, 1);
+    resizable_array.emplace_back(1U);
+    resizable_array.emplace_back(2U);
+    resizable_array.release_allocated_buffer();
+    CHECK_EQ(LifetimeCounter::constructed - LifetimeCounter::destructed, 1);
+    resizable_array.emplace_back(3U);
+  }
+  CHECK_EQ(LifetimeCounter::constructed, LifetimeCounter::destructed);
+  CHECK_EQ(user_context.alloc_count, user_context.dealloc_count);
+  CHECK_UNARY(user_context.ptr.empty());
+}
+TEST_CASE("non default constructible element") {
+  using namespace tote;
+  static_assert(!std::is_default_constructible_v<LifetimeCounter>);
+  UserContext user_context{};
+  {
+    const auto constructed = LifetimeCounter::constructed;
+    ResizableArray<LifetimeCounter, UserContext> resizable_array({.allocate = Allocate, .deallocate = Deallocate, .user_context = &user_context,}, 0, 8);
+    CHECK_UNARY(resizable_array.empty());
+    CHECK_EQ(resizable_array.capacity(), 8);
+    CHECK_EQ(LifetimeCounter::constructed, constructed);
+    SmallArray<LifetimeCounter, 4, UserContext> small_array({.allocate = Allocate, .deallocate = Deallocate, .user_context = &user_context,}, 0, 8);
+    CHECK_UNARY(small_array.empty());
+    CHECK_EQ(small_array.capacity(), 8);
+    CHECK_EQ(LifetimeCounter::constructed, constructed);
+    resizable_array.resize(3, LifetimeCounter(7));
+    small_array.resize(3, LifetimeCounter(7));
+    CHECK_EQ(resizable_array[2].value, 7);
+    CHECK_EQ(small_array[2].value, 7);
+  }
+  CHECK_EQ(LifetimeCounter::constructed, LifetimeCounter::destructed);
+  CHECK_EQ(user_context.alloc_count, user_context.dealloc_count);
+  CHECK_UNARY(user_context.ptr.empty());
+#ifndef _WIN32
+  // elements left unconstructed by a non zero initial_size would be destructed later.
+  CHECK_UNARY(AbortsInChildProcess([] {
+    UserContext user_context{};
+    ResizableArray<LifetimeCounter, UserContext> resizable_array({.allocate = Allocate, .deallocate = Deallocate, .user_context = &user_context,}, 4);
+  }));
+  CHECK_UNARY(AbortsInChildProcess([] {
+    UserContext user_context{};
+    SmallArray<LifetimeCounter, 4, UserContext> small_array({.allocate = Allocate, .deallocate = Deallocate, .user_context = &user_context,}, 2);
+  }));
+#endif
+}
+TEST_CASE("string element") {
+  using namespace tote;
+  UserContext user_context{};
+  {
+    ResizableArray<std::string, UserContext> resizable_array({.allocate = Allocate, .deallocate = Deallocate, .user_context = &user_context,}, 2);
+    CHECK_EQ(resizable_array.size(), 2);
+    CHECK_UNARY(resizable_array[0].empty());
+    CHECK_UNARY(resizable_array[1].empty());
+    for (uint32_t i = 0; i < 100; i++) {
+      resizable_array.push_back(std::string(64, static_cast<char>('a' + i % 26)));
+    }
+    resizable_array.emplace_back(3, 'z');
+    CHECK_EQ(resizable_array.size(), 103);
+    CHECK_EQ(resizable_array[2], std::string(64, 'a'));
+    CHECK_EQ(resizable_array[101], std::string(64, 'v'));
+    CHECK_EQ(resizable_array.back(), "zzz");
+    ResizableArray<std::string, UserContext> resizable_array_b({.allocate = Allocate, .deallocate = Deallocate, .user_context = &user_context,});
+    resizable_array_b.push_back("b");
+    resizable_array_b = std::move(resizable_array);
+    CHECK_EQ(resizable_array_b.size(), 103);
+    CHECK_EQ(resizable_array_b.back(), "zzz");
+  }
+  CHECK_EQ(user_context.alloc_count, user_context.dealloc_count);
+  CHECK_UNARY(user_context.ptr.empty());
+}
+TEST_CASE("nested resizable array") {
+  using namespace tote;
+  UserContext user_context{};
+  AllocatorCallbacks<UserContext> allocator_callbacks {
+    .allocate = Allocate,
+    .deallocate = Deallocate,
+    .user_context = &user_context,
+  };
+  static_assert(IsTriviallyRelocatable<ResizableArray<uint32_t, UserContext>>::value);
+  {
+    ResizableArray<ResizableArray<uint32_t, UserContext>, UserContext> resizable_array(allocator_callbacks);
+    for (uint32_t i = 0; i < 10; i++) {
+      auto& inner = resizable_array.emplace_back(allocator_callbacks);
+      for (uint32_t j = 0; j <= i; j++) {
+        inner.push_back(j);
+      }
+    }
+    CHECK_EQ(resizable_array.size(), 10);
+    for (uint32_t i = 0; i < 10; i++) {
+      CHECK_EQ(resizable_array[i].size(), i + 1);
+      CHECK_EQ(resizable_array[i].back(), i);
+    }
+    resizable_array.clear();
+    CHECK_EQ(user_context.ptr.size(), 1);
+  }
+  CHECK_EQ(user_context.alloc_count, user_context.dealloc_count);
+  CHECK_UNARY(user_context.ptr.empty());
+}
+namespace {
+struct BumpArena {
+  alignas(16) uint8_t buffer[4096];
+  uint32_t used = 0;
+  uint32_t last_offset = 0;
+  uint32_t alloc_count = 0;
+  uint32_t expand_count = 0;
+};
+void* BumpAllocate(const tote::SizeType size, const uint32_t alignment, BumpArena* arena) {
+  const auto offset = (arena->used + alignment - 1) & ~(alignment - 1);
+  if (offset + size > sizeof(arena->buffer)) { return nullptr; }
+  arena->last_offset = offset;
+  arena->used = offset + size;
+  arena->alloc_count++;
+  return arena->buffer + offset;
+}
+void BumpDeallocate(void*, BumpArena*) {}
+void* BumpReallocate(void* ptr, const tote::SizeType, const tote::SizeType new_size, const uint32_t, BumpArena* arena) {
+  // the last allocation can be extended in place.
+  if (ptr != arena->buffer + arena->last_offset) { return nullptr; }
+  if (arena->last_offset + new_size > sizeof(arena->buffer)) { return nullptr; }
+  arena->used = arena->last_offset + new_size;
+  arena->expand_count++;
+  return ptr;
+}
+} // namespace
+TEST_CASE("reallocate in place") {
+  using namespace tote;
+  BumpArena arena{};
+  AllocatorCallbacks<BumpArena> allocator_callbacks {
+    .allocate = BumpAllocate,
+    .deallocate = BumpDeallocate,
+    .user_context = &arena,
+    .reallocate = BumpReallocate,
+  };
+  ResizableArray<uint32_t, BumpArena> resizable_array(allocator_callbacks, 0, 1);
+  const auto head = resizable_array.begin();
+  for (uint32_t i = 0; i < 100; i++) {
+    resizable_array.push_back(i);
+  }
+  CHECK_EQ(resizable_array.begin(), head);
+  CHECK_EQ(arena.alloc_count, 1);
+  CHECK_GT(arena.expand_count, 0);
+  for (uint32_t i = 0; i < 100; i++) {
+    CHECK_EQ(resizable_array[i], i);
+  }
+  // falls back to allocate and copy when the block cannot be expanded.
+  ResizableArray<uint32_t, BumpArena> resizable_array_b(allocator_callbacks, 0, 1);
+  resizable_array_b.push_back(0);
+  const auto expand_count = arena.expand_count;
+  for (uint32_t i = 0; i < 100; i++) {
+    resizable_array.push_back(i + 100);
+  }
+  CHECK_NE(resizable_array.begin(), head);
+  CHECK_EQ(arena.expand_count, expand_count);
+  CHECK_EQ(arena.alloc_count, 3);
+  for (uint32_t i = 0; i < 200; i++) {
+    CHECK_EQ(resizable_array[i], i);
+  }
+  CHECK_EQ(resizable_array_b[0], 0);
+}
+TEST_CASE("small array") {
+  using namespace tote;
+  UserContext user_context{};
+  AllocatorCallbacks<UserContext> allocator_callbacks {
+    .allocate = Allocate,
+    .deallocate = Deallocate,
+    .user_context = &user_context,
+  };
+  {
+    SmallArray<uint32_t, 4, UserContext> small_array(allocator_callbacks);
+    CHECK_UNARY(small_array.empty());
+    CHECK_UNARY(small_array.is_inline());
+    CHECK_EQ(small_array.capacity(), 4);
+    for (uint32_t i = 0; i < 4; i++) {
+      small_array.push_back(i);
+    }
+    CHECK_UNARY(small_array.is_inline());
+    CHECK_EQ(user_context.alloc_count, 0);
+    // spills to the allocator beyond inline capacity.
+    small_array.push_back(4);
+    CHECK_UNARY_FALSE(small_array.is_inline());
+    CHECK_GE(small_array.capacity(), 5);
+    CHECK_EQ(user_context.alloc_count, 1);
+    for (uint32_t i = 0; i < 100; i++) {
+      small_array.push_back(small_array[i]);
+    }
+    CHECK_EQ(small_array.size(), 105);
+    CHECK_EQ(small_array.front(), 0);
+    CHECK_EQ(small_array.back(), 99 % 5);
+    uint32_t sum = 0;
+    for (const auto val : small_array) {
+      sum += val;
+    }
+    CHECK_EQ(sum, 21 * 10);
+    auto small_array_b = std::move(small_array);
+    CHECK_UNARY(small_array.empty());
+    CHECK_UNARY(small_array.is_inline());
+    CHECK_EQ(small_array_b.size(), 105);
+    CHECK_EQ(small_array_b[104], 4);
+    small_array_b.release_allocated_buffer();
+    CHECK_UNARY(small_array_b.is_inline());
+    CHECK_EQ(small_array_b.capacity(), 4);
+    CHECK_EQ(user_context.alloc_count, user_context.dealloc_count);
+    SmallArray<uint32_t, 4, UserContext> small_array_c(allocator_callbacks, 3);
+    CHECK_EQ(small_array_c.size(), 3);
+    CHECK_UNARY(small_array_c.is_inline());
+    SmallArray<uint32_t, 4, UserContext> small_array_d(allocator_callbacks, 0, 8);
+    CHECK_UNARY_FALSE(small_array_d.is_inline());
+    CHECK_EQ(small_array_d.capacity(), 8);
+    small_array_d = std::move(small_array_c);
+    CHECK_UNARY(small_array_d.is_inline());
+    CHECK_EQ(small_array_d.size(), 3);
+  }
+  CHECK_EQ(user_context.alloc_count, user_context.dealloc_count);
+  CHECK_UNARY(user_context.ptr.empty());
+}
+TEST_CASE("small array non trivially copyable element") {
+  using namespace tote;
+  UserContext user_context{};
+  {
+    SmallArray<LifetimeCounter, 2, UserContext> small_array({.allocate = Allocate, .deallocate = Deallocate, .user_context = &user_context,});
+    const auto constructed = LifetimeCounter::constructed;
+    small_array.emplace_back(1U);
+    small_array.emplace_back(2U);
+    // inline elements are moved one by one.
+    auto small_array_b = std::move(small_array);
+    CHECK_EQ(small_array_b[0].value, 1);
+    CHECK_EQ(small_array_b[1].value, 2);
+    CHECK_EQ(LifetimeCounter::constructed - constructed, 4);
+    CHECK_EQ(LifetimeCounter::constructed - LifetimeCounter::destructed, 2);
+    for (uint32_t i = 3; i <= 10; i++) {
+      small_array_b.emplace_back(i);
+    }
+    CHECK_UNARY_FALSE(small_array_b.is_inline());
+    CHECK_EQ(LifetimeCounter::constructed - LifetimeCounter::destructed, 10);
+    // allocated buffer is handed over without touching the elements.
+    const auto moved = LifetimeCounter::moved;
+    small_array = std::move(small_array_b);
+    CHECK_EQ(LifetimeCounter::moved, moved);
+    CHECK_EQ(small_array.size(), 10);
+    CHECK_EQ(small_array[9].value, 10);
+    small_array.release_allocated_buffer();
+    CHECK_EQ(LifetimeCounter::constructed - LifetimeCounter::destructed, 0);
+    small_array.emplace_back(11U);
+  }
+  CHECK_EQ(LifetimeCounter::constructed, LifetimeCounter::destructed);
+  CHECK_EQ(user_context.alloc_count, user_context.dealloc_count);
+  CHECK_UNARY(user_context.ptr.empty());
+}
+TEST_CASE("small array bulk operations") {
+  using namespace tote;
+  UserContext user_context{};
+  AllocatorCallbacks<UserContext> allocator_callbacks {
+    .allocate = Allocate,
+    .deallocate = Deallocate,
+    .user_context = &user_context,
+  };
+  {
+    SmallArray<uint32_t, 8, UserContext> small_array(allocator_callbacks);
+    // reserve within N stays inline, beyond N allocates exactly.
+    small_array.reserve(8);
+    CHECK_UNARY(small_array.is_inline());
+    const uint32_t values[] = {0, 1, 2, 3, 4, 5};
+    small_array.append(values, 6);
+    CHECK_UNARY(small_array.is_inline());
+    CHECK_EQ(user_context.alloc_count, 0);
+    // appending itself while spilling to the allocator.
+    small_array.append(small_array.begin(), 6);
+    CHECK_UNARY_FALSE(small_array.is_inline());
+    CHECK_EQ(small_array.size(), 12);
+    CHECK_EQ(small_array[11], 5);
+    CHECK_EQ(user_context.alloc_count, 1);
+    CHECK_EQ(*small_array.find(4), 4);
+    CHECK_EQ(small_array.find(4), &small_array[4]);
+    CHECK_EQ(small_array.find(100), nullptr);
+    CHECK_EQ(small_array.remove(2), 2);
+    CHECK_EQ(small_array.size(), 10);
+    CHECK_EQ(small_array[2], 3);
+    CHECK_EQ(small_array.remove_if([](const uint32_t val) { return val % 2 == 1; }), 6);
+    CHECK_EQ(small_array.size(), 4);
+    CHECK_EQ(small_array[3], 4);
+    small_array.erase_unordered(0);
+    CHECK_EQ(small_array.size(), 3);
+    CHECK_EQ(small_array[0], 4);
+    // shrinking into N moves elements back inline.
+    small_array.shrink_to_fit();
+    CHECK_UNARY(small_array.is_inline());
+    CHECK_EQ(small_array.capacity(), 8);
+    CHECK_EQ(small_array[0], 4);
+    CHECK_EQ(small_array[2], 0);
+    CHECK_EQ(user_context.alloc_count, user_context.dealloc_count);
+    small_array.resize(20, 9);
+    CHECK_UNARY_FALSE(small_array.is_inline());
+    CHECK_EQ(small_array[19], 9);
+    small_array.resize(10);
+    small_array.shrink_to_fit();
+    CHECK_EQ(small_array.capacity(), 10);
+    CHECK_EQ(small_array[9], 9);
+    small_array.reserve(40);
+    CHECK_EQ(small_array.capacity(), 40);
+    CHECK_EQ(small_array[2], 0);
+    // capacity grows by the growth policy.
+    SmallArray<uint32_t, 2, UserContext, GeometricGrowth<3, 2>> small_array_b(allocator_callbacks);
+    for (uint32_t i = 0; i < 3; i++) {
+      small_array_b.push_back(i);
+    }
+    CHECK_EQ(small_array_b.capacity(), 4);
+  }
+  CHECK_EQ(user_context.alloc_count, user_context.dealloc_count);
+  CHECK_UNARY(user_context.ptr.empty());
+  {
+    SmallArray<std::string, 2, UserContext> small_array(allocator_callbacks);
+    small_array.resize(5, "long enough to be allocated on its own");
+    CHECK_UNARY_FALSE(small_array.is_inline());
+    small_array[1] = "b";
+    CHECK_EQ(small_array.remove("long enough to be allocated on its own"), 4);
+    CHECK_EQ(small_array.size(), 1);
+    small_array.push_back("c");
+    small_array.shrink_to_fit();
+    CHECK_UNARY(small_array.is_inline());
+    CHECK_EQ(small_array[0], "b");
+    CHECK_EQ(small_array[1], "c");
+    small_array.append(small_array.begin(), 2);
+    CHECK_UNARY_FALSE(small_array.is_inline());
+    CHECK_EQ(small_array[3], "c");
+    CHECK_EQ(small_array.remove_if([](const std::string& val) { return val == "b"; }), 2);
+    CHECK_EQ(small_array[1], "c");
+  }
+  CHECK_EQ(user_context.alloc_count, user_context.dealloc_count);
+  CHECK_UNARY(user_context.ptr.empty());
+}
+namespace {
+enum class Color : uint16_t { kRed, kGreen, kBlue };
+template <typename T, typename F>
+uint32_t CountFindMismatch(F&& make_value) {
+  using namespace tote;
+  UserContext user_context{};
+  uint32_t mismatch = 0;
+  {
+    ResizableArray<T, UserContext> resizable_array({.allocate = Allocate, .deallocate = Deallocate, .user_context = &user_context,});
+    // every position of sizes covering vector tails.
+    for (uint32_t size = 0; size < 70; size++) {
+      resizable_array.clear();
+      for (uint32_t i = 0; i < size; i++) {
+        resizable_array.push_back(make_value(i));
+      }
+      for (uint32_t i = 0; i < size; i++) {
+        if (resizable_array.find(make_value(i)) != &resizable_array[i]) { mismatch++; }
+      }
+      if (resizable_array.find(make_value(size)) != nullptr) { mismatch++; }
+    }
+  }
+  if (user_context.alloc_count != user_context.dealloc_count) { mismatch++; }
+  return mismatch;
+}
+template <typename T, typename F>
+uint32_t CountRemoveMismatch(F&& make_value) {
+  using namespace tote;
+  UserContext user_context{};
+  uint32_t mismatch = 0;
+  {
+    ResizableArray<T, UserContext> resizable_array({.allocate = Allocate, .deallocate = Deallocate, .user_context = &user_context,});
+    std::vector<T> expected;
+    uint32_t seed = 1;
+    // sizes covering every vector tail, with sparse to dense matches.
+    for (uint32_t size = 0; size < 70; size++) {
+      for (uint32_t period = 1; period <= 5; period++) {
+        resizable_array.clear();
+        expected.clear();
+        for (uint32_t i = 0; i < size; i++) {
+          seed = seed * 1103515245 + 12345;
+          const auto val = make_value((seed >> 16) % period);
+          resizable_array.push_back(val);
+          expected.push_back(val);
+        }
+        const auto removed = resizable_array.remove(make_value(0));
+        std::erase(expected, make_value(0));
+        if (removed != size - expected.size() || resizable_array.size() != expected.size()) {
+          mismatch++;
+          continue;
+        }
+        for (uint32_t i = 0; i < expected.size(); i++) {
+          if (!(resizable_array[i] == expected[i])) { mismatch++; }
+        }
+      }
+    }
+  }
+  if (user_context.alloc_count != user_context.dealloc_count) { mismatch++; }
+  return mismatch;
+}
+} // namespace
+TEST_CASE("find") {
+  static uint32_t values[71]{};
+  CHECK_EQ(CountFindMismatch<uint8_t>([](const uint32_t i) { return static_cast<uint8_t>(i + 1); }), 0);
+  CHECK_EQ(CountFindMismatch<int16_t>([](const uint32_t i) { return static_cast<int16_t>(-static_cast<int32_t>(i) * 257); }), 0);
+  CHECK_EQ(CountFindMismatch<uint32_t>([](const uint32_t i) { return i * 0x01010101U; }), 0);
+  // values differing only in upper 32 bits.
+  CHECK_EQ(CountFindMismatch<uint64_t>([](const uint32_t i) { return (static_cast<uint64_t>(i) << 32) | 7; }), 0);
+  CHECK_EQ(CountFindMismatch<uint32_t*>([](const uint32_t i) { return &values[i]; }), 0);
+  CHECK_EQ(CountFindMismatch<float>([](const uint32_t i) { return static_cast<float>(i) + 0.5f; }), 0);
+  CHECK_EQ(CountFindMismatch<std::string>([](const uint32_t i) { return std::to_string(i); }), 0);
+}
+TEST_CASE("remove") {
+  static uint32_t values[5]{};
+  CHECK_EQ(CountRemoveMismatch<uint8_t>([](const uint32_t i) { return static_cast<uint8_t>(i + 1); }), 0);
+  CHECK_EQ(CountRemoveMismatch<int16_t>([](const uint32_t i) { return static_cast<int16_t>(-static_cast<int32_t>(i) * 257); }), 0);
+  CHECK_EQ(CountRemoveMismatch<uint32_t>([](const uint32_t i) { return i * 0x01010101U; }), 0);
+  // values differing only in upper 32 bits.
+  CHECK_EQ(CountRemoveMismatch<uint64_t>([](const uint32_t i) { return (static_cast<uint64_t>(i) << 32) | 7; }), 0);
+  CHECK_EQ(CountRemoveMismatch<uint32_t*>([](const uint32_t i) { return &values[i]; }), 0);
+  CHECK_EQ(CountRemoveMismatch<Color>([](const uint32_t i) { return static_cast<Color>(i % 3); }), 0);
+  CHECK_EQ(CountRemoveMismatch<float>([](const uint32_t i) { return static_cast<float>(i) + 0.5f; }), 0);
+  CHECK_EQ(CountRemoveMismatch<std::string>([](const uint32_t i) { return std::to_string(i); }), 0);
+}
+TEST_CASE("bulk operations") {
+  using namespace tote;
+  UserContext user_context{};
+  AllocatorCallbacks<UserContext> allocator_callbacks {
+    .allocate = Allocate,
+    .deallocate = Deallocate,
+    .user_context = &user_context,
+  };
+  {
+    ResizableArray<uint32_t, UserContext> resizable_array(allocator_callbacks);
+    const uint32_t values[] = {0, 1, 2, 3, 4};
+    resizable_array.append(values, 5);
+    CHECK_EQ(resizable_array.size(), 5);
+    CHECK_EQ(user_context.alloc_count, 1);
+    // appending itself while growing.
+    resizable_array.append(resizable_array.begin(), resizable_array.size());
+    CHECK_EQ(resizable_array.size(), 10);
+    CHECK_EQ(resizable_array[9], 4);
+    resizable_array.resize(40, 7);
+    CHECK_EQ(resizable_array.size(), 40);
+    CHECK_EQ(resizable_array[9], 4);
+    CHECK_EQ(resizable_array[10], 7);
+    CHECK_EQ(resizable_array[39], 7);
+    resizable_array.resize(45);
+    CHECK_EQ(resizable_array[44], 0);
+    resizable_array.resize(20);
+    CHECK_EQ(resizable_array.size(), 20);
+    CHECK_EQ(resizable_array.find(7) - resizable_array.begin(), 10);
+    // 0 1 2 3 4 0 1 2 3 4 7 ... 7
+    CHECK_EQ(resizable_array.remove(7), 10);
+    CHECK_EQ(resizable_array.size(), 10);
+    CHECK_EQ(resizable_array.remove(0), 2);
+    CHECK_EQ(resizable_array.remove(100), 0);
+    CHECK_EQ(resizable_array.size(), 8);
+    const uint32_t expected[] = {1, 2, 3, 4, 1, 2, 3, 4};
+    uint32_t mismatch = 0;
+    for (uint32_t i = 0; i < 8; i++) {
+      if (resizable_array[i] != expected[i]) { mismatch++; }
+    }
+    CHECK_EQ(mismatch, 0);
+    CHECK_EQ(resizable_array.remove_if([](const uint32_t v) { return v % 2 == 0; }), 4);
+    CHECK_EQ(resizable_array.size(), 4);
+    CHECK_EQ(resizable_array[0], 1);
+    CHECK_EQ(resizable_array[1], 3);
+    CHECK_EQ(resizable_array[2], 1);
+    CHECK_EQ(resizable_array[3], 3);
+    resizable_array.erase_unordered(0);
+    CHECK_EQ(resizable_array.size(), 3);
+    CHECK_EQ(resizable_array[0], 3);
+    resizable_array.erase_unordered(2);
+    CHECK_EQ(resizable_array.size(), 2);
+    CHECK_EQ(resizable_array[0], 3);
+    CHECK_EQ(resizable_array[1], 3);
+    resizable_array.resize(0);
+    CHECK_UNARY(resizable_array.empty());
+    // fill of 8 byte elements.
+    ResizableArray<uint64_t, UserContext> resizable_array_b(allocator_callbacks);
+    resizable_array_b.resize(37, 0x0123456789abcdefULL);
+    CHECK_EQ(resizable_array_b.remove(0x0123456789abcdefULL), 37);
+  }
+  CHECK_EQ(user_context.alloc_count, user_context.dealloc_count);
+  CHECK_UNARY(user_context.ptr.empty());
+}
+TEST_CASE("bulk operations on non trivially copyable element") {
+  using namespace tote;
+  UserContext user_context{};
+  {
+    ResizableArray<std::string, UserContext> resizable_array({.allocate = Allocate, .deallocate = Deallocate, .user_context = &user_context,});
+    const std::string values[] = {"a", "bb", "a", "ccc"};
+    resizable_array.append(values, 4);
+    resizable_array.append(resizable_array.begin() + 1, 3);
+    CHECK_EQ(resizable_array.size(), 7);
+    CHECK_EQ(resizable_array[6], "ccc");
+    resizable_array.resize(10, resizable_array[1]);
+    CHECK_EQ(resizable_array[9], "bb");
+    CHECK_EQ(resizable_array.remove(resizable_array[0]), 3);
+    CHECK_EQ(resizable_array.size(), 7);
+    CHECK_EQ(resizable_array[0], "bb");
+    CHECK_EQ(resizable_array.remove_if([](const std::string& v) { return v.size() == 3; }), 2);
+    CHECK_EQ(resizable_array.size(), 5);
+    CHECK_EQ(resizable_array.find("ccc"), nullptr);
+    resizable_array.erase_unordered(0);
+    CHECK_EQ(resizable_array.size(), 4);
+    CHECK_EQ(resizable_array.remove("bb"), 4);
+  }
+  CHECK_EQ(user_context.alloc_count, user_context.dealloc_count);
+  CHECK_UNARY(user_context.ptr.empty());
+}
+TEST_CASE("overflow checked growth") {
+  using namespace tote;
+  CHECK_EQ(GetAllocationSize(0, 16), 0);
+  CHECK_EQ(GetAllocationSize(kMaxSize / 16, 16), kMaxSize / 16 * 16);
+  CHECK_EQ(GetAllocationSize(kMaxSize, 1), kMaxSize);
+  CHECK_EQ(GetGrownArrayCapacity<uint32_t>(0, 1), 2);
+  CHECK_EQ(GetGrownArrayCapacity<uint32_t>(3, 1), 8);
+  CHECK_EQ(GetGrownArrayCapacity<uint32_t>(3, 20), 23);
+  // doubling is clamped to the largest capacity whose byte size fits in SizeType.
+  constexpr auto kMaxCapacity = kMaxSize / 64;
+  CHECK_EQ(GetGrownArrayCapacity<uint8_t[64]>(kMaxCapacity / 2, 1), kMaxCapacity);
+  CHECK_EQ(GetGrownArrayCapacity<uint8_t[64]>(kMaxCapacity - 1, 1), kMaxCapacity);
+  CHECK_EQ(GetGrownArrayCapacity<uint8_t>(kMaxSize - 2, 2), kMaxSize);
+#ifndef _WIN32
+  // size + count beyond SizeType must not wrap below capacity and skip the growth.
+  CHECK_UNARY(AbortsInChildProcess([] {
+    UserContext user_context{};
+    ResizableArray<uint8_t, UserContext> resizable_array({.allocate = Allocate, .deallocate = Deallocate, .user_context = &user_context,}, 0, 16);
+    const uint8_t values[16]{};
+    resizable_array.append(values, 16);
+    resizable_array.append(values, kMaxSize - 8);
+  }));
+#endif
+#ifdef TOTE_ENABLE_64BIT_SIZE
+  static_assert(sizeof(SizeType) == sizeof(uint64_t));
+  CHECK_EQ(GetAllocationSize(UINT32_MAX, 64), static_cast<uint64_t>(UINT32_MAX) * 64);
+#else
+  static_assert(sizeof(SizeType) == sizeof(uint32_t));
+#endif
+}
+TEST_CASE("growth policy") {
+  using namespace tote;
+  CHECK_EQ(GeometricGrowth<>::GetNextCapacity<uint32_t>(0, 1, 1000), 2);
+  CHECK_EQ(GeometricGrowth<>::GetNextCapacity<uint32_t>(4, 5, 1000), 10);
+  using SlowGrowth = GeometricGrowth<3, 2>;
+  CHECK_EQ(SlowGrowth::GetNextCapacity<uint32_t>(0, 1, 1000), 1);
+  CHECK_EQ(SlowGrowth::GetNextCapacity<uint32_t>(1, 2, 1000), 3);
+  CHECK_EQ(SlowGrowth::GetNextCapacity<uint32_t>(99, 100, 1000), 150);
+  CHECK_EQ(SlowGrowth::GetNextCapacity<uint32_t>(800, 801, 1000), 1000);
+  CHECK_EQ(SlowGrowth::GetNextCapacity<uint32_t>(10, 40, 1000), 40);
+  using PageGrowth = PageGranularGrowth<4096, 4096 * 4>;
+  // a page at first, doubled up to the max step, then a max step at a time.
+  CHECK_EQ(PageGrowth::GetNextCapacity<uint32_t>(0, 1, 1 << 20), 1024);
+  CHECK_EQ(PageGrowth::GetNextCapacity<uint32_t>(1024, 1025, 1 << 20), 2048);
+  CHECK_EQ(PageGrowth::GetNextCapacity<uint32_t>(4096, 4097, 1 << 20), 8192);
+  CHECK_EQ(PageGrowth::GetNextCapacity<uint32_t>(8192, 8193, 1 << 20), 12288);
+  CHECK_EQ(PageGrowth::GetNextCapacity<uint32_t>(8192, 30000, 1 << 20), 30720);
+  CHECK_EQ(PageGrowth::GetNextCapacity<uint32_t>(1000, 1001, 1500), 1500);
+  CHECK_EQ(PageGrowth::GetNextCapacity<uint8_t[5000]>(3, 4, 1000), 6);
+  UserContext user_context{};
+  AllocatorCallbacks<UserContext> allocator_callbacks {
+    .allocate = Allocate,
+    .deallocate = Deallocate,
+    .user_context = &user_context,
+  };
+  {
+    ResizableArray<uint32_t, UserContext, SlowGrowth> resizable_array(allocator_callbacks);
+    uint32_t grow_count = 0;
+    for (uint32_t i = 0; i < 1000; i++) {
+      const auto capacity = resizable_array.capacity();
+      resizable_array.push_back(i);
+      if (resizable_array.capacity() != capacity) {
+        CHECK_LE(resizable_array.capacity(), capacity * 3 / 2 + 2);
+        grow_count++;
+      }
+    }
+    CHECK_GT(grow_count, 10);
+    CHECK_EQ(resizable_array[999], 999);
+    ResizableArray<uint32_t, UserContext, PageGranularGrowth<>> paged_array(allocator_callbacks);
+    paged_array.append(resizable_array.begin(), resizable_array.size());
+    paged_array.push_back(1000);
+    CHECK_EQ(paged_array.capacity(), 1024);
+    CHECK_EQ(paged_array[1000], 1000);
+  }
+  CHECK_EQ(user_context.alloc_count, user_context.dealloc_count);
+  CHECK_UNARY(user_context.ptr.empty());
+}
+TEST_CASE("reserve and shrink to fit") {
+  using namespace tote;
+  UserContext user_context{};
+  AllocatorCallbacks<UserContext> allocator_callbacks {
+    .allocate = Allocate,
+    .deallocate = Deallocate,
+    .user_context = &user_context,
+  };
+  {
+    ResizableArray<std::string, UserContext> resizable_array(allocator_callbacks);
+    resizable_array.reserve(100);
+    CHECK_EQ(resizable_array.capacity(), 100);
+    CHECK_UNARY(resizable_array.empty());
+    resizable_array.reserve(10);
+    CHECK_EQ(resizable_array.capacity(), 100);
+    for (uint32_t i = 0; i < 100; i++) {
+      resizable_array.push_back(std::to_string(i) + " is long enough to be allocated");
+    }
+    CHECK_EQ(resizable_array.capacity(), 100);
+    CHECK_EQ(user_context.alloc_count, 1);
+    resizable_array.push_back("spike");
+    CHECK_GT(resizable_array.capacity(), 101);
+    resizable_array.resize(3);
+    resizable_array.shrink_to_fit();
+    CHECK_EQ(resizable_array.capacity(), 3);
+    CHECK_EQ(resizable_array.size(), 3);
+    CHECK_EQ(resizable_array[2], "2 is long enough to be allocated");
+    resizable_array.shrink_to_fit();
+    CHECK_EQ(resizable_array.capacity(), 3);
+    resizable_array.clear();
+    resizable_array.shrink_to_fit();
+    CHECK_EQ(resizable_array.capacity(), 0);
+    CHECK_EQ(resizable_array.begin(), nullptr);
+    resizable_array.push_back("again");
+    CHECK_EQ(resizable_array[0], "again");
+    // trivially relocatable elements take the byte copy path.
+    ResizableArray<int, UserContext> int_array(allocator_callbacks, 0, 10);
+    int_array.resize(2, 7);
+    int_array.shrink_to_fit();
+    CHECK_EQ(int_array.capacity(), 2);
+    CHECK_EQ(int_array[1], 7);
+    int_array.clear();
+    int_array.shrink_to_fit();
+    CHECK_EQ(int_array.capacity(), 0);
+    CHECK_EQ(int_array.begin(), nullptr);
+    int_array.push_back(3);
+    CHECK_EQ(int_array[0], 3);
+    // growing resize is amortized like push_back.
+    const auto alloc_count = user_context.alloc_count;
+    for (uint32_t i = 0; i < 1000; i++) {
+      int_array.resize(int_array.size() + 1, static_cast<int>(i));
+    }
+    CHECK_LT(user_context.alloc_count - alloc_count, 12);
+    CHECK_EQ(int_array[1000], 999);
+    CHECK_GT(int_array.capacity(), int_array.size());
+  }
+  CHECK_EQ(user_context.alloc_count, user_context.dealloc_count);
+  CHECK_UNARY(user_context.ptr.empty());
+  {
+    // shrinks in place with a reallocate callback.
+    BumpArena arena{};
+    AllocatorCallbacks<BumpArena> bump_callbacks {
+      .allocate = BumpAllocate,
+      .deallocate = BumpDeallocate,
+      .user_context = &arena,
+      .reallocate = BumpReallocate,
+    };
+    ResizableArray<uint32_t, BumpArena> resizable_array(bump_callbacks, 100);
+    const auto head = resizable_array.begin();
+    resizable_array.resize(10);
+    resizable_array.shrink_to_fit();
+    CHECK_EQ(resizable_array.begin(), head);
+    CHECK_EQ(resizable_array.capacity(), 10);
+    CHECK_EQ(arena.alloc_count, 1);
+    CHECK_EQ(arena.used, sizeof(uint32_t) * 10);
+  }
+}
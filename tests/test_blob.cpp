@@ -0,0 +1,118 @@
+#include "tote/blob.h"
+#include "test_alloc.inl"
+#include <doctest/doctest.h>
+TEST_CASE("array blob") {
+  using namespace tote;
+  UserContext user_context{};
+  AllocatorCallbacks<UserContext> allocator_callbacks {
+    .allocate = Allocate,
+    .deallocate = Deallocate,
+    .user_context = &user_context,
+  };
+  uint64_t blob_size = 0;
+  void* blob = nullptr;
+  {
+    ResizableArray<uint64_t, UserContext> resizable_array(allocator_callbacks);
+    for (uint64_t i = 0; i < 100; i++) {
+      resizable_array.push_back(i * i);
+    }
+    blob_size = GetBlobSize(resizable_array);
+    CHECK_EQ(blob_size % kCacheLineSize, 0);
+    blob = Allocate(static_cast<uint32_t>(blob_size), kCacheLineSize, &user_context);
+    CHECK_EQ(SerializeToBlob(resizable_array, blob, blob_size - 1), 0);
+    CHECK_EQ(SerializeToBlob(resizable_array, blob, blob_size), blob_size);
+  }
+  // read in place without the source array.
+  ArrayView<uint64_t> view(blob, blob_size);
+  CHECK_UNARY(view.is_valid());
+  CHECK_EQ(view.size(), 100);
+  CHECK_EQ(view[99], 99 * 99);
+  uint64_t sum = 0;
+  for (const auto val : view) {
+    sum += val;
+  }
+  CHECK_EQ(sum, 328350);
+  CHECK_EQ(reinterpret_cast<uintptr_t>(view.begin()) % kCacheLineSize, 0);
+  // rejected on type or size mismatch.
+  CHECK_UNARY_FALSE((ArrayView<uint32_t>(blob, blob_size).is_valid()));
+  CHECK_UNARY_FALSE((ArrayView<uint64_t>(blob, blob_size - 1).is_valid()));
+  CHECK_UNARY_FALSE((HashMapView<uint64_t, uint64_t>(blob, blob_size).is_valid()));
+  CHECK_UNARY(ArrayView<uint64_t>(nullptr, 0).empty());
+  static_cast<BlobHeader*>(blob)->version = kBlobVersion + 1;
+  CHECK_UNARY_FALSE((ArrayView<uint64_t>(blob, blob_size).is_valid()));
+  Deallocate(blob, &user_context);
+  CHECK_EQ(user_context.alloc_count, user_context.dealloc_count);
+}
+namespace {
+struct Record {
+  uint32_t id;
+  float weight;
+};
+struct NamedRecord {
+  const char* name;
+  uint32_t id;
+};
+} // namespace
+template <>
+struct tote::IsBlobSerializable<NamedRecord> : std::false_type {};
+TEST_CASE("blob serializable types") {
+  using namespace tote;
+  static_assert(kIsBlobSerializable<uint64_t>);
+  static_assert(kIsBlobSerializable<Record>);
+  static_assert(kIsBlobSerializable<const Record>);
+  static_assert(!kIsBlobSerializable<std::string_view>);
+  static_assert(!kIsBlobSerializable<const char*>);
+  static_assert(!kIsBlobSerializable<uint32_t Record::*>);
+  static_assert(!kIsBlobSerializable<NamedRecord>);
+  static_assert(!kIsBlobSerializable<ResizableArray<uint32_t, UserContext>>);
+  CHECK_UNARY(std::is_trivially_copyable_v<NamedRecord>);
+}
+TEST_CASE("hash map blob") {
+  using namespace tote;
+  UserContext user_context{};
+  AllocatorCallbacks<UserContext> allocator_callbacks {
+    .allocate = Allocate,
+    .deallocate = Deallocate,
+    .user_context = &user_context,
+  };
+  uint64_t blob_size = 0;
+  void* blob = nullptr;
+  uint32_t capacity = 0;
+  {
+    HashMap<uint32_t, Record, UserContext> hash_map(allocator_callbacks);
+    // entries left in the previous table while rehashing are included.
+    hash_map.set_rehash_budget(1);
+    for (uint32_t i = 0; i < 1000; i++) {
+      hash_map[i * 3] = {i, static_cast<float>(i) * 0.5f};
+    }
+    hash_map.reserve(4000);
+    CHECK_UNARY(hash_map.is_rehashing());
+    blob_size = GetBlobSize(hash_map);
+    blob = Allocate(static_cast<uint32_t>(blob_size), kCacheLineSize, &user_context);
+    CHECK_EQ(SerializeToBlob(hash_map, blob, blob_size), blob_size);
+    capacity = hash_map.capacity();
+  }
+  // read in place without the source map.
+  HashMapView<uint32_t, Record> view(blob, blob_size);
+  CHECK_UNARY(view.is_valid());
+  CHECK_EQ(view.size(), 1000);
+  CHECK_EQ(view.capacity(), capacity);
+  uint32_t mismatch = 0;
+  for (uint32_t i = 0; i < 3000; i++) {
+    const auto record = view.find(i);
+    if ((record != nullptr) != (i % 3 == 0)) { mismatch++; }
+    if (record != nullptr && (record->id != i / 3 || record->weight != static_cast<float>(i / 3) * 0.5f)) { mismatch++; }
+  }
+  CHECK_EQ(mismatch, 0);
+  CHECK_UNARY(view.contains(2997));
+  CHECK_EQ(view[1].id, 0);
+  uint32_t count = 0;
+  view.for_each([&](const uint32_t& key, const Record& record) { count += key == record.id * 3; });
+  CHECK_EQ(count, 1000);
+  CHECK_UNARY_FALSE((HashMapView<uint32_t, uint32_t>(blob, blob_size).is_valid()));
+  CHECK_UNARY_FALSE((ArrayView<uint32_t>(blob, blob_size).is_valid()));
+  CHECK_UNARY_FALSE((HashMapView<uint32_t, Record>(blob, sizeof(BlobHeader)).is_valid()));
+  CHECK_EQ((HashMapView<uint32_t, Record>(blob, sizeof(BlobHeader)).find(3)), nullptr);
+  Deallocate(blob, &user_context);
+  CHECK_EQ(user_context.alloc_count, user_context.dealloc_count);
+}
@@ -0,0 +1,152 @@
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "tote/concurrent_hash_map.h"
+#include "test_alloc.inl"
+#include <doctest/doctest.h>
+namespace {
+struct Payload {
+  uint64_t a;
+  uint64_t b;
+  uint32_t c;
+};
+} // namespace
+TEST_CASE("concurrent hash map") {
+  using namespace tote;
+  UserContext user_context{};
+  AllocatorCallbacks<UserContext> allocator_callbacks {
+    .allocate = Allocate,
+    .deallocate = Deallocate,
+    .user_context = &user_context,
+  };
+  {
+    ConcurrentHashMap<uint32_t, Payload, UserContext> hash_map(allocator_callbacks);
+    CHECK_EQ(hash_map.size(), 0);
+    CHECK_EQ(hash_map.capacity(), 8);
+    CHECK_UNARY_FALSE(hash_map.contains(0));
+    Payload payload{};
+    for (uint32_t i = 0; i < 100; i++) {
+      hash_map.insert(i, {i, i * 2, i * 3});
+    }
+    CHECK_EQ(hash_map.size(), 100);
+    CHECK_UNARY(hash_map.has_retired_tables());
+    CHECK_UNARY(hash_map.find(42, &payload));
+    CHECK_EQ(payload.a, 42);
+    CHECK_EQ(payload.b, 84);
+    CHECK_EQ(payload.c, 126);
+    hash_map.insert(42, {1, 2, 3});
+    CHECK_EQ(hash_map.size(), 100);
+    CHECK_UNARY(hash_map.find(42, &payload));
+    CHECK_EQ(payload.a, 1);
+    CHECK_EQ(payload.c, 3);
+    for (uint32_t i = 0; i < 100; i += 2) {
+      hash_map.erase(i);
+    }
+    hash_map.erase(1000);
+    CHECK_EQ(hash_map.size(), 50);
+    uint32_t mismatch = 0;
+    for (uint32_t i = 0; i < 100; i++) {
+      const auto found = hash_map.find(i, &payload);
+      if (found != (i % 2 == 1) || (found && payload.a != i)) { mismatch++; }
+    }
+    CHECK_EQ(mismatch, 0);
+    const auto alloc_count = user_context.alloc_count;
+    hash_map.collect_retired_tables();
+    CHECK_UNARY_FALSE(hash_map.has_retired_tables());
+    CHECK_EQ(user_context.dealloc_count, alloc_count - 1);
+    hash_map.reserve(1000);
+    CHECK_GE(hash_map.capacity(), 1024);
+    CHECK_UNARY(hash_map.contains(99));
+    hash_map.clear();
+    CHECK_EQ(hash_map.size(), 0);
+    CHECK_UNARY_FALSE(hash_map.contains(99));
+  }
+  CHECK_EQ(user_context.alloc_count, user_context.dealloc_count);
+}
+TEST_CASE("concurrent hash map readers and writer") {
+  using namespace tote;
+  UserContext user_context{};
+  AllocatorCallbacks<UserContext> allocator_callbacks {
+    .allocate = Allocate,
+    .deallocate = Deallocate,
+    .user_context = &user_context,
+  };
+  {
+    // every word of a value is derived from the key and a write generation,
+    // so a read torn across words of two writes shows up as a mismatch.
+    ConcurrentHashMap<uint32_t, Payload, UserContext> hash_map(allocator_callbacks);
+    constexpr uint32_t kKeyNum = 20000;
+    constexpr uint32_t kReaderNum = 4;
+    constexpr uint32_t kHotKeyNum = 16;
+    auto make_payload = [](const uint32_t key, const uint32_t generation) {
+      const auto a = (static_cast<uint64_t>(generation) << 32) | key;
+      return Payload{a, ~a, generation};
+    };
+    auto is_consistent = [](const uint32_t key, const Payload& payload) {
+      return static_cast<uint32_t>(payload.a) == key && payload.b == ~payload.a && payload.c == static_cast<uint32_t>(payload.a >> 32);
+    };
+    std::atomic<bool> done{false};
+    std::atomic<uint32_t> mismatch{0};
+    std::atomic<uint32_t> hit{0};
+    std::vector<std::thread> readers;
+    for (uint32_t t = 0; t < kReaderNum; t++) {
+      readers.emplace_back([&, t] {
+        uint32_t key = t;
+        uint32_t local_hit = 0;
+        uint32_t read_num = 0;
+        while (!done.load(std::memory_order_acquire)) {
+          key = (key * 1103515245 + 12345) % kKeyNum;
+          // half of the reads hit the keys the writer overwrites most.
+          const auto read_key = read_num++ % 2 == 0 ? key % kHotKeyNum : key;
+          Payload payload{};
+          if (hash_map.find(read_key, &payload)) {
+            local_hit++;
+            if (!is_consistent(read_key, payload)) { mismatch.fetch_add(1, std::memory_order_relaxed); }
+          }
+          if (hash_map.size() > kKeyNum) { mismatch.fetch_add(1, std::memory_order_relaxed); }
+        }
+        hit.fetch_add(local_hit, std::memory_order_relaxed);
+      });
+    }
+    // grows from the minimum capacity while readers are running, then churns.
+    uint32_t generation = 0;
+    for (uint32_t i = 0; i < kKeyNum; i++) {
+      hash_map.insert(i, make_payload(i, generation));
+    }
+    for (uint32_t round = 0; round < 10; round++) {
+      generation++;
+      for (uint32_t i = round % 2; i < kKeyNum; i += 2) {
+        hash_map.erase(i);
+      }
+      for (uint32_t i = round % 2; i < kKeyNum; i += 2) {
+        hash_map.insert(i, make_payload(i, generation));
+      }
+      for (uint32_t i = 1 - round % 2; i < kKeyNum; i += 2) {
+        hash_map.insert(i, make_payload(i, generation));
+      }
+    }
+    // overwrites a few keys many times, racing with the reads of the same slots.
+    const auto churn_generation = generation;
+    for (uint32_t round = 0; round < 20000; round++) {
+      generation++;
+      for (uint32_t i = 0; i < kHotKeyNum; i++) {
+        hash_map.insert(i, make_payload(i, generation));
+      }
+    }
+    done.store(true, std::memory_order_release);
+    for (auto& reader : readers) {
+      reader.join();
+    }
+    CHECK_EQ(mismatch.load(), 0);
+    CHECK_GT(hit.load(), 0);
+    CHECK_EQ(hash_map.size(), kKeyNum);
+    hash_map.collect_retired_tables();
+    uint32_t missing = 0;
+    for (uint32_t i = 0; i < kKeyNum; i++) {
+      Payload payload{};
+      if (!hash_map.find(i, &payload) || !is_consistent(i, payload) || payload.c != (i < kHotKeyNum ? generation : churn_generation)) { missing++; }
+    }
+    CHECK_EQ(missing, 0);
+  }
+  CHECK_EQ(user_context.alloc_count, user_context.dealloc_count);
+}
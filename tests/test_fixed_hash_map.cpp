@@ -0,0 +1,88 @@
+#include <random>
+#include <unordered_map>
+#include "tote/fixed_hash_map.h"
+#include <doctest/doctest.h>
+namespace {
+struct CollidingHash {
+  uint32_t operator()(const uint32_t key) const { return key % 4; }
+};
+} // namespace
+TEST_CASE("fixed hash map") {
+  using namespace tote;
+  FixedHashMap<uint32_t, uint32_t, 8> hash_map;
+  CHECK_UNARY(hash_map.empty());
+  CHECK_EQ(hash_map.capacity(), 8);
+  CHECK_UNARY_FALSE(hash_map.contains(0));
+  hash_map.insert(1, 10);
+  CHECK_EQ(hash_map[1], 10);
+  auto result = hash_map.try_emplace(1, 20);
+  CHECK_UNARY_FALSE(result.inserted);
+  CHECK_EQ(*result.value, 10);
+  result = hash_map.insert_or_assign(1, 30);
+  CHECK_UNARY_FALSE(result.inserted);
+  CHECK_EQ(hash_map[1], 30);
+  hash_map.erase(1);
+  CHECK_UNARY_FALSE(hash_map.contains(1));
+  CHECK_UNARY(hash_map.empty());
+  for (uint32_t i = 0; i < 8; i++) {
+    hash_map[i] = i * 2;
+  }
+  CHECK_UNARY(hash_map.full());
+  // insertion fails when full while existing keys are still assignable.
+  result = hash_map.try_emplace(100, 1);
+  CHECK_UNARY_FALSE(result.inserted);
+  CHECK_EQ(result.value, nullptr);
+  CHECK_UNARY_FALSE(hash_map.contains(100));
+  result = hash_map.insert_or_assign(3, 33);
+  CHECK_EQ(*result.value, 33);
+  const auto& const_hash_map = hash_map;
+  CHECK_EQ(const_hash_map[100], 0);
+  uint32_t count = 0;
+  for (const auto [key, value] : const_hash_map) {
+    CHECK_EQ(value, key == 3 ? 33 : key * 2);
+    count++;
+  }
+  CHECK_EQ(count, 8);
+  for (auto [key, value] : hash_map) {
+    value = key;
+  }
+  hash_map.for_each([&](const uint32_t& key, uint32_t& value) { count += key == value; });
+  CHECK_EQ(count, 16);
+  // copied as a value without allocation.
+  auto copied = hash_map;
+  hash_map.clear();
+  CHECK_UNARY(hash_map.empty());
+  CHECK_EQ(copied.size(), 8);
+  CHECK_EQ(copied[7], 7);
+  const uint32_t keys[] = {1, 2, 3};
+  const uint32_t values[] = {4, 5, 6};
+  hash_map.insert_bulk(keys, values, 3);
+  CHECK_EQ(hash_map.size(), 3);
+  CHECK_EQ(hash_map[2], 5);
+}
+TEST_CASE("fixed hash map erase with collisions") {
+  using namespace tote;
+  FixedHashMap<uint32_t, uint32_t, 64, CollidingHash> hash_map;
+  std::unordered_map<uint32_t, uint32_t> reference;
+  std::mt19937 engine(7);
+  std::uniform_int_distribution<uint32_t> distribution(0, 127);
+  uint32_t mismatch = 0;
+  for (uint32_t i = 0; i < 5000; i++) {
+    const auto key = distribution(engine);
+    if (i % 3 == 0) {
+      hash_map.erase(key);
+      reference.erase(key);
+    } else if (reference.size() < 64 || reference.contains(key)) {
+      hash_map[key] = i;
+      reference[key] = i;
+    }
+    if (hash_map.size() != reference.size()) { mismatch++; }
+  }
+  for (uint32_t key = 0; key < 128; key++) {
+    const auto value = hash_map.find(key);
+    const auto it = reference.find(key);
+    if ((value != nullptr) != (it != reference.end())) { mismatch++; }
+    if (value != nullptr && it != reference.end() && *value != it->second) { mismatch++; }
+  }
+  CHECK_EQ(mismatch, 0);
+}
@@ -1,4 +1,6 @@
 #include <stdlib.h>
+#include <string_view>
+#include <vector>
 #include "tote/hash_map.h"
 #include "test_alloc.inl"
 #include <doctest/doctest.h>
@@ -36,6 +38,20 @@ TEST_CASE("prime number") {
   CHECK_EQ(GetLargerOrEqualPrimeNumber(1011), 1013);
   CHECK_EQ(GetLargerOrEqualPrimeNumber(1013), 1013);
   CHECK_EQ(GetLargerOrEqualPrimeNumber(1013), 1013);
+  CHECK_UNARY(IsPrimeNumber(4294967291U));
+  CHECK_EQ(GetLargerOrEqualPrimeNumber(4294967292U), 4294967291U);
+  CHECK_EQ(GetLargerOrEqualPrimeNumber(UINT32_MAX), 4294967291U);
+}
+TEST_CASE("capacity saturation") {
+  using namespace tote;
+  CHECK_EQ(GetGrownCapacity(UINT32_MAX / 2 + 1, 2, 1), UINT32_MAX);
+  CHECK_EQ(GetGrownCapacity(UINT32_MAX, 2, 1), UINT32_MAX);
+  CHECK_EQ(GetLargerOrEqualPowerOfTwo(0x80000000U), 0x80000000U);
+  CHECK_EQ(GetLargerOrEqualPowerOfTwo(0x80000001U), 0x80000000U);
+  CHECK_EQ(GetMinCapacityNotCloseToFull(UINT32_MAX), UINT32_MAX);
+  CHECK_EQ(PrimeNumberCapacity<>::GetNextCapacity(4294967291U), 4294967291U);
+  CHECK_EQ(PowerOfTwoCapacity::GetNextCapacity(1U << 30), 1U << 31);
+  CHECK_EQ(PowerOfTwoCapacity::GetNextCapacity(1U << 31), 1U << 31);
 }
 TEST_CASE("power of 2 align") {
   using namespace tote;
@@ -321,7 +337,7 @@ TEST_CASE("move") {
   CHECK_GE(user_context.alloc_count, alloc_count);
   CHECK_EQ(user_context.alloc_count, user_context.dealloc_count);
   CHECK_UNARY(user_context.ptr.empty());
-  CHECK_EQ(user_context2.alloc_count, 3);
+  CHECK_EQ(user_context2.alloc_count, 1);
   CHECK_EQ(user_context2.alloc_count, user_context2.dealloc_count);
   CHECK_UNARY(user_context2.ptr.empty());
 }
@@ -398,3 +414,676 @@ TEST_CASE("const iterator") {
   CHECK_EQ(user_context.alloc_count, user_context.dealloc_count);
   CHECK_UNARY(user_context.ptr.empty());
 }
+TEST_CASE("grown capacity") {
+  using namespace tote;
+  CHECK_EQ(GetGrownCapacity(0, 2, 1), 1);
+  CHECK_EQ(GetGrownCapacity(2, 2, 1), 4);
+  CHECK_EQ(GetGrownCapacity(2, 3, 2), 3);
+  CHECK_EQ(GetGrownCapacity(3, 3, 2), 4);
+  CHECK_EQ(GetGrownCapacity(1000, 3, 2), 1500);
+  CHECK_EQ(GetGrownCapacity(UINT32_MAX - 1, 2, 1), UINT32_MAX);
+  CHECK_EQ(PrimeNumberCapacity<>::GetNextCapacity(2), 5);
+  CHECK_EQ(PrimeNumberCapacity<>::GetNextCapacity(11), 23);
+  CHECK_EQ((PrimeNumberCapacity<3, 2>::GetNextCapacity(11)), 17);
+}
+TEST_CASE("bulk load resize count") {
+  using namespace tote;
+  UserContext user_context{};
+  AllocatorCallbacks<UserContext> allocator_callbacks {
+    .allocate = Allocate,
+    .deallocate = Deallocate,
+    .user_context = &user_context,
+  };
+  const uint32_t entry_num = 100000;
+  {
+    HashMap<uint32_t, uint32_t, UserContext> hash_map(allocator_callbacks);
+    const auto alloc_count = user_context.alloc_count;
+    for (uint32_t i = 0; i < entry_num; i++) {
+      hash_map.insert(i, i);
+    }
+    CHECK_EQ(hash_map.size(), entry_num);
+    CHECK_UNARY(IsPrimeNumber(hash_map.capacity()));
+    CHECK_LT(hash_map.size(), hash_map.capacity());
+    // capacity roughly doubles from 2 on each resize.
+    const auto resize_count = user_context.alloc_count - alloc_count;
+    CHECK_GE(resize_count, 16);
+    CHECK_LE(resize_count, 17);
+    CHECK_EQ(hash_map[0], 0);
+    CHECK_EQ(hash_map[entry_num - 1], entry_num - 1);
+  }
+  {
+    HashMap<uint32_t, uint32_t, UserContext, PrimeNumberCapacity<3, 2>> hash_map(allocator_callbacks);
+    const auto alloc_count = user_context.alloc_count;
+    for (uint32_t i = 0; i < entry_num; i++) {
+      hash_map.insert(i, i);
+    }
+    CHECK_EQ(hash_map.size(), entry_num);
+    CHECK_UNARY(IsPrimeNumber(hash_map.capacity()));
+    CHECK_LT(hash_map.size(), hash_map.capacity());
+    const auto resize_count = user_context.alloc_count - alloc_count;
+    CHECK_GT(resize_count, 17);
+    CHECK_LE(resize_count, 30);
+    CHECK_EQ(hash_map[0], 0);
+    CHECK_EQ(hash_map[entry_num - 1], entry_num - 1);
+  }
+  CHECK_EQ(user_context.alloc_count, user_context.dealloc_count);
+  CHECK_UNARY(user_context.ptr.empty());
+}
+TEST_CASE("power of two") {
+  using namespace tote;
+  CHECK_EQ(GetLargerOrEqualPowerOfTwo(0), 1);
+  CHECK_EQ(GetLargerOrEqualPowerOfTwo(1), 1);
+  CHECK_EQ(GetLargerOrEqualPowerOfTwo(2), 2);
+  CHECK_EQ(GetLargerOrEqualPowerOfTwo(3), 4);
+  CHECK_EQ(GetLargerOrEqualPowerOfTwo(4), 4);
+  CHECK_EQ(GetLargerOrEqualPowerOfTwo(5), 8);
+  CHECK_EQ(GetLargerOrEqualPowerOfTwo(1000), 1024);
+  CHECK_EQ(GetLargerOrEqualPowerOfTwo(1024), 1024);
+  CHECK_EQ(GetLargerOrEqualPowerOfTwo(0x80000000U), 0x80000000U);
+  CHECK_EQ(PowerOfTwoCapacity::GetInitialCapacity(0), 2);
+  CHECK_EQ(PowerOfTwoCapacity::GetInitialCapacity(5), 8);
+  CHECK_EQ(PowerOfTwoCapacity::GetNextCapacity(8), 16);
+  CHECK_LT(PowerOfTwoCapacity::GetIndex(0xFFFFFFFFU, 16), 16);
+  CHECK_LT(PowerOfTwoCapacity::GetIndex(0xFFFFFFFFFFFFFFFFULL, 16), 16);
+}
+TEST_CASE("power of two capacity hash map") {
+  using namespace tote;
+  UserContext user_context{};
+  AllocatorCallbacks<UserContext> allocator_callbacks {
+    .allocate = Allocate,
+    .deallocate = Deallocate,
+    .user_context = &user_context,
+  };
+  {
+    HashMap<uint32_t, uint32_t, UserContext, PowerOfTwoCapacity> hash_map(allocator_callbacks, 5);
+    CHECK_EQ(hash_map.capacity(), 8);
+    hash_map.insert(0, 1);
+    hash_map.insert(8, 2);
+    hash_map.insert(16, 3);
+    CHECK_EQ(hash_map.size(), 3);
+    CHECK_EQ(hash_map.capacity(), 8);
+    CHECK_EQ(hash_map[0], 1);
+    CHECK_EQ(hash_map[8], 2);
+    CHECK_EQ(hash_map[16], 3);
+    hash_map.erase(8);
+    CHECK_EQ(hash_map.size(), 2);
+    CHECK_UNARY(hash_map.contains(0));
+    CHECK_UNARY_FALSE(hash_map.contains(8));
+    CHECK_UNARY(hash_map.contains(16));
+    hash_map.erase(16);
+    // strided keys with low bits always zero.
+    for (uint32_t i = 0; i < 1000; i++) {
+      hash_map.insert(i << 8, i);
+    }
+    CHECK_EQ(hash_map.size(), 1000);
+    CHECK_EQ(hash_map.capacity(), 2048);
+    for (uint32_t i = 0; i < 1000; i += 2) {
+      hash_map.erase(i << 8);
+    }
+    CHECK_EQ(hash_map.size(), 500);
+    uint32_t found = 0;
+    for (uint32_t i = 0; i < 1000; i++) {
+      if (hash_map.contains(i << 8)) {
+        CHECK_EQ(i % 2, 1);
+        CHECK_EQ(hash_map[i << 8], i);
+        found++;
+      }
+    }
+    CHECK_EQ(found, 500);
+  }
+  CHECK_EQ(user_context.alloc_count, user_context.dealloc_count);
+  CHECK_UNARY(user_context.ptr.empty());
+}
+namespace {
+struct Guid {
+  uint64_t hi;
+  uint64_t lo;
+  bool operator==(const Guid&) const = default;
+};
+struct GuidHash {
+  uint64_t operator()(const Guid& guid) const { return tote::MixHash(guid.hi ^ tote::MixHash(guid.lo)); }
+};
+template <typename K, typename P>
+uint32_t CountUsedSlots(const K* keys, const uint32_t key_num, const uint32_t capacity) {
+  bool used[1024]{};
+  uint32_t count = 0;
+  for (uint32_t i = 0; i < key_num; i++) {
+    const auto index = P::GetIndex(tote::Hash<K>{}(keys[i]), capacity);
+    if (!used[index]) {
+      used[index] = true;
+      count++;
+    }
+  }
+  return count;
+}
+} // namespace
+TEST_CASE("adversarial key distribution") {
+  using namespace tote;
+  const uint32_t key_num = 512;
+  const uint32_t capacity = 1024;
+  uint32_t keys32[key_num]{};
+  uint64_t keys64[key_num]{};
+  // handles with low bits always zero.
+  for (uint32_t i = 0; i < key_num; i++) {
+    keys32[i] = i << 16;
+    keys64[i] = static_cast<uint64_t>(i) << 40;
+  }
+  // would all map to slot 0 without mixing.
+  CHECK_GT((CountUsedSlots<uint32_t, PowerOfTwoCapacity>(keys32, key_num, capacity)), key_num / 2);
+  CHECK_GT((CountUsedSlots<uint64_t, PowerOfTwoCapacity>(keys64, key_num, capacity)), key_num / 2);
+  // multiples of a prime capacity.
+  for (uint32_t i = 0; i < key_num; i++) {
+    keys32[i] = i * 1021;
+    keys64[i] = static_cast<uint64_t>(i) * 1021 << 32;
+  }
+  CHECK_GT((CountUsedSlots<uint32_t, PrimeNumberCapacity<>>(keys32, key_num, 1021)), key_num / 2);
+  CHECK_GT((CountUsedSlots<uint64_t, PrimeNumberCapacity<>>(keys64, key_num, 1021)), key_num / 2);
+  UserContext user_context{};
+  AllocatorCallbacks<UserContext> allocator_callbacks {
+    .allocate = Allocate,
+    .deallocate = Deallocate,
+    .user_context = &user_context,
+  };
+  HashMap<uint64_t, uint32_t, UserContext, PowerOfTwoCapacity> hash_map(allocator_callbacks);
+  for (uint32_t i = 0; i < key_num; i++) {
+    hash_map.insert(keys64[i], i);
+  }
+  CHECK_EQ(hash_map.size(), key_num);
+  for (uint32_t i = 0; i < key_num; i += 3) {
+    hash_map.erase(keys64[i]);
+  }
+  for (uint32_t i = 0; i < key_num; i++) {
+    CHECK_EQ(hash_map.contains(keys64[i]), i % 3 != 0);
+  }
+  CHECK_EQ(hash_map[keys64[1]], 1);
+  CHECK_EQ(hash_map[keys64[key_num - 1]], key_num - 1);
+}
+TEST_CASE("string view key") {
+  using namespace tote;
+  UserContext user_context{};
+  AllocatorCallbacks<UserContext> allocator_callbacks {
+    .allocate = Allocate,
+    .deallocate = Deallocate,
+    .user_context = &user_context,
+  };
+  using namespace std::literals;
+  HashMap<std::string_view, uint32_t, UserContext, PowerOfTwoCapacity> hash_map(allocator_callbacks);
+  hash_map.insert("position"sv, 0);
+  hash_map.insert("rotation"sv, 1);
+  hash_map.insert("scale"sv, 2);
+  CHECK_EQ(hash_map.size(), 3);
+  CHECK_UNARY(hash_map.contains("position"sv));
+  CHECK_UNARY(hash_map.contains("rotation"sv));
+  CHECK_UNARY(hash_map.contains("scale"sv));
+  CHECK_UNARY_FALSE(hash_map.contains("pos"sv));
+  CHECK_UNARY_FALSE(hash_map.contains("scale2"sv));
+  CHECK_EQ(hash_map["rotation"sv], 1);
+  hash_map.erase("position"sv);
+  CHECK_UNARY_FALSE(hash_map.contains("position"sv));
+  CHECK_EQ(hash_map["scale"sv], 2);
+  CHECK_NE(Hash<std::string_view>{}("ab"sv), Hash<std::string_view>{}("ba"sv));
+}
+TEST_CASE("guid key") {
+  using namespace tote;
+  UserContext user_context{};
+  AllocatorCallbacks<UserContext> allocator_callbacks {
+    .allocate = Allocate,
+    .deallocate = Deallocate,
+    .user_context = &user_context,
+  };
+  HashMap<Guid, uint32_t, UserContext, PrimeNumberCapacity<>, GuidHash> hash_map(allocator_callbacks);
+  for (uint32_t i = 0; i < 100; i++) {
+    hash_map.insert({.hi = i, .lo = 0}, i);
+    hash_map.insert({.hi = 0, .lo = i + 1}, i + 100);
+  }
+  CHECK_EQ(hash_map.size(), 200);
+  CHECK_EQ((hash_map[{.hi = 5, .lo = 0}]), 5);
+  CHECK_EQ((hash_map[{.hi = 0, .lo = 6}]), 105);
+  hash_map.erase({.hi = 5, .lo = 0});
+  CHECK_UNARY_FALSE(hash_map.contains({.hi = 5, .lo = 0}));
+  CHECK_UNARY(hash_map.contains({.hi = 0, .lo = 5}));
+  CHECK_EQ(hash_map.size(), 199);
+}
+TEST_CASE("single allocation") {
+  using namespace tote;
+  UserContext user_context{};
+  AllocatorCallbacks<UserContext> allocator_callbacks {
+    .allocate = Allocate,
+    .deallocate = Deallocate,
+    .user_context = &user_context,
+  };
+  HashMap<uint32_t, uint64_t, UserContext> hash_map(allocator_callbacks, 5);
+  CHECK_EQ(user_context.alloc_count, 1);
+  CHECK_EQ(reinterpret_cast<uintptr_t>(*user_context.ptr.begin()) % kCacheLineSize, 0);
+  for (uint32_t i = 0; i < 4; i++) {
+    hash_map.insert(i, i + 1);
+  }
+  CHECK_EQ(user_context.alloc_count, 2);
+  CHECK_EQ(user_context.dealloc_count, 1);
+  CHECK_EQ(user_context.ptr.size(), 1);
+  for (uint32_t i = 0; i < 4; i++) {
+    CHECK_EQ(hash_map[i], i + 1);
+  }
+}
+TEST_CASE("interleaved key value") {
+  using namespace tote;
+  UserContext user_context{};
+  AllocatorCallbacks<UserContext> allocator_callbacks {
+    .allocate = Allocate,
+    .deallocate = Deallocate,
+    .user_context = &user_context,
+  };
+  {
+    HashMap<uint32_t, uint8_t, UserContext, PowerOfTwoCapacity, Hash<uint32_t>, EqualTo<uint32_t>, true> hash_map(allocator_callbacks);
+    for (uint32_t i = 0; i < 200; i++) {
+      hash_map.insert(i, static_cast<uint8_t>(i));
+    }
+    CHECK_EQ(hash_map.size(), 200);
+    for (uint32_t i = 0; i < 200; i += 2) {
+      hash_map.erase(i);
+    }
+    CHECK_EQ(hash_map.size(), 100);
+    for (uint32_t i = 0; i < 200; i++) {
+      CHECK_EQ(hash_map.contains(i), i % 2 == 1);
+    }
+    CHECK_EQ(hash_map[199], 199);
+    hash_map[199] = 1;
+    CHECK_EQ(hash_map[199], 1);
+    uint32_t sum = 0;
+    hash_map.iterate<uint32_t>([](uint32_t* data, const uint32_t key, uint8_t*) {
+      *data += key;
+    }, &sum);
+    CHECK_EQ(sum, 10000);
+    auto hash_map_b = std::move(hash_map);
+    CHECK_EQ(hash_map_b.size(), 100);
+    CHECK_EQ(hash_map_b[197], 197);
+  }
+  CHECK_EQ(user_context.alloc_count, user_context.dealloc_count);
+  CHECK_UNARY(user_context.ptr.empty());
+}
+namespace {
+struct CountingHash {
+  static inline uint32_t count = 0;
+  uint32_t operator()(const uint32_t key) const {
+    count++;
+    return tote::Hash<uint32_t>{}(key);
+  }
+};
+} // namespace
+TEST_CASE("single probe find and insert") {
+  using namespace tote;
+  UserContext user_context{};
+  AllocatorCallbacks<UserContext> allocator_callbacks {
+    .allocate = Allocate,
+    .deallocate = Deallocate,
+    .user_context = &user_context,
+  };
+  HashMap<uint32_t, uint32_t, UserContext, PrimeNumberCapacity<>, CountingHash> hash_map(allocator_callbacks, 100);
+  CHECK_EQ(hash_map.find(1), nullptr);
+  CountingHash::count = 0;
+  auto result = hash_map.try_emplace(1, 2U);
+  CHECK_UNARY(result.inserted);
+  CHECK_EQ(*result.value, 2);
+  CHECK_EQ(CountingHash::count, 1);
+  result = hash_map.try_emplace(1, 3U);
+  CHECK_UNARY_FALSE(result.inserted);
+  CHECK_EQ(*result.value, 2);
+  CHECK_EQ(CountingHash::count, 2);
+  result = hash_map.insert_or_assign(1, 4);
+  CHECK_UNARY_FALSE(result.inserted);
+  CHECK_EQ(*result.value, 4);
+  CHECK_EQ(CountingHash::count, 3);
+  result = hash_map.insert_or_assign(2, 5);
+  CHECK_UNARY(result.inserted);
+  CHECK_EQ(*result.value, 5);
+  CHECK_EQ(CountingHash::count, 4);
+  CHECK_EQ(*hash_map.find(1), 4);
+  CHECK_EQ(CountingHash::count, 5);
+  CHECK_EQ(hash_map.find(3), nullptr);
+  CHECK_EQ(CountingHash::count, 6);
+  hash_map[3] = 6;
+  CHECK_EQ(CountingHash::count, 7);
+  hash_map[3]++;
+  CHECK_EQ(CountingHash::count, 8);
+  CHECK_EQ(*hash_map.find(3), 7);
+  CHECK_EQ(hash_map.size(), 3);
+  *hash_map.find(3) = 8;
+  const auto& const_hash_map = hash_map;
+  CHECK_EQ(*const_hash_map.find(3), 8);
+  CHECK_EQ(const_hash_map[3], 8);
+  CHECK_EQ(const_hash_map[4], 0);
+  CHECK_EQ(const_hash_map.find(4), nullptr);
+  CHECK_EQ(hash_map.size(), 3);
+  hash_map.release_allocated_buffer();
+  CHECK_EQ(hash_map.find(1), nullptr);
+  CHECK_EQ(const_hash_map[1], 0);
+  hash_map.erase(1);
+  CHECK_UNARY(hash_map.try_emplace(1).inserted);
+  CHECK_EQ(hash_map[1], 0);
+}
+TEST_CASE("reserve and bulk insert") {
+  using namespace tote;
+  CHECK_EQ(GetMinCapacityNotCloseToFull(0), 0);
+  CHECK_EQ(GetMinCapacityNotCloseToFull(1), 2);
+  CHECK_EQ(GetMinCapacityNotCloseToFull(13), 21);
+  CHECK_UNARY_FALSE(IsCloseToFull(1000, GetMinCapacityNotCloseToFull(1000)));
+  CHECK_UNARY(IsCloseToFull(1000, GetMinCapacityNotCloseToFull(1000) - 1));
+  UserContext user_context{};
+  AllocatorCallbacks<UserContext> allocator_callbacks {
+    .allocate = Allocate,
+    .deallocate = Deallocate,
+    .user_context = &user_context,
+  };
+  const uint32_t entry_num = 1000;
+  HashMap<uint32_t, uint32_t, UserContext> hash_map(allocator_callbacks);
+  hash_map.reserve(entry_num);
+  CHECK_UNARY(IsPrimeNumber(hash_map.capacity()));
+  CHECK_GE(hash_map.capacity(), GetMinCapacityNotCloseToFull(entry_num));
+  auto alloc_count = user_context.alloc_count;
+  const auto capacity = hash_map.capacity();
+  for (uint32_t i = 0; i < entry_num; i++) {
+    hash_map.insert(i, i);
+  }
+  CHECK_EQ(user_context.alloc_count, alloc_count);
+  CHECK_EQ(hash_map.capacity(), capacity);
+  hash_map.reserve(10);
+  CHECK_EQ(hash_map.capacity(), capacity);
+  uint32_t keys[entry_num]{};
+  uint32_t values[entry_num]{};
+  for (uint32_t i = 0; i < entry_num; i++) {
+    keys[i] = i + entry_num / 2;
+    values[i] = i + 1;
+  }
+  alloc_count = user_context.alloc_count;
+  hash_map.insert_bulk(keys, values, entry_num);
+  CHECK_EQ(user_context.alloc_count, alloc_count + 1);
+  CHECK_EQ(hash_map.size(), entry_num * 3 / 2);
+  CHECK_EQ(hash_map[0], 0);
+  CHECK_EQ(hash_map[entry_num / 2 - 1], entry_num / 2 - 1);
+  CHECK_EQ(hash_map[entry_num / 2], 1);
+  CHECK_EQ(hash_map[entry_num * 3 / 2 - 1], entry_num);
+  CHECK_UNARY_FALSE(hash_map.contains(entry_num * 3 / 2));
+  HashMap<uint32_t, uint32_t, UserContext, PowerOfTwoCapacity> hash_map_b(allocator_callbacks);
+  alloc_count = user_context.alloc_count;
+  hash_map_b.insert_bulk(keys, values, entry_num);
+  CHECK_EQ(user_context.alloc_count, alloc_count + 1);
+  CHECK_EQ(hash_map_b.size(), entry_num);
+  CHECK_EQ(hash_map_b.capacity(), 2048);
+  CHECK_EQ(hash_map_b[entry_num / 2], 1);
+}
+TEST_CASE("for each and iterator") {
+  using namespace tote;
+  UserContext user_context{};
+  AllocatorCallbacks<UserContext> allocator_callbacks {
+    .allocate = Allocate,
+    .deallocate = Deallocate,
+    .user_context = &user_context,
+  };
+  {
+    HashMap<uint32_t, uint32_t, UserContext> hash_map(allocator_callbacks);
+    CHECK_UNARY(hash_map.begin() == hash_map.end());
+    hash_map.reserve(1000);
+    // sparse table, most flag words are empty.
+    const uint32_t keys[] = {0, 7, 8, 63, 64, 999, 1000, 12345};
+    uint32_t key_sum = 0;
+    for (const auto key : keys) {
+      hash_map[key] = key * 2;
+      key_sum += key;
+    }
+    uint32_t count = 0;
+    uint32_t sum = 0;
+    hash_map.for_each([&](const uint32_t& key, uint32_t& value) {
+      CHECK_EQ(value, key * 2);
+      count++;
+      sum += key;
+      value++;
+    });
+    CHECK_EQ(count, 8);
+    CHECK_EQ(sum, key_sum);
+    count = 0;
+    sum = 0;
+    for (auto [key, value] : hash_map) {
+      CHECK_EQ(value, key * 2 + 1);
+      count++;
+      sum += key;
+      value = key;
+    }
+    CHECK_EQ(count, 8);
+    CHECK_EQ(sum, key_sum);
+    const auto& const_hash_map = hash_map;
+    count = 0;
+    for (auto it = const_hash_map.begin(); it != const_hash_map.end(); it++) {
+      CHECK_EQ((*it).value, (*it).key);
+      count++;
+    }
+    CHECK_EQ(count, 8);
+    count = 0;
+    const_hash_map.for_each([&](const uint32_t& key, const uint32_t& value) {
+      CHECK_EQ(value, key);
+      count++;
+    });
+    CHECK_EQ(count, 8);
+    for (const auto key : keys) {
+      hash_map.erase(key);
+    }
+    CHECK_UNARY(hash_map.begin() == hash_map.end());
+    hash_map.release_allocated_buffer();
+    CHECK_UNARY(hash_map.begin() == hash_map.end());
+    hash_map.for_each([](const uint32_t&, uint32_t&) { CHECK_UNARY(false); });
+    HashMap<uint32_t, uint8_t, UserContext, PrimeNumberCapacity<>, Hash<uint32_t>, EqualTo<uint32_t>, true> interleaved_hash_map(allocator_callbacks);
+    for (uint32_t i = 0; i < 100; i++) {
+      interleaved_hash_map[i * 3] = static_cast<uint8_t>(i);
+    }
+    count = 0;
+    for (const auto [key, value] : interleaved_hash_map) {
+      CHECK_EQ(key, value * 3U);
+      count++;
+    }
+    CHECK_EQ(count, 100);
+  }
+  CHECK_EQ(user_context.alloc_count, user_context.dealloc_count);
+}
+namespace {
+struct HashCallCounter {
+  static inline uint32_t count = 0;
+  uint32_t operator()(const uint32_t key) const {
+    count++;
+    return tote::Hash<uint32_t>{}(key);
+  }
+};
+} // namespace
+TEST_CASE("incremental rehash") {
+  using namespace tote;
+  UserContext user_context{};
+  AllocatorCallbacks<UserContext> allocator_callbacks {
+    .allocate = Allocate,
+    .deallocate = Deallocate,
+    .user_context = &user_context,
+  };
+  {
+    const uint32_t entry_num = 20000;
+    // every entry is rehashed within the inserting call without a budget.
+    HashMap<uint32_t, uint32_t, UserContext, PrimeNumberCapacity<>, HashCallCounter> hash_map_sync(allocator_callbacks);
+    uint32_t max_hash_count = 0;
+    for (uint32_t i = 0; i < entry_num; i++) {
+      HashCallCounter::count = 0;
+      hash_map_sync[i] = i;
+      if (max_hash_count < HashCallCounter::count) { max_hash_count = HashCallCounter::count; }
+    }
+    CHECK_GT(max_hash_count, entry_num / 2);
+    HashMap<uint32_t, uint32_t, UserContext, PrimeNumberCapacity<>, HashCallCounter> hash_map(allocator_callbacks);
+    hash_map.set_rehash_budget(8);
+    max_hash_count = 0;
+    bool rehashed = false;
+    uint32_t mismatch = 0;
+    for (uint32_t i = 0; i < entry_num; i++) {
+      HashCallCounter::count = 0;
+      hash_map[i] = i;
+      if (max_hash_count < HashCallCounter::count) { max_hash_count = HashCallCounter::count; }
+      if (!hash_map.is_rehashing()) { continue; }
+      rehashed = true;
+      // lookups, updates, erase and iteration see entries in both tables.
+      if (i % 97 == 0) {
+        for (uint32_t j = 0; j <= i; j += 7) {
+          if (hash_map.find(j) == nullptr || *hash_map.find(j) != j) { mismatch++; }
+        }
+        uint32_t count = 0;
+        for (auto [key, value] : hash_map) {
+          if (key != value) { mismatch++; }
+          count++;
+        }
+        if (count != hash_map.size()) { mismatch++; }
+        hash_map.insert_or_assign(i / 2, i / 2);
+        hash_map.erase(i / 3 + 1);
+        hash_map[i / 3 + 1] = i / 3 + 1;
+      }
+    }
+    CHECK_UNARY(rehashed);
+    CHECK_EQ(mismatch, 0);
+    CHECK_LT(max_hash_count, 100);
+    CHECK_EQ(hash_map.size(), entry_num);
+    hash_map.step_rehash(~0U);
+    CHECK_UNARY_FALSE(hash_map.is_rehashing());
+    for (uint32_t i = 0; i < entry_num; i++) {
+      if (!hash_map.contains(i)) { mismatch++; }
+    }
+    CHECK_EQ(mismatch, 0);
+    // erase during rehash migrates the key first.
+    hash_map.reserve(entry_num * 2);
+    CHECK_UNARY(hash_map.is_rehashing());
+    for (uint32_t i = 0; i < entry_num; i += 2) {
+      hash_map.erase(i);
+    }
+    CHECK_EQ(hash_map.size(), entry_num / 2);
+    for (uint32_t i = 0; i < entry_num; i++) {
+      if (hash_map.contains(i) != (i % 2 == 1)) { mismatch++; }
+    }
+    CHECK_EQ(mismatch, 0);
+    auto moved = std::move(hash_map);
+    CHECK_EQ(moved.size(), entry_num / 2);
+    CHECK_UNARY(moved.contains(entry_num - 1));
+    moved.clear();
+    CHECK_UNARY_FALSE(moved.is_rehashing());
+    CHECK_UNARY_FALSE(moved.contains(entry_num - 1));
+  }
+  CHECK_EQ(user_context.alloc_count, user_context.dealloc_count);
+}
+namespace {
+struct SerialJobSystem {
+  uint32_t dispatch_count = 0;
+  uint32_t task_count = 0;
+};
+void DispatchSerially(tote::TaskCallbacks<SerialJobSystem>::TaskFunction* task, void* task_context, const uint32_t task_count, SerialJobSystem* job_system) {
+  job_system->dispatch_count++;
+  // run in reverse to catch dependencies on task order.
+  for (uint32_t i = task_count; i > 0; i--) {
+    task(task_context, i - 1);
+    job_system->task_count++;
+  }
+}
+// keys of 64 consecutive values share a home slot, which makes probes run past shard ranges.
+struct ClusteringHash {
+  uint32_t operator()(const uint32_t key) const { return key / 64; }
+};
+template <typename M, typename T>
+uint32_t CountParallelBuildMismatch(const uint32_t entry_num, const tote::TaskCallbacks<T>& task_callbacks) {
+  using namespace tote;
+  UserContext user_context{};
+  uint32_t mismatch = 0;
+  {
+    std::vector<uint32_t> keys(entry_num);
+    std::vector<uint32_t> values(entry_num);
+    for (uint32_t i = 0; i < entry_num; i++) {
+      // every eighth key is a duplicate of the previous one and the later value wins.
+      keys[i] = i % 8 == 7 ? keys[i - 1] : i * 3;
+      values[i] = i;
+    }
+    M expected({.allocate = Allocate, .deallocate = Deallocate, .user_context = &user_context,});
+    expected.insert_bulk(keys.data(), values.data(), entry_num);
+    M hash_map({.allocate = Allocate, .deallocate = Deallocate, .user_context = &user_context,});
+    hash_map[1] = 1;
+    hash_map.insert_bulk(keys.data(), values.data(), entry_num, task_callbacks);
+    if (hash_map.size() != expected.size() + 1) { mismatch++; }
+    for (const auto [key, value] : expected) {
+      const auto found = hash_map.find(key);
+      if (found == nullptr || *found != value) { mismatch++; }
+    }
+    // parallel rehash keeps every entry.
+    hash_map.reserve(hash_map.size() * 3, task_callbacks);
+    if (hash_map.size() != expected.size() + 1) { mismatch++; }
+    for (const auto [key, value] : expected) {
+      const auto found = hash_map.find(key);
+      if (found == nullptr || *found != value) { mismatch++; }
+    }
+    if (!hash_map.contains(1)) { mismatch++; }
+  }
+  if (user_context.alloc_count != user_context.dealloc_count) { mismatch++; }
+  return mismatch;
+}
+} // namespace
+TEST_CASE("parallel bulk insert") {
+  using namespace tote;
+  ThreadTaskDispatcher dispatcher(4);
+  CHECK_EQ(dispatcher.thread_num(), 4);
+  CHECK_EQ((CountParallelBuildMismatch<HashMap<uint32_t, uint32_t, UserContext>>(100000, dispatcher.callbacks())), 0);
+  CHECK_EQ((CountParallelBuildMismatch<HashMap<uint32_t, uint32_t, UserContext, PowerOfTwoCapacity, Hash<uint32_t>, EqualTo<uint32_t>, true>>(100000, dispatcher.callbacks())), 0);
+  CHECK_EQ((CountParallelBuildMismatch<HashMap<uint32_t, uint32_t, UserContext, PrimeNumberCapacity<>, ClusteringHash>>(50000, dispatcher.callbacks())), 0);
+  SerialJobSystem job_system{};
+  TaskCallbacks<SerialJobSystem> task_callbacks {
+    .dispatch = DispatchSerially,
+    .user_context = &job_system,
+    .concurrency = 8,
+  };
+  CHECK_EQ((CountParallelBuildMismatch<HashMap<uint32_t, uint32_t, UserContext>>(100000, task_callbacks)), 0);
+  CHECK_GT(job_system.dispatch_count, 0);
+  CHECK_GT(job_system.task_count, job_system.dispatch_count);
+  // small tables fall back to serial insertion.
+  job_system = {};
+  CHECK_EQ((CountParallelBuildMismatch<HashMap<uint32_t, uint32_t, UserContext>>(100, task_callbacks)), 0);
+  CHECK_EQ(job_system.dispatch_count, 0);
+}
+TEST_CASE("find batch") {
+  using namespace tote;
+  UserContext user_context{};
+  AllocatorCallbacks<UserContext> allocator_callbacks {
+    .allocate = Allocate,
+    .deallocate = Deallocate,
+    .user_context = &user_context,
+  };
+  {
+    HashMap<uint32_t, uint32_t, UserContext> hash_map(allocator_callbacks);
+    HashMap<uint32_t, uint32_t, UserContext, PowerOfTwoCapacity, Hash<uint32_t>, EqualTo<uint32_t>, true> interleaved_hash_map(allocator_callbacks);
+    std::vector<uint32_t> keys(1000);
+    std::vector<uint32_t*> values(keys.size());
+    std::vector<const uint32_t*> interleaved_values(keys.size());
+    for (uint32_t i = 0; i < keys.size(); i++) {
+      keys[i] = i * 7;
+    }
+    hash_map.find_batch(keys.data(), static_cast<uint32_t>(keys.size()), values.data());
+    CHECK_EQ(values[0], nullptr);
+    CHECK_EQ(values[999], nullptr);
+    for (uint32_t i = 0; i < 500; i++) {
+      hash_map[i * 14] = i;
+      interleaved_hash_map[i * 14] = i;
+    }
+    // keys left in the previous table while rehashing are found as well.
+    hash_map.set_rehash_budget(1);
+    hash_map.reserve(4000);
+    CHECK_UNARY(hash_map.is_rehashing());
+    uint32_t mismatch = 0;
+    for (const uint32_t prefetch_distance : {0U, 1U, 16U, 100U}) {
+      hash_map.find_batch(keys.data(), static_cast<uint32_t>(keys.size()), values.data(), prefetch_distance);
+      static_cast<const decltype(interleaved_hash_map)&>(interleaved_hash_map).find_batch(keys.data(), static_cast<uint32_t>(keys.size()), interleaved_values.data(), prefetch_distance);
+      for (uint32_t i = 0; i < keys.size(); i++) {
+        if (values[i] != hash_map.find(keys[i])) { mismatch++; }
+        if (interleaved_values[i] != interleaved_hash_map.find(keys[i])) { mismatch++; }
+        if ((values[i] != nullptr) != (i % 2 == 0)) { mismatch++; }
+        if (values[i] != nullptr && *values[i] != i / 2) { mismatch++; }
+      }
+    }
+    CHECK_EQ(mismatch, 0);
+    *values[2] = 100;
+    CHECK_EQ(hash_map[14], 100);
+  }
+  CHECK_EQ(user_context.alloc_count, user_context.dealloc_count);
+}
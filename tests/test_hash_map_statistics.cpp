@@ -0,0 +1,98 @@
+// the define changes the layout of HashMap, so every HashMap here takes a hash local to this file
+// and never shares an instantiation with translation units built without it.
+#ifndef TOTE_ENABLE_HASH_MAP_STATISTICS
+#define TOTE_ENABLE_HASH_MAP_STATISTICS
+#endif
+#include "tote/hash_map.h"
+#include "test_alloc.inl"
+#include <doctest/doctest.h>
+namespace {
+struct IdentityHash {
+  uint32_t operator()(const uint32_t key) const { return key; }
+};
+struct MixingHash {
+  uint32_t operator()(const uint32_t key) const { return tote::Hash<uint32_t>{}(key); }
+};
+} // namespace
+TEST_CASE("hash map statistics") {
+  using namespace tote;
+  UserContext user_context{};
+  AllocatorCallbacks<UserContext> allocator_callbacks {
+    .allocate = Allocate,
+    .deallocate = Deallocate,
+    .user_context = &user_context,
+  };
+  {
+    HashMap<uint32_t, uint32_t, UserContext, PowerOfTwoCapacity, IdentityHash> hash_map(allocator_callbacks, 16);
+    auto stats = hash_map.stats();
+    CHECK_EQ(stats.size, 0);
+    CHECK_EQ(stats.capacity, 16);
+    CHECK_EQ(stats.max_probe_length, 0);
+    CHECK_EQ(stats.cluster_count, 0);
+    CHECK_EQ(stats.rehash_count, 0);
+    // 0, 1, 2, 16, 32 hash to slot 0-2 and form a cluster of slots 0-4.
+    for (const uint32_t key : {0U, 1U, 2U, 16U, 32U, 10U}) {
+      hash_map[key] = key;
+    }
+    stats = hash_map.stats();
+    CHECK_EQ(stats.size, 6);
+    CHECK_EQ(stats.capacity, 16);
+    CHECK_EQ(stats.load_factor, doctest::Approx(6.0f / 16.0f));
+    CHECK_EQ(stats.max_probe_length, 4);
+    CHECK_EQ(stats.average_probe_length, doctest::Approx(7.0f / 6.0f));
+    CHECK_EQ(stats.probe_length_histogram[0], 4);
+    CHECK_EQ(stats.probe_length_histogram[1], 0);
+    CHECK_EQ(stats.probe_length_histogram[2], 0);
+    CHECK_EQ(stats.probe_length_histogram[3], 1);
+    CHECK_EQ(stats.probe_length_histogram[4], 1);
+    CHECK_EQ(stats.cluster_count, 2);
+    CHECK_EQ(stats.max_cluster_size, 5);
+    CHECK_EQ(stats.average_cluster_size, doctest::Approx(3.0f));
+    CHECK_EQ(stats.rehash_count, 0);
+    CHECK_EQ(stats.rehash_bytes_moved, 0);
+    hash_map.clear();
+    // cluster wrapping around the end of the table is counted once.
+    hash_map[15] = 15;
+    hash_map[31] = 31;
+    hash_map[47] = 47;
+    stats = hash_map.stats();
+    CHECK_EQ(stats.max_probe_length, 2);
+    CHECK_EQ(stats.probe_length_histogram[0], 1);
+    CHECK_EQ(stats.probe_length_histogram[1], 1);
+    CHECK_EQ(stats.probe_length_histogram[2], 1);
+    CHECK_EQ(stats.cluster_count, 1);
+    CHECK_EQ(stats.max_cluster_size, 3);
+  }
+  CHECK_EQ(user_context.alloc_count, user_context.dealloc_count);
+}
+TEST_CASE("hash map statistics rehash") {
+  using namespace tote;
+  UserContext user_context{};
+  AllocatorCallbacks<UserContext> allocator_callbacks {
+    .allocate = Allocate,
+    .deallocate = Deallocate,
+    .user_context = &user_context,
+  };
+  {
+    HashMap<uint32_t, uint64_t, UserContext, PrimeNumberCapacity<>, MixingHash> hash_map(allocator_callbacks);
+    for (uint32_t i = 0; i < 1000; i++) {
+      hash_map[i] = i;
+    }
+    auto stats = hash_map.stats();
+    CHECK_EQ(stats.size, 1000);
+    CHECK_GT(stats.rehash_count, 0);
+    CHECK_EQ(stats.rehash_count, user_context.alloc_count - 1);
+    CHECK_GT(stats.rehash_bytes_moved, 0);
+    CHECK_LT(stats.rehash_bytes_moved, 1000 * (sizeof(uint32_t) + sizeof(uint64_t)) * 2);
+    uint32_t histogram_sum = 0;
+    for (uint32_t i = 0; i < kHashMapProbeHistogramSize; i++) {
+      histogram_sum += stats.probe_length_histogram[i];
+    }
+    CHECK_EQ(histogram_sum, 1000);
+    CHECK_LT(stats.load_factor, 0.65f);
+    auto moved = std::move(hash_map);
+    CHECK_EQ(moved.stats().rehash_count, stats.rehash_count);
+    CHECK_EQ(moved.stats().rehash_bytes_moved, stats.rehash_bytes_moved);
+  }
+  CHECK_EQ(user_context.alloc_count, user_context.dealloc_count);
+}
@@ -0,0 +1,247 @@
+#include <random>
+#include <unordered_map>
+#include "tote/robin_hood_hash_map.h"
+#include "test_alloc.inl"
+#include <doctest/doctest.h>
+namespace {
+struct IdentityHash {
+  uint32_t operator()(const uint32_t key) const { return key; }
+};
+struct ConstantHash {
+  uint32_t operator()(const uint32_t) const { return 7; }
+};
+struct CountingEqual {
+  static inline uint32_t count = 0;
+  bool operator()(const uint32_t a, const uint32_t b) const {
+    count++;
+    return a == b;
+  }
+};
+} // namespace
+TEST_CASE("robin hood hash map") {
+  using namespace tote;
+  UserContext user_context{};
+  AllocatorCallbacks<UserContext> allocator_callbacks {
+    .allocate = Allocate,
+    .deallocate = Deallocate,
+    .user_context = &user_context,
+  };
+  {
+    RobinHoodHashMap<uint32_t, uint32_t, UserContext> hash_map(allocator_callbacks);
+    CHECK_EQ(hash_map.size(), 0);
+    CHECK_EQ(hash_map.capacity(), 16);
+    CHECK_UNARY_FALSE(hash_map.contains(0));
+    hash_map.insert(1, 10);
+    CHECK_EQ(hash_map[1], 10);
+    auto result = hash_map.try_emplace(1, 20);
+    CHECK_UNARY_FALSE(result.inserted);
+    CHECK_EQ(*result.value, 10);
+    result = hash_map.insert_or_assign(1, 30);
+    CHECK_UNARY_FALSE(result.inserted);
+    CHECK_EQ(hash_map[1], 30);
+    result = hash_map.try_emplace(2, 40);
+    CHECK_UNARY(result.inserted);
+    CHECK_EQ(*hash_map.find(2), 40);
+    CHECK_EQ(hash_map.find(3), nullptr);
+    hash_map.erase(1);
+    CHECK_UNARY_FALSE(hash_map.contains(1));
+    CHECK_EQ(hash_map.size(), 1);
+    // runs at 7/8 load before growing.
+    for (uint32_t i = 0; i < 14; i++) {
+      hash_map[i] = i;
+    }
+    CHECK_EQ(hash_map.size(), 14);
+    CHECK_EQ(hash_map.capacity(), 16);
+    hash_map[14] = 14;
+    CHECK_EQ(hash_map.capacity(), 32);
+    const auto& const_hash_map = hash_map;
+    for (uint32_t i = 0; i < 15; i++) {
+      CHECK_EQ(const_hash_map[i], i);
+    }
+    CHECK_EQ(const_hash_map[100], 0);
+    uint32_t sum = 0;
+    for (const auto [key, value] : const_hash_map) {
+      CHECK_EQ(key, value);
+      sum += value;
+    }
+    CHECK_EQ(sum, 14 * 15 / 2);
+    hash_map.iterate<uint32_t>([](uint32_t* s, const uint32_t, uint32_t* value) { *s -= *value; }, &sum);
+    CHECK_EQ(sum, 0);
+    hash_map.release_allocated_buffer();
+    CHECK_EQ(hash_map.capacity(), 0);
+    CHECK_UNARY_FALSE(hash_map.contains(0));
+    CHECK_UNARY(hash_map.begin() == hash_map.end());
+    hash_map[5] = 6;
+    CHECK_EQ(hash_map[5], 6);
+    auto moved = std::move(hash_map);
+    CHECK_EQ(hash_map.capacity(), 0);
+    CHECK_EQ(moved[5], 6);
+  }
+  CHECK_EQ(user_context.alloc_count, user_context.dealloc_count);
+}
+TEST_CASE("robin hood hash map churn") {
+  using namespace tote;
+  UserContext user_context{};
+  AllocatorCallbacks<UserContext> allocator_callbacks {
+    .allocate = Allocate,
+    .deallocate = Deallocate,
+    .user_context = &user_context,
+  };
+  {
+    RobinHoodHashMap<uint32_t, uint32_t, UserContext> hash_map(allocator_callbacks);
+    std::unordered_map<uint32_t, uint32_t> reference;
+    std::mt19937 rng(1);
+    for (uint32_t i = 0; i < 100000; i++) {
+      const auto key = rng() % 2000;
+      if (rng() % 3 == 0) {
+        hash_map.erase(key);
+        reference.erase(key);
+      } else {
+        hash_map[key] = i;
+        reference[key] = i;
+      }
+    }
+    CHECK_EQ(hash_map.size(), reference.size());
+    uint32_t mismatch = 0;
+    for (uint32_t key = 0; key < 2000; key++) {
+      const auto it = reference.find(key);
+      const auto value = hash_map.find(key);
+      if (it == reference.end() ? value != nullptr : (value == nullptr || *value != it->second)) {
+        mismatch++;
+      }
+    }
+    CHECK_EQ(mismatch, 0);
+  }
+  CHECK_EQ(user_context.alloc_count, user_context.dealloc_count);
+}
+TEST_CASE("robin hood hash map clustered keys") {
+  using namespace tote;
+  UserContext user_context{};
+  AllocatorCallbacks<UserContext> allocator_callbacks {
+    .allocate = Allocate,
+    .deallocate = Deallocate,
+    .user_context = &user_context,
+  };
+  {
+    RobinHoodHashMap<uint32_t, uint32_t, UserContext, IdentityHash, CountingEqual> hash_map(allocator_callbacks, 1024);
+    // runs of consecutive keys merge into long clusters at high load.
+    for (uint32_t i = 0; i < 896; i++) {
+      hash_map[(i / 8) * 9 + i % 8] = i;
+    }
+    CHECK_EQ(hash_map.capacity(), 1024);
+    // a miss stops at the first entry closer to its home, which compares few keys.
+    CountingEqual::count = 0;
+    for (uint32_t i = 0; i < 1024; i++) {
+      CHECK_UNARY_FALSE(hash_map.contains(i * 9 + 8));
+    }
+    CHECK_LT(CountingEqual::count, 1024);
+    for (uint32_t i = 0; i < 896; i++) {
+      CHECK_EQ(hash_map[(i / 8) * 9 + i % 8], i);
+    }
+  }
+  CHECK_EQ(user_context.alloc_count, user_context.dealloc_count);
+}
+TEST_CASE("robin hood hash map distance overflow") {
+  using namespace tote;
+  UserContext user_context{};
+  AllocatorCallbacks<UserContext> allocator_callbacks {
+    .allocate = Allocate,
+    .deallocate = Deallocate,
+    .user_context = &user_context,
+  };
+  {
+    RobinHoodHashMap<uint32_t, uint32_t, UserContext, IdentityHash> hash_map(allocator_callbacks, 1024);
+    // every key shares a home slot, so distances saturate a byte without growing the table.
+    for (uint32_t i = 0; i < 600; i++) {
+      hash_map[i * 1024] = i;
+    }
+    CHECK_EQ(hash_map.size(), 600);
+    CHECK_EQ(hash_map.capacity(), 1024);
+    uint32_t mismatch = 0;
+    for (uint32_t i = 0; i < 600; i++) {
+      if (hash_map[i * 1024] != i) { mismatch++; }
+    }
+    CHECK_EQ(mismatch, 0);
+  }
+  CHECK_EQ(user_context.alloc_count, user_context.dealloc_count);
+}
+TEST_CASE("robin hood hash map reserve and bulk insert") {
+  using namespace tote;
+  UserContext user_context{};
+  AllocatorCallbacks<UserContext> allocator_callbacks {
+    .allocate = Allocate,
+    .deallocate = Deallocate,
+    .user_context = &user_context,
+  };
+  {
+    RobinHoodHashMap<uint32_t, uint32_t, UserContext> hash_map(allocator_callbacks);
+    const uint32_t entry_num = 1000;
+    uint32_t keys[entry_num];
+    uint32_t values[entry_num];
+    for (uint32_t i = 0; i < entry_num; i++) {
+      keys[i] = i;
+      values[i] = i * 2;
+    }
+    auto alloc_count = user_context.alloc_count;
+    hash_map.insert_bulk(keys, values, entry_num);
+    CHECK_EQ(user_context.alloc_count, alloc_count + 1);
+    CHECK_EQ(hash_map.size(), entry_num);
+    CHECK_EQ(hash_map.capacity(), 2048);
+    CHECK_EQ(hash_map[999], 1998);
+    hash_map.reserve(1792);
+    CHECK_EQ(hash_map.capacity(), 2048);
+    hash_map.reserve(1793);
+    CHECK_EQ(hash_map.capacity(), 4096);
+    CHECK_EQ(hash_map[999], 1998);
+  }
+  CHECK_EQ(user_context.alloc_count, user_context.dealloc_count);
+}
+TEST_CASE("robin hood hash map colliding hashes") {
+  using namespace tote;
+  UserContext user_context{};
+  AllocatorCallbacks<UserContext> allocator_callbacks {
+    .allocate = Allocate,
+    .deallocate = Deallocate,
+    .user_context = &user_context,
+  };
+  {
+    // growth cannot spread keys sharing a hash, the table grows only by load.
+    RobinHoodHashMap<uint32_t, uint32_t, UserContext, ConstantHash> hash_map(allocator_callbacks);
+    for (uint32_t i = 0; i < 300; i++) {
+      hash_map[i] = i * 2;
+    }
+    CHECK_EQ(hash_map.size(), 300);
+    CHECK_EQ(hash_map.capacity(), 512);
+    CHECK_EQ(user_context.alloc_count, 6);
+    uint32_t mismatch = 0;
+    for (uint32_t i = 0; i < 300; i++) {
+      if (hash_map[i] != i * 2) { mismatch++; }
+    }
+    CHECK_EQ(mismatch, 0);
+    CHECK_UNARY_FALSE(hash_map.contains(300));
+    // erase shifts entries across the saturated distance.
+    for (uint32_t i = 0; i < 300; i += 2) {
+      hash_map.erase(i);
+    }
+    CHECK_EQ(hash_map.size(), 150);
+    for (uint32_t i = 0; i < 300; i++) {
+      if (hash_map.contains(i) != (i % 2 == 1)) { mismatch++; }
+    }
+    CHECK_EQ(mismatch, 0);
+    uint32_t keys[300];
+    uint32_t values[300];
+    for (uint32_t i = 0; i < 300; i++) {
+      keys[i] = i + 1000;
+      values[i] = i;
+    }
+    const auto alloc_count = user_context.alloc_count;
+    hash_map.insert_bulk(keys, values, 300);
+    CHECK_EQ(user_context.alloc_count, alloc_count + 1);
+    CHECK_EQ(hash_map.capacity(), 1024);
+    CHECK_EQ(hash_map.size(), 450);
+    CHECK_EQ(hash_map[1299], 299);
+    CHECK_EQ(hash_map[299], 598);
+  }
+  CHECK_EQ(user_context.alloc_count, user_context.dealloc_count);
+  CHECK_UNARY(user_context.ptr.empty());
+}
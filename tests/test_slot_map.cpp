@@ -0,0 +1,137 @@
+#include <string>
+#include <vector>
+#include "tote/slot_map.h"
+#include "test_alloc.inl"
+#include <doctest/doctest.h>
+TEST_CASE("slot map") {
+  using namespace tote;
+  UserContext user_context{};
+  AllocatorCallbacks<UserContext> allocator_callbacks {
+    .allocate = Allocate,
+    .deallocate = Deallocate,
+    .user_context = &user_context,
+  };
+  {
+    SlotMap<uint32_t, UserContext> slot_map(allocator_callbacks);
+    CHECK_UNARY(slot_map.empty());
+    CHECK_UNARY_FALSE(SlotMapHandle32{});
+    CHECK_EQ(slot_map.find(SlotMapHandle32{}), nullptr);
+    const auto a = slot_map.insert(10);
+    const auto b = slot_map.insert(20);
+    const auto c = slot_map.insert(30);
+    CHECK_UNARY(a);
+    CHECK_NE(a, b);
+    CHECK_EQ(slot_map.size(), 3);
+    CHECK_EQ(*slot_map.find(a), 10);
+    CHECK_EQ(*slot_map.find(b), 20);
+    CHECK_EQ(*slot_map.find(c), 30);
+    // erase moves the last value into the hole, handles stay valid.
+    CHECK_UNARY(slot_map.erase(a));
+    CHECK_UNARY_FALSE(slot_map.erase(a));
+    CHECK_UNARY_FALSE(slot_map.contains(a));
+    CHECK_EQ(slot_map.size(), 2);
+    CHECK_EQ(slot_map[0], 30);
+    CHECK_EQ(*slot_map.find(b), 20);
+    CHECK_EQ(*slot_map.find(c), 30);
+    CHECK_EQ(slot_map.get_handle(0), c);
+    // slot is reused with a new generation.
+    const auto d = slot_map.insert(40);
+    CHECK_EQ(d.index(), a.index());
+    CHECK_NE(d.generation(), a.generation());
+    CHECK_EQ(slot_map.find(a), nullptr);
+    CHECK_EQ(*slot_map.find(d), 40);
+    uint32_t sum = 0;
+    for (const auto value : slot_map) {
+      sum += value;
+    }
+    CHECK_EQ(sum, 90);
+    *slot_map.find(d) = 41;
+    CHECK_EQ(*slot_map.find(d), 41);
+    slot_map.clear();
+    CHECK_UNARY(slot_map.empty());
+    CHECK_UNARY_FALSE(slot_map.contains(b));
+    CHECK_UNARY_FALSE(slot_map.contains(c));
+    CHECK_UNARY_FALSE(slot_map.contains(d));
+    const auto e = slot_map.insert(50);
+    CHECK_LT(e.index(), 3);
+    CHECK_EQ(*slot_map.find(e), 50);
+    auto slot_map_b = std::move(slot_map);
+    CHECK_UNARY(slot_map.empty());
+    CHECK_UNARY_FALSE(slot_map.contains(e));
+    CHECK_EQ(*slot_map_b.find(e), 50);
+  }
+  CHECK_EQ(user_context.alloc_count, user_context.dealloc_count);
+  CHECK_UNARY(user_context.ptr.empty());
+}
+TEST_CASE("slot map generation and capacity") {
+  using namespace tote;
+  UserContext user_context{};
+  AllocatorCallbacks<UserContext> allocator_callbacks {
+    .allocate = Allocate,
+    .deallocate = Deallocate,
+    .user_context = &user_context,
+  };
+  {
+    // generation wraps around skipping zero.
+    SlotMap<uint32_t, UserContext, SlotMapHandle<uint32_t, 30>> slot_map(allocator_callbacks);
+    auto handle = slot_map.insert(0);
+    const auto first = handle;
+    uint32_t reused = 0;
+    for (uint32_t i = 0; i < 3; i++) {
+      slot_map.erase(handle);
+      handle = slot_map.insert(i);
+      if (handle == first) { reused++; }
+      CHECK_NE(handle.generation(), 0);
+    }
+    CHECK_EQ(reused, 1);
+    // slots are exhausted with 2 index bits.
+    SlotMap<uint32_t, UserContext, SlotMapHandle<uint8_t, 2>> small_slot_map(allocator_callbacks);
+    for (uint32_t i = 0; i < 4; i++) {
+      CHECK_UNARY(small_slot_map.insert(i));
+    }
+    CHECK_UNARY_FALSE(small_slot_map.insert(4));
+    CHECK_EQ(small_slot_map.size(), 4);
+    // generations of narrow words wrap within the bits left in the word.
+    using SlotMapHandle8 = SlotMapHandle<uint8_t, 2>;
+    using SlotMapHandle16 = SlotMapHandle<uint16_t, 10>;
+    using SlotMapHandle64Wide = SlotMapHandle<uint64_t, 20>;
+    CHECK_EQ(SlotMapHandle8::kGenerationMask, 63);
+    CHECK_EQ(SlotMapHandle16::kGenerationMask, 63);
+    CHECK_EQ(SlotMapHandle32::kGenerationMask, 4095);
+    CHECK_EQ(SlotMapHandle64::kGenerationMask, ~0U);
+    CHECK_EQ(SlotMapHandle64Wide::kGenerationMask, ~0U);
+    auto small_handle = small_slot_map.get_handle(0);
+    uint32_t unreachable = 0;
+    for (uint32_t i = 0; i < 200; i++) {
+      small_slot_map.erase(small_handle);
+      small_handle = small_slot_map.insert(i);
+      const auto value = small_slot_map.find(small_handle);
+      if (!small_handle || value == nullptr || *value != i) { unreachable++; }
+    }
+    CHECK_EQ(unreachable, 0);
+    CHECK_EQ(small_slot_map.size(), 4);
+  }
+  {
+    SlotMap<std::string, UserContext, SlotMapHandle64> slot_map(allocator_callbacks, 16);
+    std::vector<SlotMapHandle64> handles;
+    for (uint32_t i = 0; i < 1000; i++) {
+      handles.push_back(slot_map.emplace(std::to_string(i)));
+    }
+    uint32_t mismatch = 0;
+    for (uint32_t i = 0; i < 1000; i += 3) {
+      if (!slot_map.erase(handles[i])) { mismatch++; }
+    }
+    for (uint32_t i = 0; i < 1000; i++) {
+      const auto value = slot_map.find(handles[i]);
+      if ((value == nullptr) != (i % 3 == 0)) { mismatch++; }
+      if (value != nullptr && *value != std::to_string(i)) { mismatch++; }
+    }
+    for (uint32_t i = 0; i < slot_map.size(); i++) {
+      if (slot_map.find(slot_map.get_handle(i)) != &slot_map[i]) { mismatch++; }
+    }
+    CHECK_EQ(mismatch, 0);
+    CHECK_EQ(slot_map.size(), 666);
+  }
+  CHECK_EQ(user_context.alloc_count, user_context.dealloc_count);
+  CHECK_UNARY(user_context.ptr.empty());
+}
@@ -0,0 +1,86 @@
+#include "tote/soa_array.h"
+#include "test_alloc.inl"
+#include <doctest/doctest.h>
+namespace {
+struct Vec3 {
+  float x, y, z;
+};
+} // namespace
+TEST_CASE("soa array") {
+  using namespace tote;
+  UserContext user_context{};
+  AllocatorCallbacks<UserContext> allocator_callbacks {
+    .allocate = Allocate,
+    .deallocate = Deallocate,
+    .user_context = &user_context,
+  };
+  {
+    SoAArray<UserContext, Vec3, float, uint8_t> soa_array(allocator_callbacks);
+    CHECK_UNARY(soa_array.empty());
+    CHECK_EQ(soa_array.capacity(), 0);
+    CHECK_EQ(soa_array.push_back({1.0f, 2.0f, 3.0f}, 0.5f, 1), 0);
+    CHECK_EQ(soa_array.push_back({4.0f, 5.0f, 6.0f}, 1.5f, 2), 1);
+    CHECK_EQ(soa_array.size(), 2);
+    CHECK_EQ(soa_array.get<0>(1).y, 5.0f);
+    CHECK_EQ(soa_array.get<1>(0), 0.5f);
+    CHECK_EQ(soa_array.get<2>(1), 2);
+    for (uint32_t i = 2; i < 100; i++) {
+      soa_array.push_back({static_cast<float>(i), 0.0f, 0.0f}, static_cast<float>(i), static_cast<uint8_t>(i));
+    }
+    // element of itself as an argument while growing.
+    while (soa_array.size() < soa_array.capacity()) {
+      soa_array.push_back(soa_array.get<0>(0), soa_array.get<1>(0), soa_array.get<2>(0));
+    }
+    soa_array.push_back(soa_array.get<0>(1), soa_array.get<1>(1), soa_array.get<2>(1));
+    CHECK_EQ(soa_array.get<0>(soa_array.size() - 1).z, 6.0f);
+    CHECK_EQ(soa_array.get<2>(soa_array.size() - 1), 2);
+    // each column is contiguous and starts at a cache line.
+    const auto positions = soa_array.column<0>();
+    const auto weights = soa_array.column<1>();
+    const auto flags = soa_array.column<2>();
+    CHECK_EQ(positions.size(), soa_array.size());
+    CHECK_EQ(reinterpret_cast<uintptr_t>(positions.data()) % 64, 0);
+    CHECK_EQ(reinterpret_cast<uintptr_t>(weights.data()) % 64, 0);
+    CHECK_EQ(reinterpret_cast<uintptr_t>(flags.data()) % 64, 0);
+    CHECK_GE(reinterpret_cast<const uint8_t*>(weights.data()), reinterpret_cast<const uint8_t*>(positions.data() + soa_array.capacity()));
+    CHECK_GE(reinterpret_cast<const uint8_t*>(flags.data()), reinterpret_cast<const uint8_t*>(weights.data() + soa_array.capacity()));
+    float sum = 0.0f;
+    for (const auto weight : soa_array.column<1>().subspan(2, 98)) {
+      sum += weight;
+    }
+    CHECK_EQ(sum, static_cast<float>((2 + 99) * 98 / 2));
+    for (auto& weight : soa_array.column<1>()) {
+      weight *= 2.0f;
+    }
+    CHECK_EQ(soa_array.get<1>(10), 20.0f);
+    soa_array.erase_unordered(0);
+    CHECK_EQ(soa_array.get<0>(0).y, 5.0f);
+    CHECK_EQ(soa_array.get<2>(0), 2);
+    const auto size = soa_array.size();
+    soa_array.resize(size + 10);
+    CHECK_EQ(soa_array.get<1>(size + 9), 0.0f);
+    CHECK_EQ(soa_array.get<2>(size + 9), 0);
+    soa_array.resize(3);
+    CHECK_EQ(soa_array.size(), 3);
+    auto soa_array_b = std::move(soa_array);
+    CHECK_UNARY(soa_array.empty());
+    CHECK_EQ(soa_array.capacity(), 0);
+    CHECK_EQ(soa_array_b.size(), 3);
+    CHECK_EQ(soa_array_b.get<1>(2), 4.0f);
+    const auto& const_soa_array = soa_array_b;
+    CHECK_EQ(const_soa_array.column<2>()[1], 2);
+    SoAArray<UserContext, uint32_t, uint64_t> soa_array_c(allocator_callbacks, 5, 16);
+    CHECK_EQ(soa_array_c.size(), 5);
+    CHECK_EQ(soa_array_c.capacity(), 16);
+    CHECK_EQ(soa_array_c.get<1>(4), 0);
+    // growing one element at a time reallocates geometrically.
+    const auto alloc_count = user_context.alloc_count;
+    for (uint32_t i = 0; i < 1000; i++) {
+      soa_array_c.resize(soa_array_c.size() + 1);
+    }
+    CHECK_EQ(soa_array_c.size(), 1005);
+    CHECK_LT(user_context.alloc_count - alloc_count, 12);
+  }
+  CHECK_EQ(user_context.alloc_count, user_context.dealloc_count);
+  CHECK_UNARY(user_context.ptr.empty());
+}
@@ -0,0 +1,330 @@
+#include "tote/swiss_hash_map.h"
+#include "test_alloc.inl"
+#include <doctest/doctest.h>
+TEST_CASE("swiss group") {
+  using namespace tote;
+  alignas(kSwissGroupWidth) int8_t ctrl[kSwissGroupWidth];
+  memset(ctrl, kSwissCtrlEmpty, sizeof(ctrl));
+  ctrl[1] = 5;
+  ctrl[3] = kSwissCtrlDeleted;
+  ctrl[7] = 5;
+  ctrl[15] = 0x7F;
+  SwissGroup group(ctrl);
+  auto mask = group.match(5);
+  CHECK_UNARY(static_cast<bool>(mask));
+  CHECK_EQ(mask.lowest(), 1);
+  mask.clear_lowest();
+  CHECK_EQ(mask.lowest(), 7);
+  mask.clear_lowest();
+  CHECK_UNARY_FALSE(static_cast<bool>(mask));
+  CHECK_UNARY_FALSE(static_cast<bool>(group.match(6)));
+  CHECK_EQ(group.match_empty().lowest(), 0);
+  mask = group.match_full();
+  CHECK_EQ(mask.lowest(), 1);
+  mask.clear_lowest();
+  CHECK_EQ(mask.lowest(), 7);
+  mask.clear_lowest();
+  CHECK_EQ(mask.lowest(), 15);
+  mask.clear_lowest();
+  CHECK_UNARY_FALSE(static_cast<bool>(mask));
+  memset(ctrl, 0, sizeof(ctrl));
+  ctrl[3] = kSwissCtrlDeleted;
+  ctrl[9] = kSwissCtrlEmpty;
+  SwissGroup group2(ctrl);
+  CHECK_EQ(group2.match_empty().lowest(), 9);
+  mask = group2.match_empty_or_deleted();
+  CHECK_EQ(mask.lowest(), 3);
+  mask.clear_lowest();
+  CHECK_EQ(mask.lowest(), 9);
+  mask.clear_lowest();
+  CHECK_UNARY_FALSE(static_cast<bool>(mask));
+}
+TEST_CASE("swiss hash map") {
+  using namespace tote;
+  UserContext user_context{};
+  AllocatorCallbacks<UserContext> allocator_callbacks {
+    .allocate = Allocate,
+    .deallocate = Deallocate,
+    .user_context = &user_context,
+  };
+  {
+    SwissHashMap<uint32_t, uint32_t, UserContext> hash_map(allocator_callbacks, 5);
+    CHECK_UNARY(hash_map.empty());
+    CHECK_EQ(hash_map.size(), 0);
+    CHECK_EQ(hash_map.capacity(), kSwissGroupWidth);
+    CHECK_UNARY_FALSE(hash_map.contains(0));
+    hash_map.insert(0, 1);
+    CHECK_UNARY_FALSE(hash_map.empty());
+    CHECK_UNARY(hash_map.contains(0));
+    CHECK_EQ(hash_map.size(), 1);
+    CHECK_EQ(hash_map[0], 1);
+    hash_map.insert(0, 2);
+    CHECK_EQ(hash_map.size(), 1);
+    CHECK_EQ(hash_map[0], 2);
+    hash_map[1] = 3;
+    CHECK_EQ(hash_map.size(), 2);
+    CHECK_EQ(hash_map[1], 3);
+    hash_map.erase(0);
+    CHECK_EQ(hash_map.size(), 1);
+    CHECK_UNARY_FALSE(hash_map.contains(0));
+    CHECK_UNARY(hash_map.contains(1));
+    hash_map.erase(0);
+    CHECK_EQ(hash_map.size(), 1);
+    for (uint32_t i = 0; i < 1000; i++) {
+      hash_map.insert(i, i + 100);
+    }
+    CHECK_EQ(hash_map.size(), 1000);
+    CHECK_GT(hash_map.capacity(), 1000);
+    CHECK_LE(hash_map.capacity(), 2048);
+    for (uint32_t i = 0; i < 1000; i++) {
+      CHECK_EQ(hash_map[i], i + 100);
+    }
+    for (uint32_t i = 0; i < 1000; i += 2) {
+      hash_map.erase(i);
+    }
+    CHECK_EQ(hash_map.size(), 500);
+    for (uint32_t i = 0; i < 1000; i++) {
+      CHECK_EQ(hash_map.contains(i), i % 2 == 1);
+    }
+    struct Entity {
+      uint32_t count = 0;
+      uint32_t key_sum = 0;
+    } entity {};
+    hash_map.iterate<Entity>([](Entity* data, const uint32_t key, uint32_t* value) {
+      data->count++;
+      data->key_sum += key;
+      *value = key;
+    }, &entity);
+    CHECK_EQ(entity.count, 500);
+    CHECK_EQ(entity.key_sum, 250000);
+    CHECK_EQ(hash_map[999], 999);
+    auto capacity = hash_map.capacity();
+    hash_map.clear();
+    CHECK_UNARY(hash_map.empty());
+    CHECK_EQ(hash_map.capacity(), capacity);
+    CHECK_UNARY_FALSE(hash_map.contains(1));
+    hash_map.release_allocated_buffer();
+    CHECK_EQ(hash_map.capacity(), 0);
+    CHECK_UNARY_FALSE(hash_map.contains(1));
+    hash_map.insert(1, 2);
+    CHECK_EQ(hash_map.size(), 1);
+    CHECK_EQ(hash_map[1], 2);
+  }
+  CHECK_EQ(user_context.alloc_count, user_context.dealloc_count);
+  CHECK_UNARY(user_context.ptr.empty());
+}
+TEST_CASE("swiss hash map churn") {
+  using namespace tote;
+  UserContext user_context{};
+  AllocatorCallbacks<UserContext> allocator_callbacks {
+    .allocate = Allocate,
+    .deallocate = Deallocate,
+    .user_context = &user_context,
+  };
+  SwissHashMap<uint64_t, uint32_t, UserContext> hash_map(allocator_callbacks, 64);
+  // erase-heavy churn leaves deleted slots, which are purged without growing.
+  for (uint32_t i = 0; i < 10000; i++) {
+    hash_map.insert(static_cast<uint64_t>(i) << 32, i);
+    if (i >= 8) {
+      hash_map.erase(static_cast<uint64_t>(i - 8) << 32);
+    }
+    CHECK_EQ(hash_map.size(), i >= 8 ? 8 : i + 1);
+  }
+  CHECK_EQ(hash_map.capacity(), 64);
+  for (uint32_t i = 10000 - 8; i < 10000; i++) {
+    CHECK_EQ(hash_map[static_cast<uint64_t>(i) << 32], i);
+  }
+  CHECK_UNARY_FALSE(hash_map.contains(0));
+}
+TEST_CASE("swiss hash map move") {
+  using namespace tote;
+  UserContext user_context{};
+  {
+    SwissHashMap<uint32_t, uint32_t, UserContext> hash_map_a({.allocate = Allocate, .deallocate = Deallocate, .user_context = &user_context,});
+    hash_map_a.insert(0, 1);
+    hash_map_a.insert(1, 2);
+    const auto alloc_count = user_context.alloc_count;
+    auto hash_map_b = std::move(hash_map_a);
+    CHECK_EQ(hash_map_a.size(), 0);
+    CHECK_EQ(hash_map_a.capacity(), 0);
+    CHECK_UNARY_FALSE(hash_map_a.contains(0));
+    CHECK_EQ(hash_map_b.size(), 2);
+    CHECK_EQ(hash_map_b[0], 1);
+    CHECK_EQ(hash_map_b[1], 2);
+    UserContext user_context2{};
+    SwissHashMap<uint32_t, uint32_t, UserContext> hash_map_c({.allocate = Allocate, .deallocate = Deallocate, .user_context = &user_context2,});
+    hash_map_c.insert(100, 101);
+    hash_map_c = std::move(hash_map_b);
+    CHECK_EQ(hash_map_b.size(), 0);
+    CHECK_EQ(hash_map_c.size(), 2);
+    CHECK_UNARY_FALSE(hash_map_c.contains(100));
+    CHECK_EQ(hash_map_c[1], 2);
+    CHECK_EQ(user_context.alloc_count, alloc_count);
+    CHECK_EQ(user_context2.alloc_count, user_context2.dealloc_count);
+  }
+  CHECK_EQ(user_context.alloc_count, user_context.dealloc_count);
+  CHECK_UNARY(user_context.ptr.empty());
+}
+namespace {
+struct CountingHash {
+  static inline uint32_t count = 0;
+  uint32_t operator()(const uint32_t key) const {
+    count++;
+    return tote::Hash<uint32_t>{}(key);
+  }
+};
+} // namespace
+TEST_CASE("swiss hash map single probe find and insert") {
+  using namespace tote;
+  UserContext user_context{};
+  AllocatorCallbacks<UserContext> allocator_callbacks {
+    .allocate = Allocate,
+    .deallocate = Deallocate,
+    .user_context = &user_context,
+  };
+  SwissHashMap<uint32_t, uint32_t, UserContext, CountingHash> hash_map(allocator_callbacks, 100);
+  CHECK_EQ(hash_map.find(1), nullptr);
+  CountingHash::count = 0;
+  auto result = hash_map.try_emplace(1, 2U);
+  CHECK_UNARY(result.inserted);
+  CHECK_EQ(*result.value, 2);
+  CHECK_EQ(CountingHash::count, 1);
+  result = hash_map.try_emplace(1, 3U);
+  CHECK_UNARY_FALSE(result.inserted);
+  CHECK_EQ(*result.value, 2);
+  result = hash_map.insert_or_assign(1, 4);
+  CHECK_UNARY_FALSE(result.inserted);
+  CHECK_EQ(*result.value, 4);
+  result = hash_map.insert_or_assign(2, 5);
+  CHECK_UNARY(result.inserted);
+  CHECK_EQ(CountingHash::count, 4);
+  hash_map[3] = 6;
+  hash_map[3]++;
+  CHECK_EQ(CountingHash::count, 6);
+  CHECK_EQ(*hash_map.find(3), 7);
+  CHECK_EQ(hash_map.size(), 3);
+  const auto& const_hash_map = hash_map;
+  CHECK_EQ(const_hash_map[3], 7);
+  CHECK_EQ(const_hash_map[4], 0);
+  CHECK_EQ(const_hash_map.find(4), nullptr);
+  CHECK_EQ(hash_map.size(), 3);
+}
+namespace {
+struct IdentityHash {
+  uint32_t operator()(const uint32_t key) const { return key; }
+};
+} // namespace
+TEST_CASE("swiss hash map 32 bit hash") {
+  using namespace tote;
+  UserContext user_context{};
+  AllocatorCallbacks<UserContext> allocator_callbacks {
+    .allocate = Allocate,
+    .deallocate = Deallocate,
+    .user_context = &user_context,
+  };
+  {
+    // keys differing only in the bits once shared by h2 and the group are widened apart.
+    const auto make_key = [](const uint32_t i) { return (i & 0x7F) | (i >> 7) << 25; };
+    SwissHashMap<uint32_t, uint32_t, UserContext, IdentityHash> hash_map(allocator_callbacks);
+    for (uint32_t i = 0; i < 1000; i++) {
+      hash_map.insert(make_key(i), i);
+    }
+    CHECK_EQ(hash_map.size(), 1000);
+    for (uint32_t i = 0; i < 1000; i++) {
+      CHECK_EQ(hash_map[make_key(i)], i);
+    }
+    for (uint32_t i = 0; i < 1000; i += 2) {
+      hash_map.erase(make_key(i));
+    }
+    CHECK_EQ(hash_map.size(), 500);
+    for (uint32_t i = 0; i < 1000; i++) {
+      CHECK_EQ(hash_map.contains(make_key(i)), i % 2 == 1);
+    }
+  }
+  CHECK_EQ(user_context.alloc_count, user_context.dealloc_count);
+  CHECK_UNARY(user_context.ptr.empty());
+}
+TEST_CASE("swiss hash map reserve and bulk insert") {
+  using namespace tote;
+  UserContext user_context{};
+  AllocatorCallbacks<UserContext> allocator_callbacks {
+    .allocate = Allocate,
+    .deallocate = Deallocate,
+    .user_context = &user_context,
+  };
+  const uint32_t entry_num = 1000;
+  SwissHashMap<uint32_t, uint32_t, UserContext> hash_map(allocator_callbacks);
+  hash_map.reserve(entry_num);
+  CHECK_EQ(hash_map.capacity(), 2048);
+  auto alloc_count = user_context.alloc_count;
+  for (uint32_t i = 0; i < entry_num; i++) {
+    hash_map.insert(i, i);
+  }
+  CHECK_EQ(user_context.alloc_count, alloc_count);
+  uint32_t keys[entry_num]{};
+  uint32_t values[entry_num]{};
+  for (uint32_t i = 0; i < entry_num; i++) {
+    keys[i] = i + entry_num / 2;
+    values[i] = i + 1;
+  }
+  hash_map.insert_bulk(keys, values, entry_num);
+  CHECK_EQ(user_context.alloc_count, alloc_count + 1);
+  CHECK_EQ(hash_map.capacity(), 4096);
+  CHECK_EQ(hash_map.size(), entry_num * 3 / 2);
+  CHECK_EQ(hash_map[0], 0);
+  CHECK_EQ(hash_map[entry_num / 2], 1);
+  CHECK_EQ(hash_map[entry_num * 3 / 2 - 1], entry_num);
+  SwissHashMap<uint32_t, uint32_t, UserContext> hash_map_b(allocator_callbacks);
+  alloc_count = user_context.alloc_count;
+  hash_map_b.insert_bulk(keys, values, entry_num);
+  CHECK_EQ(user_context.alloc_count, alloc_count + 1);
+  CHECK_EQ(hash_map_b.size(), entry_num);
+  CHECK_EQ(hash_map_b[entry_num / 2], 1);
+}
+TEST_CASE("swiss hash map for each and iterator") {
+  using namespace tote;
+  UserContext user_context{};
+  AllocatorCallbacks<UserContext> allocator_callbacks {
+    .allocate = Allocate,
+    .deallocate = Deallocate,
+    .user_context = &user_context,
+  };
+  {
+    SwissHashMap<uint32_t, uint32_t, UserContext> hash_map(allocator_callbacks);
+    CHECK_UNARY(hash_map.begin() == hash_map.end());
+    hash_map.reserve(1000);
+    uint32_t key_sum = 0;
+    for (uint32_t i = 0; i < 20; i++) {
+      hash_map[i * 101] = i;
+      key_sum += i * 101;
+    }
+    // deleted slots are skipped as well as empty ones.
+    for (uint32_t i = 0; i < 20; i += 2) {
+      hash_map.erase(i * 101);
+      key_sum -= i * 101;
+    }
+    uint32_t count = 0;
+    uint32_t sum = 0;
+    hash_map.for_each([&](const uint32_t& key, uint32_t& value) {
+      CHECK_EQ(key, value * 101);
+      count++;
+      sum += key;
+      value = key;
+    });
+    CHECK_EQ(count, 10);
+    CHECK_EQ(sum, key_sum);
+    const auto& const_hash_map = hash_map;
+    count = 0;
+    sum = 0;
+    for (const auto [key, value] : const_hash_map) {
+      CHECK_EQ(value, key);
+      count++;
+      sum += key;
+    }
+    CHECK_EQ(count, 10);
+    CHECK_EQ(sum, key_sum);
+    hash_map.release_allocated_buffer();
+    CHECK_UNARY(hash_map.begin() == hash_map.end());
+  }
+  CHECK_EQ(user_context.alloc_count, user_context.dealloc_count);
+}